@@ -0,0 +1,387 @@
+// Microbenchmarks for the GERGM core on synthetic networks, without R:
+//
+//   gergm_benchmarks [--sizes=10,25,50,100,200,400] [--min-time=0.5]
+//     [--iterations=100] [--max-mple-nodes=25] [--output=benchmarks.json]
+//
+// The cases and JSON output are those of inst/benchmarks/run_benchmarks.R,
+// which now only times the samplers that are not part of the core. Each
+// statistic kernel, the partial correlation transform and its Jacobian, the
+// weighted MPLE objective, and single iteration and --iterations iteration
+// runs of the Metropolis Hastings and Gibbs samplers are run with
+// together = 0 and 1, on directed and undirected networks, and with parallel
+// on and off where the function has a parallel option. Each result records
+// the mean time per call (ns_per_op), calls per second, dyads processed per
+// second and the peak resident set size of the process so far (null where
+// getrusage() is not available). Results are written as JSON to --output, or
+// to standard output if it is not given.
+
+#include <gergm/gergm.h>
+
+#include "node_combinations.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#define GERGM_HAVE_GETRUSAGE
+#endif
+
+struct Settings {
+  std::vector<int> sizes;
+  double min_time;
+  int iterations;
+  int max_mple_nodes;
+  std::string output;
+};
+
+struct Timing {
+  double ns_per_op;
+  long repetitions;
+};
+
+struct Result {
+  std::string benchmark;
+  int n;
+  int together;
+  bool directed;
+  bool parallel;
+  // 0 for cases that are not sampler runs
+  int iterations;
+  Timing timing;
+  double peak_rss_bytes;
+};
+
+bool parse_arguments(int argc, char** argv, Settings& settings) {
+  int default_sizes[] = {10, 25, 50, 100, 200, 400};
+  settings.sizes.assign(default_sizes, default_sizes + 6);
+  settings.min_time = 0.5;
+  settings.iterations = 100;
+  settings.max_mple_nodes = 25;
+  for (int a = 1; a < argc; ++a) {
+    std::string arg = argv[a];
+    std::string::size_type equals = arg.find('=');
+    std::string name = arg.substr(0, equals);
+    std::string value = equals == std::string::npos ? "" :
+      arg.substr(equals + 1);
+    if (name == "--sizes") {
+      settings.sizes.clear();
+      std::stringstream sizes(value);
+      std::string size;
+      while (std::getline(sizes, size, ',')) {
+        settings.sizes.push_back(std::atoi(size.c_str()));
+      }
+    } else if (name == "--min-time") {
+      settings.min_time = std::atof(value.c_str());
+    } else if (name == "--iterations") {
+      settings.iterations = std::atoi(value.c_str());
+    } else if (name == "--max-mple-nodes") {
+      settings.max_mple_nodes = std::atoi(value.c_str());
+    } else if (name == "--output") {
+      settings.output = value;
+    } else {
+      std::fprintf(stderr, "Unknown argument: %s\n", arg.c_str());
+      return false;
+    }
+  }
+  for (std::size_t i = 0; i < settings.sizes.size(); ++i) {
+    if (settings.sizes[i] < 3) {
+      std::fprintf(stderr, "Network sizes must be at least 3\n");
+      return false;
+    }
+  }
+  if (settings.iterations < 1) {
+    std::fprintf(stderr, "--iterations must be at least 1\n");
+    return false;
+  }
+  return true;
+}
+
+// Peak resident set size in bytes, or -1 if it is not available.
+double peak_rss_bytes() {
+#ifdef GERGM_HAVE_GETRUSAGE
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return -1;
+  }
+#ifdef __APPLE__
+  return double(usage.ru_maxrss);
+#else
+  return double(usage.ru_maxrss) * 1024;
+#endif
+#else
+  return -1;
+#endif
+}
+
+// Mean wall clock nanoseconds per call of operation(). Calls are made in
+// doubling batches until min_time seconds have been spent, after one warm up
+// call. Operations slower than min_time are only timed once.
+Timing time_operation(const std::function<void()>& operation,
+                      double min_time) {
+  typedef std::chrono::steady_clock clock;
+  clock::time_point start = clock::now();
+  operation();
+  double warm_up = std::chrono::duration<double>(clock::now() - start).count();
+  Timing timing;
+  if (warm_up >= min_time) {
+    timing.ns_per_op = warm_up * 1e9;
+    timing.repetitions = 1;
+    return timing;
+  }
+  long repetitions = 0;
+  double elapsed = 0;
+  long batch = 1;
+  while (elapsed < min_time) {
+    start = clock::now();
+    for (long r = 0; r < batch; ++r) {
+      operation();
+    }
+    elapsed += std::chrono::duration<double>(clock::now() - start).count();
+    repetitions += batch;
+    batch *= 2;
+  }
+  timing.ns_per_op = elapsed / repetitions * 1e9;
+  timing.repetitions = repetitions;
+  return timing;
+}
+
+arma::mat synthetic_network(int n, bool directed, std::mt19937& generator) {
+  std::uniform_real_distribution<double> uniform(0, 1);
+  arma::mat net(n, n);
+  for (int j = 0; j < n; ++j) {
+    for (int i = 0; i < n; ++i) {
+      net(i, j) = uniform(generator);
+    }
+  }
+  if (!directed) {
+    net = arma::symmatl(net);
+  }
+  net.diag().zeros();
+  return net;
+}
+
+// A model of base statistics only, on all of the nodes.
+gergm::GergmModel base_statistic_model(int n,
+                                       const arma::vec& statistics,
+                                       const arma::vec& alphas,
+                                       int together,
+                                       int undirect_network) {
+  int k = statistics.n_elem;
+  return gergm::GergmModel(n,
+                           statistics,
+                           node_combinations(n, 3),
+                           node_combinations(n, 2),
+                           alphas,
+                           together,
+                           0,
+                           undirect_network,
+                           arma::umat(2, k, arma::fill::zeros),
+                           arma::umat(2, k, arma::fill::zeros),
+                           arma::zeros(k),
+                           statistics,
+                           alphas,
+                           0,
+                           arma::zeros(k),
+                           1,
+                           1,
+                           false,
+                           false,
+                           false);
+}
+
+void record(std::vector<Result>& results,
+            const std::string& benchmark,
+            int n,
+            int together,
+            bool directed,
+            bool parallel,
+            const Timing& timing,
+            int iterations) {
+  Result result;
+  result.benchmark = benchmark;
+  result.n = n;
+  result.together = together;
+  result.directed = directed;
+  result.parallel = parallel;
+  result.iterations = iterations;
+  result.timing = timing;
+  result.peak_rss_bytes = peak_rss_bytes();
+  results.push_back(result);
+  std::fprintf(stderr,
+               "%-28s n = %4d together = %d directed = %-5s parallel = %-5s %14.0f ns/op\n",
+               benchmark.c_str(), n, together, directed ? "TRUE" : "FALSE",
+               parallel ? "TRUE" : "FALSE", timing.ns_per_op);
+}
+
+std::string json_number(double value) {
+  char buffer[64];
+  std::snprintf(buffer, sizeof(buffer), "%.10g", value);
+  return buffer;
+}
+
+std::string to_json(const Settings& settings,
+                    const std::vector<Result>& results) {
+  std::string json = "{\"implementation\": \"core\", \"min_time_seconds\": " +
+    json_number(settings.min_time) + ", \"results\": [";
+  for (std::size_t r = 0; r < results.size(); ++r) {
+    const Result& result = results[r];
+    double dyads = double(result.n) * (result.n - 1);
+    double ops_per_second = 1e9 / result.timing.ns_per_op;
+    double dyads_per_op = dyads;
+    if (result.iterations > 0) {
+      dyads_per_op = dyads * result.iterations;
+    }
+    json += r == 0 ? "" : ",\n";
+    json += "{\"benchmark\": \"" + result.benchmark + "\"";
+    json += ", \"n\": " + json_number(result.n);
+    json += ", \"together\": " + json_number(result.together);
+    json += std::string(", \"directed\": ") +
+      (result.directed ? "true" : "false");
+    json += std::string(", \"parallel\": ") +
+      (result.parallel ? "true" : "false");
+    json += ", \"iterations\": " + (result.iterations > 0 ?
+      json_number(result.iterations) : std::string("null"));
+    json += ", \"repetitions\": " + json_number(result.timing.repetitions);
+    json += ", \"ns_per_op\": " + json_number(result.timing.ns_per_op);
+    json += ", \"ops_per_second\": " + json_number(ops_per_second);
+    json += ", \"dyads_per_second\": " +
+      json_number(ops_per_second * dyads_per_op);
+    json += ", \"peak_rss_bytes\": " + (result.peak_rss_bytes >= 0 ?
+      json_number(result.peak_rss_bytes) : std::string("null"));
+    json += "}";
+  }
+  json += "]}";
+  return json;
+}
+
+int main(int argc, char** argv) {
+  Settings settings;
+  if (!parse_arguments(argc, argv, settings)) {
+    return 1;
+  }
+  std::mt19937 generator(12345);
+  std::vector<Result> results;
+
+  const char* kernels[] = {"Out2Star", "In2Star", "CTriads", "Recip",
+                           "TTriads", "EdgeDensity"};
+  int iterations = settings.iterations;
+  arma::vec statistics = arma::regspace<arma::vec>(0, 5);
+  arma::vec alphas(6);
+  alphas.fill(0.8);
+  arma::vec thetas(6);
+  thetas[0] = -0.1;
+  thetas[1] = -0.1;
+  thetas[2] = 0.05;
+  thetas[3] = 0.1;
+  thetas[4] = 0.05;
+  thetas[5] = -0.5;
+  arma::vec mple_thetas(6);
+  mple_thetas.fill(0.1);
+  arma::vec integration_interval = arma::linspace<arma::vec>(0, 1, 20);
+
+  for (std::size_t s = 0; s < settings.sizes.size(); ++s) {
+    int n = settings.sizes[s];
+    for (int d = 0; d < 2; ++d) {
+      bool directed = d == 0;
+      arma::mat net = synthetic_network(n, directed, generator);
+      int undirect_network = directed ? 0 : 1;
+      for (int together = 0; together < 2; ++together) {
+
+        // statistic kernels, one statistic per call
+        for (int kernel = 0; kernel < 6; ++kernel) {
+          arma::vec statistic(1);
+          statistic[0] = kernel;
+          arma::vec alpha(1);
+          alpha[0] = 0.8;
+          gergm::GergmModel model = base_statistic_model(
+            n, statistic, alpha, together, undirect_network);
+          Timing timing = time_operation([&]() {
+            model.save_network_statistics(net);
+          }, settings.min_time);
+          record(results, kernels[kernel], n, together, directed, false,
+                 timing, 0);
+        }
+
+        // correlation transforms only apply to undirected networks
+        if (!directed && together == 0) {
+          arma::mat partials = 2 * net - 1;
+          partials.diag().ones();
+          Timing timing = time_operation([&]() {
+            gergm::partials_to_correlations(partials);
+          }, settings.min_time);
+          record(results, "partials_to_correlations", n, together, directed,
+                 false, timing, 0);
+          timing = time_operation([&]() {
+            vine::log_jacobian(partials);
+          }, settings.min_time);
+          record(results, "log_jacobian", n, together, directed, false, timing,
+                 0);
+        }
+
+        gergm::GergmModel model = base_statistic_model(
+          n, statistics, alphas, together, undirect_network);
+        for (int p = 0; p < 2; ++p) {
+          bool parallel = p == 1;
+          if (n <= settings.max_mple_nodes) {
+            Timing timing = time_operation([&]() {
+              gergm::mple_objective(model, mple_thetas, net,
+                                    integration_interval, parallel);
+            }, settings.min_time);
+            record(results, "weighted_mple_objective", n, together, directed,
+                   parallel, timing, 0);
+          }
+
+          std::vector<int> sampler_iterations(1, 1);
+          if (iterations != 1) {
+            sampler_iterations.push_back(iterations);
+          }
+          for (std::size_t i = 0; i < sampler_iterations.size(); ++i) {
+            int run_iterations = sampler_iterations[i];
+            Timing timing = time_operation([&]() {
+              gergm::MetropolisHastingsOutput output;
+              gergm::run_metropolis_hastings(model, run_iterations, 0.1, net,
+                                             run_iterations, thetas, 123, 1,
+                                             parallel, false, output);
+            }, settings.min_time);
+            record(results, "extended_metropolis_hastings", n, together,
+                   directed, parallel, timing, run_iterations);
+
+            // the Gibbs sampler has no parallel option
+            if (!parallel) {
+              timing = time_operation([&]() {
+                gibbs::GibbsOutput output;
+                gibbs::run_gibbs_sampler(run_iterations, n, statistics, net,
+                                         run_iterations, thetas, alphas,
+                                         together, 123, 1, undirect_network,
+                                         output);
+              }, settings.min_time);
+              record(results, "gibbs", n, together, directed, parallel, timing,
+                     run_iterations);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  std::string json = to_json(settings, results);
+  if (settings.output.empty()) {
+    std::printf("%s\n", json.c_str());
+  } else {
+    FILE* file = std::fopen(settings.output.c_str(), "w");
+    if (file == NULL) {
+      std::fprintf(stderr, "Could not write %s\n", settings.output.c_str());
+      return 1;
+    }
+    std::fprintf(file, "%s\n", json.c_str());
+    std::fclose(file);
+  }
+  return 0;
+}
@@ -0,0 +1,41 @@
+#ifndef GERGM_CORE_NODE_COMBINATIONS_H
+#define GERGM_CORE_NODE_COMBINATIONS_H
+
+// Shared by the programs in inst/core: the triples and pairs tables of a
+// model on all of the nodes, as combn() builds them in R.
+
+#include <armadillo>
+#include <vector>
+
+// All unordered triples (or pairs) of nodes, one per row, 0 based.
+inline arma::mat node_combinations(int number_of_nodes, int size) {
+  std::vector<std::vector<int> > rows;
+  std::vector<int> current(size);
+  for (int i = 0; i < size; ++i) {
+    current[i] = i;
+  }
+  while (size <= number_of_nodes) {
+    rows.push_back(current);
+    int position = size - 1;
+    while (position >= 0 &&
+           current[position] == number_of_nodes - size + position) {
+      --position;
+    }
+    if (position < 0) {
+      break;
+    }
+    ++current[position];
+    for (int i = position + 1; i < size; ++i) {
+      current[i] = current[i - 1] + 1;
+    }
+  }
+  arma::mat combinations(rows.size(), size);
+  for (arma::uword r = 0; r < rows.size(); ++r) {
+    for (int c = 0; c < size; ++c) {
+      combinations(r, c) = rows[r][c];
+    }
+  }
+  return combinations;
+}
+
+#endif
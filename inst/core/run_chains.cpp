@@ -0,0 +1,116 @@
+// Runs several Metropolis Hastings chains for one GERGM on separate threads,
+// without R, and prints the mean of each statistic over every chain's
+// samples:
+//
+//   run_chains [number_of_nodes] [number_of_chains] [number_of_iterations]
+//
+// The model is a directed network with all six base statistics, the same
+// specification the package benchmarks use.
+
+#include <gergm/gergm.h>
+
+#include "node_combinations.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+int main(int argc, char** argv) {
+  int number_of_nodes = argc > 1 ? std::atoi(argv[1]) : 10;
+  int number_of_chains = argc > 2 ? std::atoi(argv[2]) : 4;
+  int number_of_iterations = argc > 3 ? std::atoi(argv[3]) : 1000;
+  if (number_of_nodes < 3 || number_of_chains < 1 ||
+      number_of_iterations < 1) {
+    std::fprintf(stderr, "usage: run_chains [nodes >= 3] [chains] [iterations]\n");
+    return 1;
+  }
+
+  int number_of_statistics = 6;
+  arma::vec statistics_to_use = arma::regspace<arma::vec>(0, 5);
+  arma::vec alphas(number_of_statistics);
+  alphas.fill(0.8);
+  arma::vec thetas(number_of_statistics);
+  thetas[0] = -0.1;
+  thetas[1] = -0.1;
+  thetas[2] = 0.05;
+  thetas[3] = 0.1;
+  thetas[4] = 0.05;
+  thetas[5] = -0.5;
+
+  gergm::GergmModel model(number_of_nodes,
+                          statistics_to_use,
+                          node_combinations(number_of_nodes, 3),
+                          node_combinations(number_of_nodes, 2),
+                          alphas,
+                          0,
+                          0,
+                          0,
+                          arma::umat(2, number_of_statistics),
+                          arma::umat(2, number_of_statistics),
+                          arma::zeros(number_of_statistics),
+                          statistics_to_use,
+                          alphas,
+                          0,
+                          arma::zeros(number_of_statistics),
+                          1,
+                          1,
+                          false,
+                          false,
+                          false);
+
+  arma::mat initial_network(number_of_nodes, number_of_nodes);
+  initial_network.fill(0.5);
+  initial_network.diag().zeros();
+
+  int take_sample_every = 10;
+  int number_of_samples_to_store = number_of_iterations / take_sample_every;
+  if (number_of_samples_to_store < 1) {
+    number_of_samples_to_store = 1;
+    take_sample_every = number_of_iterations;
+  }
+
+  // one chain per thread, each with its own seed and output
+  std::vector<gergm::MetropolisHastingsOutput> outputs(number_of_chains);
+  std::vector<std::thread> chains;
+  for (int c = 0; c < number_of_chains; ++c) {
+    chains.push_back(std::thread([&, c]() {
+      gergm::run_metropolis_hastings(model,
+                                     number_of_iterations,
+                                     0.1,
+                                     initial_network,
+                                     take_sample_every,
+                                     thetas,
+                                     123 + c,
+                                     number_of_samples_to_store,
+                                     false,
+                                     false,
+                                     outputs[c]);
+    }));
+  }
+  for (int c = 0; c < number_of_chains; ++c) {
+    chains[c].join();
+  }
+
+  const char* statistic_names[] = {"out2stars", "in2stars", "ctriads",
+                                   "mutual", "ttriads", "edges"};
+  for (int c = 0; c < number_of_chains; ++c) {
+    const arma::mat& statistics = outputs[c].Save_H_Statistics;
+    if (!statistics.is_finite()) {
+      std::fprintf(stderr, "chain %d produced non-finite statistics\n", c);
+      return 1;
+    }
+    std::printf("chain %d: acceptance %.3f", c,
+                arma::accu(outputs[c].Accept_or_Reject) /
+                  outputs[c].Accept_or_Reject.n_elem);
+    for (int s = 0; s < number_of_statistics; ++s) {
+      double total = 0;
+      for (arma::uword i = 0; i < statistics.n_rows; ++i) {
+        total += statistics(i, s);
+      }
+      std::printf(", %s %.4f", statistic_names[s], total / statistics.n_rows);
+    }
+    std::printf("\n");
+  }
+  return 0;
+}
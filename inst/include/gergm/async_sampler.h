@@ -0,0 +1,153 @@
+#ifndef GERGM_ASYNC_SAMPLER_H
+#define GERGM_ASYNC_SAMPLER_H
+
+// A Metropolis Hastings run on a background thread. The caller can poll its
+// progress, copy the samples taken so far, cancel it (it stops after the
+// iteration in progress) and wait for the result. Destroying a run that has
+// not finished cancels it and waits for the thread, so a run never outlives
+// its handle. The model is not copied and must outlive the run. Other
+// samplers with the same output and control, such as
+// run_hamiltonian_monte_carlo(), can be run the same way through a
+// SamplerRun.
+
+#include <armadillo>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "metropolis_hastings.h"
+#include "model.h"
+#include "sampler_control.h"
+
+namespace gergm {
+
+// A sampler run, given the control to report to and the output to fill.
+typedef std::function<void(SamplerControl*, MetropolisHastingsOutput&)>
+  SamplerRun;
+
+class AsyncMetropolisHastings {
+public:
+  AsyncMetropolisHastings(const GergmModel& model,
+                          int number_of_iterations,
+                          double shape_parameter,
+                          const arma::mat& initial_network,
+                          int take_sample_every,
+                          const arma::vec& thetas,
+                          int seed,
+                          int number_of_samples_to_store,
+                          bool parallel,
+                          int network_storage)
+    : model(model),
+      sampler([&model, number_of_iterations, shape_parameter, initial_network,
+               take_sample_every, thetas, seed, number_of_samples_to_store,
+               parallel, network_storage](SamplerControl* control,
+                                          MetropolisHastingsOutput& output) {
+        run_metropolis_hastings(model,
+                                number_of_iterations,
+                                shape_parameter,
+                                initial_network,
+                                take_sample_every,
+                                thetas,
+                                seed,
+                                number_of_samples_to_store,
+                                parallel,
+                                true,
+                                network_storage,
+                                control,
+                                output);
+      }),
+      done(false) {
+    worker = std::thread(&AsyncMetropolisHastings::run, this);
+  }
+
+  AsyncMetropolisHastings(const GergmModel& model, const SamplerRun& sampler)
+    : model(model),
+      sampler(sampler),
+      done(false) {
+    worker = std::thread(&AsyncMetropolisHastings::run, this);
+  }
+
+  ~AsyncMetropolisHastings() {
+    cancel();
+    if (worker.joinable()) {
+      worker.join();
+    }
+  }
+
+  const GergmModel& sampler_model() const {
+    return model;
+  }
+
+  SamplerProgress progress() const {
+    return control.progress();
+  }
+
+  void cancel() {
+    control.request_cancel();
+  }
+
+  bool finished() const {
+    std::lock_guard<std::mutex> lock(done_mutex);
+    return done;
+  }
+
+  // Wait up to milliseconds for the run to finish, true if it has.
+  bool wait_for(int milliseconds) {
+    std::unique_lock<std::mutex> lock(done_mutex);
+    return done_condition.wait_for(lock,
+                                   std::chrono::milliseconds(milliseconds),
+                                   [this] { return done; });
+  }
+
+  // Wait for the run to finish and return its output, rethrowing anything
+  // the sampler threw.
+  const MetropolisHastingsOutput& result() {
+    if (worker.joinable()) {
+      worker.join();
+    }
+    if (failure) {
+      std::rethrow_exception(failure);
+    }
+    return output;
+  }
+
+  // The iterations and samples done so far (all of them once the run has
+  // finished), apart from the current network and profile.
+  void partial_output(MetropolisHastingsOutput& partial) const {
+    std::lock_guard<std::mutex> lock(control.output_mutex());
+    copy_leading_output(output, control.completed_iterations(),
+                        control.stored_samples(), partial);
+  }
+
+private:
+  AsyncMetropolisHastings(const AsyncMetropolisHastings&);
+  AsyncMetropolisHastings& operator=(const AsyncMetropolisHastings&);
+
+  void run() {
+    try {
+      sampler(&control, output);
+    } catch (...) {
+      failure = std::current_exception();
+    }
+    std::lock_guard<std::mutex> lock(done_mutex);
+    done = true;
+    done_condition.notify_all();
+  }
+
+  const GergmModel& model;
+  SamplerRun sampler;
+
+  SamplerControl control;
+  MetropolisHastingsOutput output;
+  std::exception_ptr failure;
+  mutable std::mutex done_mutex;
+  std::condition_variable done_condition;
+  bool done;
+  std::thread worker;
+};
+
+} // end of gergm namespace
+
+#endif
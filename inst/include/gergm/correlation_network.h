@@ -0,0 +1,35 @@
+#ifndef GERGM_CORRELATION_NETWORK_H
+#define GERGM_CORRELATION_NETWORK_H
+
+// Moving between the bounded [0,1] scale the samplers work on and the
+// correlation matrices of correlation networks.
+
+#include <armadillo>
+#include <cmath>
+#include "vine_transform.h"
+
+namespace gergm {
+
+using std::pow;
+
+// add in the functions I wrote for correlation networks. The transform itself
+// lives in vine_transform.h so that it is shared with Corr_to_Part.
+inline arma::mat partials_to_correlations(arma::mat partial_correlations){
+  return vine::partials_to_correlations(partial_correlations);
+}
+
+
+inline arma::mat bounded_to_correlations(arma::mat bounded_network){
+  //transform back to the partial space
+  arma::mat partials = 2 * bounded_network -1;
+  int temp = partials.n_rows;
+  partials.diag() = arma::ones(temp);
+  //transform to correlation space
+  arma::mat correlations =  gergm::partials_to_correlations(partials);
+  return correlations;
+}
+
+
+} // end of gergm namespace
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef GERGM_GERGM_H
+#define GERGM_GERGM_H
+
+// The GERGM core: network statistics, correlation transforms, MPLE
+// integration, and the Metropolis Hastings, Hamiltonian Monte Carlo and Gibbs
+// samplers. These headers only depend on Armadillo and the standard library,
+// so they can be used outside of R (see inst/core/CMakeLists.txt) and the
+// samplers can run on any thread. Code using them from R must include RcppArmadillo.h first.
+
+#include "async_sampler.h"
+#include "correlation_network.h"
+#include "gibbs.h"
+#include "hamiltonian_monte_carlo.h"
+#include "importance_sampling.h"
+#include "metropolis_hastings.h"
+#include "model.h"
+#include "mple_integration.h"
+#include "network_state.h"
+#include "network_statistics.h"
+#include "parallel.h"
+#include "proposal.h"
+#include "random.h"
+#include "sample_file.h"
+#include "sample_storage.h"
+#include "sampler_control.h"
+#include "sampler_profile.h"
+#include "statistic_gradients.h"
+#include "triad_sampling.h"
+#include "vine_transform.h"
+
+#endif
@@ -0,0 +1,263 @@
+#ifndef GERGM_GIBBS_H
+#define GERGM_GIBBS_H
+
+// Gibbs sampler for GERGMs with base statistics, drawing each edge from its
+// truncated exponential full conditional.
+
+#include <armadillo>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include "random.h"
+#include "sampler_profile.h"
+
+namespace gibbs {
+
+using std::pow;
+using std::exp;
+using std::log;
+
+// Change statistics for a single edge w_{i,j}, these match the dh() function
+// in Helper_Functions.R and are each O(n) in the number of nodes. Statistic
+// codes are the same as in the MH samplers.
+
+// dout2star
+inline double dout2star(const arma::mat& net, int i, int j, int n, double alpha,
+                        int together) {
+  double val = 0;
+  for (int k = 0; k < n; ++k) {
+    if (k != i && k != j) {
+      if (together == 0) {
+        val += pow(net(i, k), alpha);
+      } else {
+        val += net(i, k);
+      }
+    }
+  }
+  if (together != 0) {
+    val = pow(val, alpha);
+  }
+  return val;
+}
+
+// din2star
+inline double din2star(const arma::mat& net, int i, int j, int n, double alpha,
+                       int together) {
+  double val = 0;
+  for (int k = 0; k < n; ++k) {
+    if (k != i && k != j) {
+      if (together == 0) {
+        val += pow(net(k, j), alpha);
+      } else {
+        val += net(k, j);
+      }
+    }
+  }
+  if (together != 0) {
+    val = pow(val, alpha);
+  }
+  return val;
+}
+
+// dctriads
+inline double dctriads(const arma::mat& net, int i, int j, int n, double alpha,
+                       int together) {
+  double val = 0;
+  for (int k = 0; k < n; ++k) {
+    if (k != i && k != j) {
+      if (together == 0) {
+        val += pow(net(j, k), alpha) * pow(net(k, i), alpha);
+      } else {
+        val += net(j, k) * net(k, i);
+      }
+    }
+  }
+  if (together != 0) {
+    val = pow(val, alpha);
+  }
+  return val;
+}
+
+// drecip
+inline double drecip(const arma::mat& net, int i, int j, double alpha) {
+  return pow(net(j, i), alpha);
+}
+
+// dttriads
+inline double dttriads(const arma::mat& net, int i, int j, int n, double alpha,
+                       int together) {
+  double t2 = 0;
+  double t3 = 0;
+  double t4 = 0;
+  for (int k = 0; k < n; ++k) {
+    if (k != i && k != j) {
+      t2 += net(j, k) * net(i, k);
+      t3 += net(k, j) * net(k, i);
+      t4 += net(k, j) * net(i, k);
+    }
+  }
+  if (together == 0) {
+    return pow(t2, alpha) + pow(t3, alpha) + pow(t4, alpha);
+  }
+  return pow((t2 + t3 + t4), alpha);
+}
+
+// theta' dh for edge (i,j). This is the rate of the truncated exponential
+// full conditional for w_{i,j}.
+inline double edge_rate(const arma::mat& net,
+                        int i,
+                        int j,
+                        int n,
+                        const arma::vec& statistics_to_use,
+                        const arma::vec& thetas,
+                        const arma::vec& alphas,
+                        int together) {
+  double rate = 0;
+  int number_of_thetas = statistics_to_use.n_elem;
+  for (int s = 0; s < number_of_thetas; ++s) {
+    double change = 0;
+    switch (int(statistics_to_use[s])) {
+    case 0:
+      change = gibbs::dout2star(net, i, j, n, alphas[s], together);
+      break;
+    case 1:
+      change = gibbs::din2star(net, i, j, n, alphas[s], together);
+      break;
+    case 2:
+      change = gibbs::dctriads(net, i, j, n, alphas[s], together);
+      break;
+    case 3:
+      change = gibbs::drecip(net, i, j, alphas[s]);
+      break;
+    case 4:
+      change = gibbs::dttriads(net, i, j, n, alphas[s], together);
+      break;
+    case 5:
+      change = 1;
+      break;
+    default:
+      throw std::invalid_argument("The Gibbs sampler only supports the out2stars, in2stars, ctriads, mutual, ttriads and edges statistics.");
+    }
+    rate += thetas[s] * change;
+  }
+  return rate;
+}
+
+// Exact inverse CDF draw from the density proportional to exp(lambda * x) on
+// [0,1]. This is rtexp() in Helper_Functions.R, rearranged so that it does not
+// overflow for large |lambda|.
+inline double truncated_exponential(double lambda, double u) {
+  if (lambda == 0) {
+    return u;
+  }
+  if (lambda > 0) {
+    return 1 + log(u + (1 - u) * exp(-lambda)) / lambda;
+  }
+  return std::log1p(u * std::expm1(lambda)) / lambda;
+}
+
+// Everything a Gibbs run produces.
+struct GibbsOutput {
+  arma::cube Network_Samples;
+  arma::vec Mean_Edge_Weights;
+  // only filled in when compiled with GERGM_PROFILE, there is no accept step
+  gergm::SamplerProfile profile;
+};
+
+// Run number_of_iterations full scans of the network, keeping every
+// take_sample_every'th network.
+inline void run_gibbs_sampler(int number_of_iterations,
+                              int number_of_nodes,
+                              const arma::vec& statistics_to_use,
+                              const arma::mat& initial_network,
+                              int take_sample_every,
+                              const arma::vec& thetas,
+                              const arma::vec& alphas,
+                              int together,
+                              int seed,
+                              int number_of_samples_to_store,
+                              int undirect_network,
+                              GibbsOutput& output) {
+
+  int Sample_Counter = 0;
+  int Storage_Counter = 0;
+  arma::vec& Mean_Edge_Weights = output.Mean_Edge_Weights;
+  arma::cube& Network_Samples = output.Network_Samples;
+  Mean_Edge_Weights = arma::zeros(number_of_samples_to_store);
+  Network_Samples = arma::zeros(number_of_nodes,
+                                number_of_nodes,
+                                number_of_samples_to_store);
+  arma::mat current_edge_weights = initial_network;
+  current_edge_weights.diag().zeros();
+
+  // Set RNG and define uniform distribution
+  std::mt19937 generator(seed);
+  gergm::random::uniform_01<double> uniform_distribution;
+
+  // Outer loop over the number of full scans of the network
+  for (int n = 0; n < number_of_iterations; ++n) {
+    if (undirect_network == 1) {
+      // both (i,j) and (j,i) move together, so the rate is the sum of the
+      // change statistics in each direction.
+      for (int i = 1; i < number_of_nodes; ++i) {
+        for (int j = 0; j < i; ++j) {
+          GERGM_PROFILE_START(statistic);
+          double lambda = gibbs::edge_rate(current_edge_weights, i, j,
+                                           number_of_nodes, statistics_to_use,
+                                           thetas, alphas, together) +
+                          gibbs::edge_rate(current_edge_weights, j, i,
+                                           number_of_nodes, statistics_to_use,
+                                           thetas, alphas, together);
+          GERGM_PROFILE_STOP(output.profile, statistic);
+          GERGM_PROFILE_COUNT(output.profile, statistic_evaluations, 2);
+          GERGM_PROFILE_START(proposal);
+          double new_edge_value = gibbs::truncated_exponential(
+            lambda, uniform_distribution(generator));
+          current_edge_weights(i, j) = new_edge_value;
+          current_edge_weights(j, i) = new_edge_value;
+          GERGM_PROFILE_STOP(output.profile, proposal);
+          GERGM_PROFILE_COUNT(output.profile, proposal_draws, 1);
+          GERGM_PROFILE_COUNT(output.profile, proposed_edges, 1);
+        }
+      }
+    } else {
+      for (int i = 0; i < number_of_nodes; ++i) {
+        for (int j = 0; j < number_of_nodes; ++j) {
+          if (i != j) {
+            GERGM_PROFILE_START(statistic);
+            double lambda = gibbs::edge_rate(current_edge_weights, i, j,
+                                             number_of_nodes,
+                                             statistics_to_use, thetas, alphas,
+                                             together);
+            GERGM_PROFILE_STOP(output.profile, statistic);
+            GERGM_PROFILE_COUNT(output.profile, statistic_evaluations, 1);
+            GERGM_PROFILE_START(proposal);
+            current_edge_weights(i, j) = gibbs::truncated_exponential(
+              lambda, uniform_distribution(generator));
+            GERGM_PROFILE_STOP(output.profile, proposal);
+            GERGM_PROFILE_COUNT(output.profile, proposal_draws, 1);
+            GERGM_PROFILE_COUNT(output.profile, proposed_edges, 1);
+          }
+        }
+      }
+    }
+
+    Storage_Counter += 1;
+    // Save network
+    if (Storage_Counter == take_sample_every) {
+      GERGM_PROFILE_START(storage);
+      Network_Samples.slice(Sample_Counter) = current_edge_weights;
+      Mean_Edge_Weights[Sample_Counter] = arma::accu(current_edge_weights) /
+        double(number_of_nodes * (number_of_nodes - 1));
+      GERGM_PROFILE_STOP(output.profile, storage);
+      GERGM_PROFILE_COUNT(output.profile, bytes_copied,
+                          sizeof(double) * current_edge_weights.n_elem);
+      Storage_Counter = 0;
+      Sample_Counter += 1;
+    }
+  }
+}
+
+} // namespace gibbs
+
+#endif
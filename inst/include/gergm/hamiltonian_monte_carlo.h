@@ -0,0 +1,347 @@
+#ifndef GERGM_HAMILTONIAN_MONTE_CARLO_H
+#define GERGM_HAMILTONIAN_MONTE_CARLO_H
+
+// A Hamiltonian Monte Carlo sampler for the same target as the Metropolis
+// Hastings sampler, exp(theta' h(w)) on the unit cube of free edge values.
+// It moves on the logits x = log(w / (1 - w)), which are unbounded, so the
+// target gains the Jacobian prod w (1 - w), and every free edge moves at
+// once along the gradient of the statistics (see statistic_gradients.h)
+// instead of taking an independent random walk step. Each iteration draws a
+// standard normal momentum, takes leapfrog_steps leapfrog steps and accepts
+// the end point with the usual Metropolis correction, so the chain is exact
+// whatever the step size. During the first adapt_iterations iterations the
+// step size is tuned by dual averaging (Hoffman and Gelman, 2014) towards an
+// average acceptance probability of target_acceptance, and then fixed.
+//
+// The output is the same as that of run_metropolis_hastings(), with
+// P_Ratios the change in theta' h, Q_Ratios the change in the Jacobian and
+// kinetic energy, and step_size the step size after adaptation. Statistics
+// are always calculated on every triple and pair (triad sampling is not
+// used), and correlation networks are not supported.
+
+#include <algorithm>
+#include <armadillo>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "metropolis_hastings.h"
+#include "model.h"
+#include "random.h"
+#include "sampler_control.h"
+#include "sampler_profile.h"
+#include "statistic_gradients.h"
+
+namespace gergm {
+
+// Edge values are kept this far inside (0,1) when a starting network is
+// mapped to logits, so that edges at exactly 0 or 1 get finite logits.
+const double hmc_edge_margin = 1e-10;
+
+// The free edges of one network type, in the order the Metropolis Hastings
+// proposals visit them, with the entries each one sets.
+template<bool Undirected, bool IncludeDiagonal>
+inline void free_edge_entries(int number_of_nodes,
+                              std::vector<arma::uword>& entries,
+                              std::vector<arma::uword>& mirror_entries) {
+  entries.clear();
+  mirror_entries.clear();
+  for (int i = 0; i < number_of_nodes; ++i) {
+    for (int j = 0; j < i; ++j) {
+      entries.push_back(i + j * number_of_nodes);
+      mirror_entries.push_back(Undirected ? j + i * number_of_nodes :
+                                 i + j * number_of_nodes);
+    }
+    if (IncludeDiagonal) {
+      entries.push_back(i + i * number_of_nodes);
+      mirror_entries.push_back(i + i * number_of_nodes);
+    }
+    if (!Undirected) {
+      for (int j = i + 1; j < number_of_nodes; ++j) {
+        entries.push_back(i + j * number_of_nodes);
+        mirror_entries.push_back(i + j * number_of_nodes);
+      }
+    }
+  }
+}
+
+// The state of the chain at one point: the logits of the free edges, the
+// network they give, theta' h of that network and the potential energy
+// U = -(theta' h + log Jacobian) with its gradient in the logits.
+struct HamiltonianState {
+  arma::vec logits;
+  arma::mat network;
+  double h_value;
+  double log_jacobian;
+  double potential;
+  arma::vec potential_gradient;
+};
+
+// Set network from state.logits and work out the rest of state.
+inline void evaluate_hamiltonian_state(const GergmModel& model,
+                                       const arma::vec& thetas,
+                                       const std::vector<arma::uword>& entries,
+                                       const std::vector<arma::uword>& mirror_entries,
+                                       arma::mat& h_gradient,
+                                       HamiltonianState& state) {
+  int number_of_edges = entries.size();
+  double* network = state.network.memptr();
+  double log_jacobian = 0;
+  for (int e = 0; e < number_of_edges; ++e) {
+    double x = state.logits[e];
+    double w = x >= 0 ? 1 / (1 + std::exp(-x)) :
+      std::exp(x) / (1 + std::exp(x));
+    network[entries[e]] = w;
+    network[mirror_entries[e]] = w;
+    // log(w (1 - w)), without cancellation for large |x|
+    log_jacobian += -std::abs(x) - 2 * std::log1p(std::exp(-std::abs(x)));
+  }
+  state.h_value = h_function_logit_gradient(model, thetas, state.network,
+                                            h_gradient);
+  state.log_jacobian = log_jacobian;
+  state.potential = -(state.h_value + log_jacobian);
+  const double* gradient = h_gradient.memptr();
+  for (int e = 0; e < number_of_edges; ++e) {
+    double h_derivative = gradient[entries[e]];
+    if (mirror_entries[e] != entries[e]) {
+      h_derivative += gradient[mirror_entries[e]];
+    }
+    // d log(w (1 - w)) / dx = 1 - 2w
+    state.potential_gradient[e] = -(h_derivative + 1 -
+                                    2 * network[entries[e]]);
+  }
+}
+
+template<bool Undirected, bool IncludeDiagonal>
+inline void hamiltonian_monte_carlo_kernel(const GergmModel& model,
+                                           int number_of_iterations,
+                                           double step_size,
+                                           int leapfrog_steps,
+                                           int adapt_iterations,
+                                           double target_acceptance,
+                                           const arma::mat& initial_network,
+                                           int take_sample_every,
+                                           const arma::vec& thetas,
+                                           int seed,
+                                           int number_of_samples_to_store,
+                                           bool store_networks,
+                                           int network_storage,
+                                           SamplerControl* control,
+                                           MetropolisHastingsOutput& output) {
+
+  if (control != NULL) {
+    control->start(number_of_iterations);
+  }
+  int number_of_nodes = model.number_of_nodes;
+  int statistics_to_save = model.combined_statistics_to_use.n_elem;
+  arma::vec archive_buffer;
+  gergm::start_sampler_output<Undirected, IncludeDiagonal, false>(
+    number_of_nodes, number_of_iterations, number_of_samples_to_store,
+    statistics_to_save, store_networks, network_storage, output,
+    archive_buffer);
+
+  std::vector<arma::uword> entries;
+  std::vector<arma::uword> mirror_entries;
+  free_edge_entries<Undirected, IncludeDiagonal>(number_of_nodes, entries,
+                                                 mirror_entries);
+  int number_of_edges = entries.size();
+
+  // the current and proposed states are a pair of buffers, swapped when a
+  // proposal is accepted. Fixed entries (the diagonal, when it is not
+  // modeled) are the same in both.
+  HamiltonianState current;
+  current.network = initial_network;
+  current.logits = arma::zeros(number_of_edges);
+  current.potential_gradient = arma::zeros(number_of_edges);
+  for (int e = 0; e < number_of_edges; ++e) {
+    double w = std::min(std::max(initial_network[entries[e]],
+                                 hmc_edge_margin), 1 - hmc_edge_margin);
+    current.logits[e] = std::log(w / (1 - w));
+  }
+  arma::mat h_gradient;
+  evaluate_hamiltonian_state(model, thetas, entries, mirror_entries,
+                             h_gradient, current);
+  HamiltonianState proposed = current;
+  arma::vec momentum = arma::zeros(number_of_edges);
+
+  // dual averaging of log(step_size), with the constants recommended by
+  // Hoffman and Gelman
+  double log_step_size = std::log(step_size);
+  double log_step_size_average = 0;
+  double shrinkage_target = std::log(10 * step_size);
+  double acceptance_gap = 0;
+
+  std::mt19937 generator(seed);
+  random::uniform_01<double> uniform_distribution;
+  normal_distribution<double> momentum_distribution(0, 1);
+  double total_edges = double(number_of_nodes * (number_of_nodes - 1));
+  if (IncludeDiagonal) {
+    total_edges = double(number_of_nodes * number_of_nodes);
+  }
+  int Storage_Counter = 0;
+  int MH_Counter = 0;
+  int iterations_run = number_of_iterations;
+  for (int n = 0; n < number_of_iterations; ++n) {
+    GERGM_PROFILE_START(proposal);
+    double kinetic_energy = 0;
+    for (int e = 0; e < number_of_edges; ++e) {
+      momentum[e] = momentum_distribution(generator);
+      kinetic_energy += momentum[e] * momentum[e] / 2;
+    }
+    double start_energy = current.potential + kinetic_energy;
+
+    proposed.logits = current.logits;
+    proposed.potential_gradient = current.potential_gradient;
+    momentum -= (step_size / 2) * proposed.potential_gradient;
+    for (int l = 0; l < leapfrog_steps; ++l) {
+      proposed.logits += step_size * momentum;
+      evaluate_hamiltonian_state(model, thetas, entries, mirror_entries,
+                                 h_gradient, proposed);
+      if (l < leapfrog_steps - 1) {
+        momentum -= step_size * proposed.potential_gradient;
+      }
+    }
+    momentum -= (step_size / 2) * proposed.potential_gradient;
+    GERGM_PROFILE_STOP(output.profile, proposal);
+    GERGM_PROFILE_COUNT(output.profile, statistic_evaluations,
+                        leapfrog_steps);
+    GERGM_PROFILE_COUNT(output.profile, proposed_edges,
+                        double(leapfrog_steps) * number_of_edges);
+
+    kinetic_energy = arma::dot(momentum, momentum) / 2;
+    double log_prob_accept = start_energy -
+      (proposed.potential + kinetic_energy);
+    // a diverging trajectory is rejected
+    if (!(log_prob_accept == log_prob_accept)) {
+      log_prob_accept = -std::numeric_limits<double>::infinity();
+    }
+    output.P_Ratios[n] = proposed.h_value - current.h_value;
+    output.Q_Ratios[n] = log_prob_accept - output.P_Ratios[n];
+    output.Proposed_Density[n] = arma::accu(proposed.network) / total_edges;
+    output.Current_Density[n] = arma::accu(current.network) / total_edges;
+
+    GERGM_PROFILE_START(accept);
+    double lud = std::log(uniform_distribution(generator));
+    double accept_proportion = 0;
+    if (!(log_prob_accept < lud)) {
+      accept_proportion = 1;
+      std::swap(current, proposed);
+    }
+    GERGM_PROFILE_STOP(output.profile, accept);
+    output.Log_Prob_Accept[n] = log_prob_accept;
+    output.Accept_or_Reject[n] = accept_proportion;
+
+    if (n < adapt_iterations) {
+      double accept_probability = log_prob_accept >= 0 ? 1 :
+        std::exp(log_prob_accept);
+      double t = n + 1;
+      acceptance_gap = (1 - 1 / (t + 10)) * acceptance_gap +
+        (target_acceptance - accept_probability) / (t + 10);
+      log_step_size = shrinkage_target - std::sqrt(t) / 0.05 * acceptance_gap;
+      double weight = std::pow(t, -0.75);
+      log_step_size_average = weight * log_step_size +
+        (1 - weight) * log_step_size_average;
+      step_size = std::exp(log_step_size);
+      if (n == adapt_iterations - 1) {
+        step_size = std::exp(log_step_size_average);
+      }
+    }
+
+    Storage_Counter += 1;
+    if (Storage_Counter == take_sample_every) {
+      GERGM_PROFILE_START(storage);
+      gergm::store_network_sample<Undirected, IncludeDiagonal>(
+        model, current.network, MH_Counter, store_networks, archive_buffer,
+        control, output);
+      GERGM_PROFILE_STOP(output.profile, storage);
+      Storage_Counter = 0;
+      MH_Counter += 1;
+    }
+
+    if (control != NULL) {
+      control->record_iteration(accept_proportion > 0);
+      if (control->cancel_requested()) {
+        iterations_run = n + 1;
+        break;
+      }
+    }
+  }
+
+  output.final_network = current.network;
+  output.step_size = step_size;
+  if (iterations_run < number_of_iterations) {
+    gergm::keep_cancelled_output(iterations_run, MH_Counter, current.network,
+                                 control, output);
+    output.step_size = step_size;
+  }
+}
+
+typedef void (*HamiltonianMonteCarloKernel)(const GergmModel&, int, double,
+                                            int, int, double,
+                                            const arma::mat&, int,
+                                            const arma::vec&, int, int, bool,
+                                            int, SamplerControl*,
+                                            MetropolisHastingsOutput&);
+
+// Hamiltonian Monte Carlo for a compiled model, with the storage options and
+// control of run_metropolis_hastings(). step_size is the starting step size
+// when adapt_iterations > 0.
+inline void run_hamiltonian_monte_carlo(const GergmModel& model,
+                                        int number_of_iterations,
+                                        double step_size,
+                                        int leapfrog_steps,
+                                        int adapt_iterations,
+                                        double target_acceptance,
+                                        const arma::mat& initial_network,
+                                        int take_sample_every,
+                                        const arma::vec& thetas,
+                                        int seed,
+                                        int number_of_samples_to_store,
+                                        bool store_networks,
+                                        int network_storage,
+                                        SamplerControl* control,
+                                        MetropolisHastingsOutput& output) {
+  if (model.using_correlation_network == 1) {
+    throw std::invalid_argument(
+      "Hamiltonian Monte Carlo does not support correlation networks.");
+  }
+  if (!(step_size > 0) || leapfrog_steps < 1) {
+    throw std::invalid_argument(
+      "Hamiltonian Monte Carlo needs step_size > 0 and leapfrog_steps >= 1.");
+  }
+  if (!(target_acceptance > 0 && target_acceptance < 1)) {
+    throw std::invalid_argument(
+      "Hamiltonian Monte Carlo needs 0 < target_acceptance < 1.");
+  }
+  HamiltonianMonteCarloKernel kernel =
+    &hamiltonian_monte_carlo_kernel<false, false>;
+  if (model.undirect_network == 1) {
+    if (model.include_diagonal) {
+      kernel = &hamiltonian_monte_carlo_kernel<true, true>;
+    } else {
+      kernel = &hamiltonian_monte_carlo_kernel<true, false>;
+    }
+  } else if (model.include_diagonal) {
+    kernel = &hamiltonian_monte_carlo_kernel<false, true>;
+  }
+  kernel(model,
+         number_of_iterations,
+         step_size,
+         leapfrog_steps,
+         adapt_iterations,
+         target_acceptance,
+         initial_network,
+         take_sample_every,
+         thetas,
+         seed,
+         number_of_samples_to_store,
+         store_networks,
+         network_storage,
+         control,
+         output);
+}
+
+} // end of gergm namespace
+
+#endif
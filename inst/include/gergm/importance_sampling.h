@@ -0,0 +1,51 @@
+#ifndef GERGM_IMPORTANCE_SAMPLING_H
+#define GERGM_IMPORTANCE_SAMPLING_H
+
+#include <armadillo>
+#include <cmath>
+#include <cstddef>
+
+namespace gergm {
+
+// The MCMCMLE importance sampling log likelihood around the thetas the
+// networks were simulated at (ltheta),
+//   l(theta) = theta' h(obs) - log sum_i exp(h_i' (theta - ltheta)),
+// which is log.l() in Log_Likelihood_and_MPLE_Objective.R. Neither the
+// simulated nor the observed statistics change while theta is optimized, so
+// they are held here and each evaluation is one pass over the statistics.
+struct ImportanceSamplingLikelihood {
+  arma::mat simulated_statistics;
+  arma::vec observed_statistics;
+  arma::vec ltheta;
+
+  // Returns the log likelihood. If gradient is not NULL it is filled with
+  // h(obs) minus the importance weighted mean of the simulated statistics, and
+  // if hessian is also not NULL it is filled with minus their importance
+  // weighted covariance.
+  double evaluate(const arma::vec& theta,
+                  arma::vec* gradient,
+                  arma::mat* hessian) const {
+    arma::vec z = simulated_statistics * (theta - ltheta);
+    double max_z = z.max();
+    arma::vec weights = arma::exp(z - max_z);
+    double total = arma::accu(weights);
+    double value = arma::dot(theta, observed_statistics) - max_z -
+      std::log(total);
+    if (gradient != NULL) {
+      weights /= total;
+      arma::vec weighted_mean = simulated_statistics.t() * weights;
+      *gradient = observed_statistics - weighted_mean;
+      if (hessian != NULL) {
+        arma::mat centered = simulated_statistics.each_row() -
+          weighted_mean.t();
+        centered.each_col() %= arma::sqrt(weights);
+        *hessian = -(centered.t() * centered);
+      }
+    }
+    return value;
+  }
+};
+
+} // end of gergm namespace
+
+#endif
@@ -0,0 +1,812 @@
+#ifndef GERGM_METROPOLIS_HASTINGS_H
+#define GERGM_METROPOLIS_HASTINGS_H
+
+// The Metropolis Hastings sampler used for estimation and simulation.
+
+#include <algorithm>
+#include <armadillo>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "correlation_network.h"
+#include "model.h"
+#include "network_statistics.h"
+#include "proposal.h"
+#include "random.h"
+#include "sample_storage.h"
+#include "sampler_control.h"
+#include "sampler_profile.h"
+#include "triad_sampling.h"
+#include "vine_transform.h"
+
+namespace gergm {
+
+using std::log;
+
+// Everything a Metropolis Hastings run produces. These are plain Armadillo
+// objects so that chains can run on worker threads, where R objects must not
+// be created.
+struct MetropolisHastingsOutput {
+  arma::vec Accept_or_Reject;
+  arma::cube Network_Samples;
+  arma::mat Save_H_Statistics;
+  arma::vec Mean_Edge_Weights;
+  arma::vec Log_Prob_Accept;
+  arma::vec P_Ratios;
+  arma::vec Q_Ratios;
+  arma::vec Proposed_Density;
+  arma::vec Current_Density;
+  // undirected (and correlation) networks are stored as their packed lower
+  // triangles in Packed_Network_Samples instead of in Network_Samples. Only
+  // the stored samples are packed: the chain itself keeps full symmetric
+  // matrices, because the statistic kernels read both (i,j) and (j,i). The
+  // proposal only draws the lower triangle and mirrors it.
+  bool packed_networks;
+  arma::mat Packed_Network_Samples;
+  // with any network_storage other than STORE_DOUBLE, the (packed or full)
+  // samples are kept encoded in Archived_Network_Samples instead
+  int network_storage;
+  NetworkSampleArchive Archived_Network_Samples;
+  // the (bounded scale) state of the chain after the last iteration
+  arma::mat final_network;
+  // only filled in when compiled with GERGM_PROFILE
+  SamplerProfile profile;
+  // true when the run was cancelled through its SamplerControl, in which case
+  // everything above only covers the iterations and samples done
+  bool cancelled;
+  // the step size after adaptation, for Hamiltonian Monte Carlo runs (see
+  // hamiltonian_monte_carlo.h)
+  double step_size;
+
+  MetropolisHastingsOutput()
+    : packed_networks(false),
+      network_storage(STORE_DOUBLE),
+      cancelled(false),
+      step_size(0) {}
+};
+
+// The matrices a Metropolis Hastings run works in besides its output: the
+// proposal buffer, the correlation scale networks and the triad subsamples.
+// A run sizes them itself, so one workspace can be handed to any number of
+// runs in turn (a warm started chain reuses one from theta to theta) and
+// keeps its memory between them. Runs on different threads need their own.
+struct SamplerWorkspace {
+  arma::mat proposed_network;
+  arma::mat corr_current_network;
+  arma::mat corr_proposed_network;
+  arma::Mat<double> random_triad_samples;
+  arma::Mat<double> random_dyad_samples;
+  arma::vec triad_probabilities;
+  arma::vec alias_probability;
+  arma::uvec alias;
+};
+
+// Copy the first iterations and samples of output into partial. Used for a
+// run that is still going, which must not have changed anything written
+// before those counts were published (see sampler_control.h), so the current
+// network and profile are left out.
+inline void copy_leading_output(const MetropolisHastingsOutput& output,
+                                int iterations,
+                                int samples,
+                                MetropolisHastingsOutput& partial) {
+  partial = MetropolisHastingsOutput();
+  if (iterations == 0) {
+    return;
+  }
+  partial.Accept_or_Reject = arma::vec(output.Accept_or_Reject.memptr(),
+                                       iterations);
+  partial.Log_Prob_Accept = arma::vec(output.Log_Prob_Accept.memptr(),
+                                      iterations);
+  partial.P_Ratios = arma::vec(output.P_Ratios.memptr(), iterations);
+  partial.Q_Ratios = arma::vec(output.Q_Ratios.memptr(), iterations);
+  partial.Proposed_Density = arma::vec(output.Proposed_Density.memptr(),
+                                       iterations);
+  partial.Current_Density = arma::vec(output.Current_Density.memptr(),
+                                      iterations);
+  partial.Mean_Edge_Weights = arma::vec(output.Mean_Edge_Weights.memptr(),
+                                        samples);
+  int statistics = output.Save_H_Statistics.n_cols;
+  partial.Save_H_Statistics = arma::zeros(samples, statistics);
+  for (int m = 0; m < statistics; ++m) {
+    for (int s = 0; s < samples; ++s) {
+      partial.Save_H_Statistics(s, m) = output.Save_H_Statistics(s, m);
+    }
+  }
+  partial.packed_networks = output.packed_networks;
+  partial.network_storage = output.network_storage;
+  if (output.network_storage != STORE_DOUBLE) {
+    std::vector<std::size_t> kept(samples);
+    for (int s = 0; s < samples; ++s) {
+      kept[s] = s;
+    }
+    partial.Archived_Network_Samples =
+      output.Archived_Network_Samples.select(kept);
+  } else if (output.Packed_Network_Samples.n_elem > 0) {
+    partial.Packed_Network_Samples = arma::mat(
+      output.Packed_Network_Samples.memptr(),
+      output.Packed_Network_Samples.n_rows, samples);
+  } else if (output.Network_Samples.n_elem > 0) {
+    const arma::cube& networks = output.Network_Samples;
+    partial.Network_Samples = arma::zeros(networks.n_rows, networks.n_cols,
+                                          samples);
+    for (int s = 0; s < samples; ++s) {
+      std::copy(networks.slice_memptr(s),
+                networks.slice_memptr(s) + networks.n_rows * networks.n_cols,
+                partial.Network_Samples.slice_memptr(s));
+    }
+  }
+}
+
+// Number of entries in the packed (column major) lower triangle of an n x n
+// matrix, with or without the diagonal.
+inline int packed_lower_triangle_length(int number_of_nodes, bool include_diagonal) {
+  if (include_diagonal) {
+    return number_of_nodes * (number_of_nodes + 1) / 2;
+  }
+  return number_of_nodes * (number_of_nodes - 1) / 2;
+}
+
+// Size the per iteration diagnostics and the sample storage of a sampler
+// run, for one network type. Undirected networks only store their lower
+// triangle, one column per sample (see packed_lower_triangle_length). When
+// the samples are archived (network_storage other than STORE_DOUBLE)
+// archive_buffer is sized to hold one sample before it is encoded.
+template<bool Undirected, bool IncludeDiagonal, bool Correlation>
+inline void start_sampler_output(int number_of_nodes,
+                                 int number_of_iterations,
+                                 int number_of_samples_to_store,
+                                 int statistics_to_save,
+                                 bool store_networks,
+                                 int network_storage,
+                                 MetropolisHastingsOutput& output,
+                                 arma::vec& archive_buffer) {
+  output.Accept_or_Reject = arma::zeros (number_of_iterations);
+  output.Log_Prob_Accept = arma::zeros (number_of_iterations);
+  output.P_Ratios = arma::zeros (number_of_iterations);
+  output.Q_Ratios = arma::zeros (number_of_iterations);
+  output.Proposed_Density = arma::zeros (number_of_iterations);
+  output.Current_Density = arma::zeros (number_of_iterations);
+  bool pack_networks = Undirected;
+  output.packed_networks = pack_networks;
+  output.Network_Samples.reset();
+  output.Packed_Network_Samples.reset();
+  bool archive_networks = store_networks && network_storage != STORE_DOUBLE;
+  output.network_storage = archive_networks ? network_storage : STORE_DOUBLE;
+  output.cancelled = false;
+  output.Archived_Network_Samples = NetworkSampleArchive();
+  if (archive_networks) {
+    int sample_length = number_of_nodes * number_of_nodes;
+    if (pack_networks) {
+      sample_length = gergm::packed_lower_triangle_length(number_of_nodes,
+                                                          IncludeDiagonal);
+    }
+    // correlations are stored on [-1,1]
+    output.Archived_Network_Samples = NetworkSampleArchive(
+      network_storage, sample_length, Correlation ? -1 : 0, 1);
+    output.Archived_Network_Samples.reserve(number_of_samples_to_store);
+    archive_buffer = arma::zeros(sample_length);
+  } else if (store_networks) {
+    if (pack_networks) {
+      output.Packed_Network_Samples = arma::zeros(
+        gergm::packed_lower_triangle_length(number_of_nodes, IncludeDiagonal),
+        number_of_samples_to_store);
+    } else {
+      output.Network_Samples = arma::zeros (number_of_nodes, number_of_nodes,
+                                            number_of_samples_to_store);
+    }
+  }
+  output.Mean_Edge_Weights = arma::zeros (number_of_samples_to_store);
+  output.Save_H_Statistics = arma::zeros (number_of_samples_to_store,
+                                          statistics_to_save);
+}
+
+// Store reported_network (the network as it is reported, on the correlation
+// scale for correlation networks) as sample number sample of a run set up by
+// start_sampler_output(): its saved statistics, mean edge weight and, if
+// store_networks is true, the network itself.
+template<bool Undirected, bool IncludeDiagonal>
+inline void store_network_sample(const GergmModel& model,
+                                 const arma::mat& reported_network,
+                                 int sample,
+                                 bool store_networks,
+                                 arma::vec& archive_buffer,
+                                 SamplerControl* control,
+                                 MetropolisHastingsOutput& output) {
+  int number_of_nodes = reported_network.n_rows;
+  bool pack_networks = Undirected;
+  bool archive_networks = store_networks &&
+    output.network_storage != STORE_DOUBLE;
+
+  arma::vec save_stats = model.save_network_statistics(reported_network);
+  for (int m = 0; m < int(save_stats.n_elem); ++m) {
+    output.Save_H_Statistics(sample, m) = save_stats[m];
+  }
+
+  double* stored_network = NULL;
+  if (archive_networks) {
+    stored_network = archive_buffer.memptr();
+  } else if (store_networks) {
+    stored_network = pack_networks ?
+      output.Packed_Network_Samples.colptr(sample) :
+      output.Network_Samples.slice_memptr(sample);
+  }
+  double mew = 0;
+  if (pack_networks) {
+    int k = 0;
+    for (int j = 0; j < number_of_nodes; ++j) {
+      for (int i = j; i < number_of_nodes; ++i) {
+        if (i == j) {
+          if (IncludeDiagonal) {
+            double temp = reported_network(i, j);
+            if (store_networks) {
+              stored_network[k] = temp;
+            }
+            k += 1;
+            mew += temp;
+          }
+        } else {
+          double temp = reported_network(i, j);
+          if (store_networks) {
+            stored_network[k] = temp;
+          }
+          k += 1;
+          // off diagonal entries appear in both triangles
+          mew += 2 * temp;
+        }
+      }
+    }
+  } else {
+    for (int i = 0; i < number_of_nodes; ++i) {
+      for (int j = 0; j < number_of_nodes; ++j) {
+        if (IncludeDiagonal || i != j) {
+          //we use this trick to break the referencing
+          double temp = reported_network(i, j);
+          if (store_networks) {
+            stored_network[i + j * number_of_nodes] = temp;
+          }
+          mew += temp;
+        }
+      }
+    }
+  }
+
+  if (IncludeDiagonal) {
+    mew = mew / double(number_of_nodes * number_of_nodes);
+  } else {
+    mew = mew / double(number_of_nodes * (number_of_nodes - 1));
+  }
+  output.Mean_Edge_Weights[sample] = mew;
+  if (archive_networks) {
+    SamplerOutputLock lock(control);
+    output.Archived_Network_Samples.append(stored_network);
+  } else if (store_networks) {
+    if (pack_networks) {
+      GERGM_PROFILE_COUNT(output.profile, bytes_copied,
+                          sizeof(double) * output.Packed_Network_Samples.n_rows);
+    } else {
+      GERGM_PROFILE_COUNT(output.profile, bytes_copied,
+                          sizeof(double) * reported_network.n_elem);
+    }
+  }
+  if (control != NULL) {
+    control->record_sample();
+  }
+}
+
+// Cut the output of a cancelled run down to the iterations and samples it
+// did before stopping.
+inline void keep_cancelled_output(int iterations_run,
+                                  int samples_stored,
+                                  const arma::mat& current_network,
+                                  SamplerControl* control,
+                                  MetropolisHastingsOutput& output) {
+  SamplerOutputLock lock(control);
+  MetropolisHastingsOutput kept;
+  copy_leading_output(output, iterations_run, samples_stored, kept);
+  kept.final_network = current_network;
+  kept.profile = output.profile;
+  kept.cancelled = true;
+  output = kept;
+}
+
+// The Metropolis Hastings sampler for one network type: directed or
+// undirected, with or without a diagonal, and correlation networks (which
+// are undirected). run_metropolis_hastings() picks the instantiation once per
+// call, so none of these are tested inside the loops over edges. If control
+// is not NULL the run reports its progress to it, and stops early when it is
+// cancelled.
+template<bool Undirected, bool IncludeDiagonal, bool Correlation>
+inline void metropolis_hastings_kernel(const GergmModel& model,
+                                       int number_of_iterations,
+                                       double shape_parameter,
+                                       const arma::mat& initial_network,
+                                       int take_sample_every,
+                                       const arma::vec& thetas,
+                                       int seed,
+                                       int number_of_samples_to_store,
+                                       bool parallel,
+                                       bool store_networks,
+                                       int network_storage,
+                                       SamplerControl* control,
+                                       SamplerWorkspace& workspace,
+                                       MetropolisHastingsOutput& output) {
+
+  if (control != NULL) {
+    control->start(number_of_iterations);
+  }
+  int number_of_nodes = model.number_of_nodes;
+  const arma::vec& statistics_to_use = model.statistics_to_use;
+  const arma::Mat<double>& triples = model.triples;
+  const arma::Mat<double>& pairs = model.pairs;
+  const arma::vec& alphas = model.alphas;
+  int together = model.together;
+  const arma::umat& use_selected_rows = model.use_selected_rows;
+  const arma::vec& rows_to_use = model.rows_to_use;
+  const arma::vec& non_base_statistic_indicator =
+    model.non_base_statistic_indicator;
+  double p_ratio_multaplicative_factor = model.p_ratio_multaplicative_factor;
+  double stochastic_MH_proportion = model.stochastic_MH_proportion;
+  bool use_triad_sampling = model.use_triad_sampling;
+  bool use_weighted_triad_sampling = model.use_weighted_triad_sampling;
+
+  // Allocate variables and data structures
+  double variance = shape_parameter;
+  // this is the number of statistics we will be saving (all selected base + non base)
+  int statistics_to_save = model.combined_statistics_to_use.n_elem;
+
+  int MH_Counter = 0;
+  int Storage_Counter = 0;
+  bool current_h_value_is_cached = false;
+  double previous_h_function_value = 0;
+  arma::vec& Accept_or_Reject = output.Accept_or_Reject;
+  arma::vec& Log_Prob_Accept = output.Log_Prob_Accept;
+  arma::vec& P_Ratios = output.P_Ratios;
+  arma::vec& Q_Ratios = output.Q_Ratios;
+  arma::vec& Proposed_Density = output.Proposed_Density;
+  arma::vec& Current_Density = output.Current_Density;
+  // each sample is written here before it is encoded into an archive
+  arma::vec archive_buffer;
+  gergm::start_sampler_output<Undirected, IncludeDiagonal, Correlation>(
+    number_of_nodes, number_of_iterations, number_of_samples_to_store,
+    statistics_to_save, store_networks, network_storage, output,
+    archive_buffer);
+  arma::mat& current_edge_weights = output.final_network;
+  current_edge_weights = initial_network;
+  arma::mat& corr_current_edge_weights = workspace.corr_current_network;
+  corr_current_edge_weights.zeros(number_of_nodes, number_of_nodes);
+  double current_log_jacobian = 0;
+
+  // values for stochastic MH
+  arma::Mat<double>& random_triad_samples = workspace.random_triad_samples;
+  arma::Mat<double>& random_dyad_samples = workspace.random_dyad_samples;
+  random_triad_samples.zeros(2,2);
+  random_dyad_samples.zeros(2,2);
+  int update_triad_samples_every = 10;
+  int triad_sample_update_counter = 0;
+  // the subsamples get their own stream so that the proposals are the same
+  // whether or not we are using stochastic MH.
+  std::seed_seq triad_sample_seed{seed, 1};
+  std::mt19937 triad_sample_generator(triad_sample_seed);
+  bool diagonal_triples = gergm::triples_include_diagonal(number_of_nodes,
+                                                         triples);
+  // values for importance weighted stochastic MH, the Horvitz-Thompson weights
+  // already scale the subsample up to the whole network. The sampling
+  // probabilities take a pass over every triple, so they are only
+  // recalculated on the current network every update_triad_weights_every
+  // iterations (a multiple of update_triad_samples_every).
+  arma::vec& triad_probabilities = workspace.triad_probabilities;
+  arma::vec& alias_probability = workspace.alias_probability;
+  arma::uvec& alias = workspace.alias;
+  int update_triad_weights_every = 100;
+  if (use_weighted_triad_sampling) {
+    p_ratio_multaplicative_factor = 1;
+  }
+
+  // deal with the case where we have a correlation network.
+  if (Correlation) {
+    current_edge_weights.diag() = arma::ones(number_of_nodes);
+    // cache the correlation space network and its log Jacobian, these are
+    // only refreshed when a proposal is accepted.
+    corr_current_edge_weights = gergm::bounded_to_correlations(current_edge_weights);
+    current_log_jacobian = vine::log_jacobian(2*current_edge_weights-1);
+  }
+  // the triad weights are calculated on the network the statistics are
+  // calculated on.
+  const arma::mat& statistic_network = Correlation ?
+    corr_current_edge_weights : current_edge_weights;
+
+  if (use_triad_sampling) {
+    if (use_weighted_triad_sampling) {
+      gergm::draw_weighted_random_triad_samples(statistic_network,
+                                                triples,
+                                                number_of_nodes,
+                                                stochastic_MH_proportion,
+                                                statistics_to_use,
+                                                thetas,
+                                                alphas,
+                                                together,
+                                                non_base_statistic_indicator,
+                                                true,
+                                                triad_probabilities,
+                                                alias_probability,
+                                                alias,
+                                                triad_sample_generator,
+                                                random_triad_samples,
+                                                random_dyad_samples);
+    } else {
+      gergm::draw_random_triad_samples(number_of_nodes,
+                                       stochastic_MH_proportion,
+                                       diagonal_triples,
+                                       triad_sample_generator,
+                                       random_triad_samples,
+                                       random_dyad_samples);
+    }
+  }
+
+
+  // Set RNG and define uniform distribution
+  std::mt19937 generator(seed);
+  random::uniform_01<double> uniform_distribution;
+  // The current and proposed networks are a pair of buffers. Every free edge
+  // of the proposal is redrawn each iteration and the fixed entries (the
+  // diagonal, when it is not modeled) are the same in both, so the proposal
+  // never has to be copied from the current network: accepting swaps the
+  // buffers, and after a rejection the stale proposal is overwritten.
+  arma::mat& proposed_edge_weights = workspace.proposed_network;
+  proposed_edge_weights = current_edge_weights;
+  arma::mat& corr_proposed_edge_weights = workspace.corr_proposed_network;
+  int iterations_run = number_of_iterations;
+  // Outer loop over the number of samples
+  for (int n = 0; n < number_of_iterations; ++n) {
+    double log_prob_accept = 0;
+    GERGM_PROFILE_START(proposal);
+    log_prob_accept += gergm::propose_network<Undirected, IncludeDiagonal>(
+      current_edge_weights,
+      proposed_edge_weights,
+      variance,
+      generator,
+      output.profile);
+
+    GERGM_PROFILE_STOP(output.profile, proposal);
+
+    double proposed_addition = 0;
+    double current_addition = 0;
+    double proposed_log_jacobian = 0;
+
+    // if we are using random triad sampling, then draw fresh triples and
+    // pairs to use
+    if (update_triad_samples_every == triad_sample_update_counter) {
+      if (use_triad_sampling && use_weighted_triad_sampling) {
+        gergm::draw_weighted_random_triad_samples(statistic_network,
+                                                  triples,
+                                                  number_of_nodes,
+                                                  stochastic_MH_proportion,
+                                                  statistics_to_use,
+                                                  thetas,
+                                                  alphas,
+                                                  together,
+                                                  non_base_statistic_indicator,
+                                                  n % update_triad_weights_every == 0,
+                                                  triad_probabilities,
+                                                  alias_probability,
+                                                  alias,
+                                                  triad_sample_generator,
+                                                  random_triad_samples,
+                                                  random_dyad_samples);
+        current_h_value_is_cached = false;
+      } else if (use_triad_sampling) {
+        gergm::draw_random_triad_samples(number_of_nodes,
+                                         stochastic_MH_proportion,
+                                         diagonal_triples,
+                                         triad_sample_generator,
+                                         random_triad_samples,
+                                         random_dyad_samples);
+        // the cached h value was calculated on the old subsample
+        current_h_value_is_cached = false;
+      }
+      triad_sample_update_counter = 0;
+    }
+    triad_sample_update_counter += 1;
+
+    if (Correlation) {
+      GERGM_PROFILE_START(correlation_transform);
+      corr_proposed_edge_weights = gergm::bounded_to_correlations(proposed_edge_weights);
+      GERGM_PROFILE_STOP(output.profile, correlation_transform);
+      GERGM_PROFILE_START(statistic);
+      proposed_addition = gergm::CalculateNetworkStatistics(
+        corr_proposed_edge_weights,
+        statistics_to_use,
+        thetas,
+        triples,
+        pairs,
+        alphas,
+        together,
+        parallel,
+        use_selected_rows,
+        rows_to_use,
+        non_base_statistic_indicator,
+        random_triad_samples,
+        random_dyad_samples,
+        use_triad_sampling,
+        use_weighted_triad_sampling);
+      GERGM_PROFILE_COUNT(output.profile, statistic_evaluations, 1);
+      // the current correlation network only changes on accept, when its h
+      // value is carried over from the proposal
+      if (current_h_value_is_cached) {
+        current_addition = previous_h_function_value;
+      } else {
+        GERGM_PROFILE_COUNT(output.profile, statistic_evaluations, 1);
+        current_addition = gergm::CalculateNetworkStatistics(
+          corr_current_edge_weights,
+          statistics_to_use,
+          thetas,
+          triples,
+          pairs,
+          alphas,
+          together,
+          parallel,
+          use_selected_rows,
+          rows_to_use,
+          non_base_statistic_indicator,
+          random_triad_samples,
+          random_dyad_samples,
+          use_triad_sampling,
+          use_weighted_triad_sampling);
+        previous_h_function_value = current_addition ;
+      }
+      GERGM_PROFILE_STOP(output.profile, statistic);
+    }else{
+      GERGM_PROFILE_START(statistic);
+      GERGM_PROFILE_COUNT(output.profile, statistic_evaluations, 1);
+      proposed_addition = gergm::CalculateNetworkStatistics(
+        proposed_edge_weights,
+        statistics_to_use,
+        thetas,
+        triples,
+        pairs,
+        alphas,
+        together,
+        parallel,
+        use_selected_rows,
+        rows_to_use,
+        non_base_statistic_indicator,
+        random_triad_samples,
+        random_dyad_samples,
+        use_triad_sampling,
+        use_weighted_triad_sampling);
+      // only calculate the h function if we updated the network last round
+      // otherwise use the cached value.
+      if (current_h_value_is_cached) {
+        current_addition = previous_h_function_value;
+      } else {
+        GERGM_PROFILE_COUNT(output.profile, statistic_evaluations, 1);
+        current_addition = gergm::CalculateNetworkStatistics(
+          current_edge_weights,
+          statistics_to_use,
+          thetas,
+          triples,
+          pairs,
+          alphas,
+          together,
+          parallel,
+          use_selected_rows,
+          rows_to_use,
+          non_base_statistic_indicator,
+          random_triad_samples,
+          random_dyad_samples,
+          use_triad_sampling,
+          use_weighted_triad_sampling);
+        previous_h_function_value = current_addition ;
+      }
+      GERGM_PROFILE_STOP(output.profile, statistic);
+    }
+
+    // store some additional diagnostics h value is the last entry
+    P_Ratios[n] = p_ratio_multaplicative_factor * (proposed_addition -
+      current_addition);
+    Q_Ratios[n] = log_prob_accept;
+
+    double total_edges = double(number_of_nodes * (number_of_nodes - 1));
+    if (IncludeDiagonal) {
+      total_edges = double(number_of_nodes * number_of_nodes);
+    }
+    double temp1 = arma::accu(proposed_edge_weights);
+    Proposed_Density[n] = temp1/total_edges;
+    double temp2 = arma::accu(current_edge_weights);
+    Current_Density[n] = temp2/total_edges;
+
+    // now we add in a p-ratio multaplicative factor incase we are randomly
+    // downsampling
+    log_prob_accept += p_ratio_multaplicative_factor * (proposed_addition -
+      current_addition);
+
+    if (Correlation) {
+      // now add in the bit about Jacobians
+      GERGM_PROFILE_START(correlation_transform);
+      proposed_log_jacobian = vine::log_jacobian(2*proposed_edge_weights-1);
+      GERGM_PROFILE_STOP(output.profile, correlation_transform);
+      log_prob_accept += proposed_log_jacobian - current_log_jacobian;
+    }
+
+    GERGM_PROFILE_START(accept);
+    double rand_num = uniform_distribution(generator);
+    double lud = 0;
+    lud = log(rand_num);
+
+    double accept_proportion = 0;
+    // Accept or reject the new proposed positions
+    if (log_prob_accept < lud) {
+      accept_proportion +=0;
+      current_h_value_is_cached = true;
+    } else {
+      accept_proportion +=1;
+      // the proposed network becomes the current one, so carry its h value
+      // (and correlation space quantities) over rather than recomputing them.
+      current_h_value_is_cached = true;
+      previous_h_function_value = proposed_addition;
+      if (Correlation) {
+        corr_current_edge_weights.swap(corr_proposed_edge_weights);
+        current_log_jacobian = proposed_log_jacobian;
+      }
+      current_edge_weights.swap(proposed_edge_weights);
+    }
+
+    GERGM_PROFILE_STOP(output.profile, accept);
+
+    Log_Prob_Accept[n] = log_prob_accept;
+    Accept_or_Reject[n] = accept_proportion;
+    Storage_Counter += 1;
+
+    // Save network statistics
+    if (Storage_Counter == take_sample_every) {
+      GERGM_PROFILE_START(storage);
+      // the network as it is reported, on the correlation scale for
+      // correlation networks
+      const arma::mat& reported_network = Correlation ?
+        corr_current_edge_weights : current_edge_weights;
+      gergm::store_network_sample<Undirected, IncludeDiagonal>(
+        model, reported_network, MH_Counter, store_networks, archive_buffer,
+        control, output);
+      GERGM_PROFILE_STOP(output.profile, storage);
+      Storage_Counter = 0;
+      MH_Counter += 1;
+    }
+
+    if (control != NULL) {
+      control->record_iteration(accept_proportion > 0);
+      if (control->cancel_requested()) {
+        iterations_run = n + 1;
+        break;
+      }
+    }
+  }
+
+  // a cancelled run keeps what it did before stopping
+  if (iterations_run < number_of_iterations) {
+    gergm::keep_cancelled_output(iterations_run, MH_Counter,
+                                 current_edge_weights, control, output);
+  }
+}
+
+typedef void (*MetropolisHastingsKernel)(const GergmModel&, int, double,
+                                         const arma::mat&, int,
+                                         const arma::vec&, int, int, bool,
+                                         bool, int, SamplerControl*,
+                                         SamplerWorkspace&,
+                                         MetropolisHastingsOutput&);
+
+inline MetropolisHastingsKernel select_metropolis_hastings_kernel(
+    const GergmModel& model) {
+  if (model.using_correlation_network == 1) {
+    if (model.include_diagonal) {
+      return &metropolis_hastings_kernel<true, true, true>;
+    }
+    return &metropolis_hastings_kernel<true, false, true>;
+  }
+  if (model.undirect_network == 1) {
+    if (model.include_diagonal) {
+      return &metropolis_hastings_kernel<true, true, false>;
+    }
+    return &metropolis_hastings_kernel<true, false, false>;
+  }
+  if (model.include_diagonal) {
+    return &metropolis_hastings_kernel<false, true, false>;
+  }
+  return &metropolis_hastings_kernel<false, false, false>;
+}
+
+// The Metropolis Hastings sampler for a compiled model. If store_networks is
+// false the sampled networks are not kept, only their statistics. Otherwise
+// network_storage (a NetworkStorage) picks how they are kept. control may be
+// NULL, see sampler_control.h. The run works in workspace, see
+// SamplerWorkspace.
+inline void run_metropolis_hastings(const GergmModel& model,
+                                    int number_of_iterations,
+                                    double shape_parameter,
+                                    const arma::mat& initial_network,
+                                    int take_sample_every,
+                                    const arma::vec& thetas,
+                                    int seed,
+                                    int number_of_samples_to_store,
+                                    bool parallel,
+                                    bool store_networks,
+                                    int network_storage,
+                                    SamplerControl* control,
+                                    SamplerWorkspace& workspace,
+                                    MetropolisHastingsOutput& output) {
+  MetropolisHastingsKernel kernel = select_metropolis_hastings_kernel(model);
+  kernel(model,
+         number_of_iterations,
+         shape_parameter,
+         initial_network,
+         take_sample_every,
+         thetas,
+         seed,
+         number_of_samples_to_store,
+         parallel,
+         store_networks,
+         network_storage,
+         control,
+         workspace,
+         output);
+}
+
+inline void run_metropolis_hastings(const GergmModel& model,
+                                    int number_of_iterations,
+                                    double shape_parameter,
+                                    const arma::mat& initial_network,
+                                    int take_sample_every,
+                                    const arma::vec& thetas,
+                                    int seed,
+                                    int number_of_samples_to_store,
+                                    bool parallel,
+                                    bool store_networks,
+                                    int network_storage,
+                                    SamplerControl* control,
+                                    MetropolisHastingsOutput& output) {
+  SamplerWorkspace workspace;
+  run_metropolis_hastings(model, number_of_iterations, shape_parameter,
+                          initial_network, take_sample_every, thetas, seed,
+                          number_of_samples_to_store, parallel,
+                          store_networks, network_storage, control, workspace,
+                          output);
+}
+
+inline void run_metropolis_hastings(const GergmModel& model,
+                                    int number_of_iterations,
+                                    double shape_parameter,
+                                    const arma::mat& initial_network,
+                                    int take_sample_every,
+                                    const arma::vec& thetas,
+                                    int seed,
+                                    int number_of_samples_to_store,
+                                    bool parallel,
+                                    bool store_networks,
+                                    int network_storage,
+                                    MetropolisHastingsOutput& output) {
+  run_metropolis_hastings(model, number_of_iterations, shape_parameter,
+                          initial_network, take_sample_every, thetas, seed,
+                          number_of_samples_to_store, parallel,
+                          store_networks, network_storage, NULL, output);
+}
+
+inline void run_metropolis_hastings(const GergmModel& model,
+                                    int number_of_iterations,
+                                    double shape_parameter,
+                                    const arma::mat& initial_network,
+                                    int take_sample_every,
+                                    const arma::vec& thetas,
+                                    int seed,
+                                    int number_of_samples_to_store,
+                                    bool parallel,
+                                    bool store_networks,
+                                    MetropolisHastingsOutput& output) {
+  run_metropolis_hastings(model, number_of_iterations, shape_parameter,
+                          initial_network, take_sample_every, thetas, seed,
+                          number_of_samples_to_store, parallel,
+                          store_networks, STORE_DOUBLE, output);
+}
+
+} // end of gergm namespace
+
+#endif
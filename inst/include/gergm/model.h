@@ -0,0 +1,170 @@
+#ifndef GERGM_MODEL_H
+#define GERGM_MODEL_H
+
+// A compiled model specification.
+
+#include <algorithm>
+#include <armadillo>
+#include "network_statistics.h"
+
+namespace gergm {
+
+  // Everything about a model specification that stays the same from one
+  // simulation to the next. This is built once per GERGM object (see
+  // Create_GERGM_Model) and held in an external pointer by R, so repeated
+  // MCMCMLE rounds only pass thetas and the starting network across.
+  struct GergmModel {
+    int number_of_nodes;
+    arma::vec statistics_to_use;
+    arma::Mat<double> triples;
+    arma::Mat<double> pairs;
+    arma::vec alphas;
+    int together;
+    int using_correlation_network;
+    int undirect_network;
+    arma::umat use_selected_rows;
+    arma::umat save_statistics_selected_rows_matrix;
+    arma::vec rows_to_use;
+    arma::vec base_statistics_to_save;
+    arma::vec base_statistic_alphas;
+    int num_non_base_statistics;
+    arma::vec non_base_statistic_indicator;
+    double p_ratio_multaplicative_factor;
+    double stochastic_MH_proportion;
+    bool use_triad_sampling;
+    bool use_weighted_triad_sampling;
+    bool include_diagonal;
+
+    // the statistics we save for every sampled network, laid out once by
+    // plan_saved_statistics()
+    arma::vec combined_statistics_to_use;
+    arma::vec combined_alphas;
+    arma::vec combined_rows_to_use;
+    arma::vec combined_non_base_statistic_indicator;
+
+    // the statistics the MPLE objectives use: only the statistics in the
+    // model, calculated on use_selected_rows, laid out the same way
+    arma::vec mple_statistics_to_use;
+    arma::vec mple_alphas;
+    arma::vec mple_rows_to_use;
+    arma::vec mple_non_base_statistic_indicator;
+
+    // stand ins for the triad samples, which the saved statistics never use
+    arma::Mat<double> unused_triad_samples;
+    arma::Mat<double> unused_dyad_samples;
+
+    GergmModel(int number_of_nodes,
+               arma::vec statistics_to_use,
+               arma::Mat<double> triples,
+               arma::Mat<double> pairs,
+               arma::vec alphas,
+               int together,
+               int using_correlation_network,
+               int undirect_network,
+               arma::umat use_selected_rows,
+               arma::umat save_statistics_selected_rows_matrix,
+               arma::vec rows_to_use,
+               arma::vec base_statistics_to_save,
+               arma::vec base_statistic_alphas,
+               int num_non_base_statistics,
+               arma::vec non_base_statistic_indicator,
+               double p_ratio_multaplicative_factor,
+               double stochastic_MH_proportion,
+               bool use_triad_sampling,
+               bool use_weighted_triad_sampling,
+               bool include_diagonal)
+      : number_of_nodes(number_of_nodes),
+        statistics_to_use(statistics_to_use),
+        triples(triples),
+        pairs(pairs),
+        alphas(alphas),
+        together(together),
+        using_correlation_network(using_correlation_network),
+        undirect_network(undirect_network),
+        use_selected_rows(use_selected_rows),
+        save_statistics_selected_rows_matrix(save_statistics_selected_rows_matrix),
+        rows_to_use(rows_to_use),
+        base_statistics_to_save(base_statistics_to_save),
+        base_statistic_alphas(base_statistic_alphas),
+        num_non_base_statistics(num_non_base_statistics),
+        non_base_statistic_indicator(non_base_statistic_indicator),
+        p_ratio_multaplicative_factor(p_ratio_multaplicative_factor),
+        stochastic_MH_proportion(stochastic_MH_proportion),
+        use_triad_sampling(use_triad_sampling),
+        use_weighted_triad_sampling(use_weighted_triad_sampling),
+        include_diagonal(include_diagonal) {
+      plan_saved_statistics(statistics_to_use,
+                            base_statistics_to_save,
+                            base_statistic_alphas,
+                            alphas,
+                            rows_to_use,
+                            num_non_base_statistics,
+                            non_base_statistic_indicator,
+                            combined_statistics_to_use,
+                            combined_alphas,
+                            combined_rows_to_use,
+                            combined_non_base_statistic_indicator);
+
+      // the base statistics in the model, with the weights lined up the way
+      // extended_weighted_mple_objective() has always received them
+      arma::vec model_base_statistics = arma::zeros(
+        statistics_to_use.n_elem - num_non_base_statistics);
+      int counter = 0;
+      for (int i = 0; i < int(statistics_to_use.n_elem); ++i) {
+        if (non_base_statistic_indicator[i] == 0) {
+          model_base_statistics[counter] = statistics_to_use[i];
+          counter += 1;
+        }
+      }
+      plan_saved_statistics(statistics_to_use,
+                            model_base_statistics,
+                            alphas,
+                            alphas,
+                            rows_to_use,
+                            num_non_base_statistics,
+                            non_base_statistic_indicator,
+                            mple_statistics_to_use,
+                            mple_alphas,
+                            mple_rows_to_use,
+                            mple_non_base_statistic_indicator);
+
+      int most_statistics = int(std::max(combined_statistics_to_use.n_elem,
+                                         mple_statistics_to_use.n_elem));
+      unused_triad_samples = arma::zeros(2, most_statistics);
+      unused_dyad_samples = arma::zeros(2, most_statistics);
+    }
+
+    arma::vec save_network_statistics(const arma::mat& current_network) const {
+      return calculate_saved_statistics(current_network,
+                                        combined_statistics_to_use,
+                                        combined_alphas,
+                                        combined_rows_to_use,
+                                        combined_non_base_statistic_indicator,
+                                        triples,
+                                        pairs,
+                                        together,
+                                        save_statistics_selected_rows_matrix,
+                                        unused_triad_samples,
+                                        unused_dyad_samples);
+    }
+
+    // The statistics of the model itself (no extra base statistics), in the
+    // order of the thetas the MPLE objectives take.
+    arma::vec mple_network_statistics(const arma::mat& current_network) const {
+      return calculate_saved_statistics(current_network,
+                                        mple_statistics_to_use,
+                                        mple_alphas,
+                                        mple_rows_to_use,
+                                        mple_non_base_statistic_indicator,
+                                        triples,
+                                        pairs,
+                                        together,
+                                        use_selected_rows,
+                                        unused_triad_samples,
+                                        unused_dyad_samples);
+    }
+  };
+
+} // end of gergm namespace
+
+#endif
@@ -0,0 +1,552 @@
+#ifndef GERGM_MPLE_INTEGRATION_H
+#define GERGM_MPLE_INTEGRATION_H
+
+// Numerical integration over a single edge (or pair of edges for the
+// distribution estimator) used by the weighted MPLE objectives.
+
+#include <algorithm>
+#include <armadillo>
+#include <cmath>
+#include <vector>
+#include "model.h"
+#include "network_statistics.h"
+#include "parallel.h"
+
+namespace gergm {
+
+using std::exp;
+using std::log;
+
+  // Function that will calculate h statistics
+  inline double integrand(arma::mat current_network,
+                          arma::vec statistics_to_use,
+                          arma::vec thetas,
+                          arma::Mat<double> triples,
+                          arma::Mat<double> pairs,
+                          arma::umat save_statistics_selected_rows_matrix,
+                          arma::vec rows_to_use,
+                          arma::vec base_statistics_to_save,
+                          arma::vec base_statistic_alphas,
+                          int num_non_base_statistics,
+                          arma::vec non_base_statistic_indicator,
+                          arma::vec alphas,
+                          int together,
+                          int sender,
+                          int recipient,
+                          double edge_value) {
+
+    if (edge_value != -1) {
+      // assign the current edge value in the current spot
+      current_network(sender,recipient) = edge_value;
+    }
+
+    // calculate theta times the current statistics.
+    arma::vec save_stats = gergm::save_network_statistics(
+      current_network,
+      statistics_to_use,
+      base_statistics_to_save,
+      base_statistic_alphas,
+      triples,
+      pairs,
+      alphas,
+      together,
+      save_statistics_selected_rows_matrix,
+      rows_to_use,
+      num_non_base_statistics,
+      non_base_statistic_indicator);
+
+    // now multiply thetas by the statistics
+    int num_theta = thetas.n_elem;
+    double to_return = 0;
+    for (int i = 0; i < num_theta; ++i) {
+      to_return += thetas[i] * save_stats[i];
+    }
+    return to_return;
+  };
+
+  // Function that will calculate h statistics and multiply by theta for the
+  // distribution estimator
+  inline double distribution_integrand(arma::mat current_network,
+                   arma::vec statistics_to_use,
+                   arma::vec thetas,
+                   arma::Mat<double> triples,
+                   arma::Mat<double> pairs,
+                   arma::umat save_statistics_selected_rows_matrix,
+                   arma::vec rows_to_use,
+                   arma::vec base_statistics_to_save,
+                   arma::vec base_statistic_alphas,
+                   int num_non_base_statistics,
+                   arma::vec non_base_statistic_indicator,
+                   arma::vec alphas,
+                   int together,
+                   int row,
+                   int col1,
+                   int col2,
+                   double edge_value,
+                   double edge_value2) {
+
+    // note that for now, I am not removing col2. Edge_value2 is now the current
+    // true edge value
+    if (edge_value != -1) {
+      // assign the current edge value in the current spot
+      current_network(row,col1) = edge_value;
+      current_network(row,col2) = edge_value2;
+      // int num_nodes = current_network.n_cols;
+      // for (int i = 0; i < num_nodes; ++i) {
+      //   if (i != col1) {
+      //     double cur = current_network(row,i);
+      //     //deal with care of a point mass
+      //     if (edge_value2 == 1) {
+      //       current_network(row,i) = double(1/double(num_nodes - 1)) * (1 - edge_value);
+      //     } else {
+      //       current_network(row,i) = (cur / double(1 - edge_value2)) * (1 - edge_value);
+      //     }
+      //   }
+      // }
+    }
+
+    // calculate theta times the current statistics.
+    arma::vec save_stats = gergm::save_network_statistics(
+      current_network,
+      statistics_to_use,
+      base_statistics_to_save,
+      base_statistic_alphas,
+      triples,
+      pairs,
+      alphas,
+      together,
+      save_statistics_selected_rows_matrix,
+      rows_to_use,
+      num_non_base_statistics,
+      non_base_statistic_indicator);
+
+    // now multiply thetas by the statistics
+    int num_theta = thetas.n_elem;
+    double to_return = 0;
+    for (int i = 0; i < num_theta; ++i) {
+      to_return += thetas[i] * save_stats[i];
+    }
+    return to_return;
+  };
+
+
+  // integrand() at every point of integration_interval, spread over
+  // parallel_for(). integrand() takes its own copy of the network, so the
+  // evaluations do not interfere with each other.
+  inline arma::vec parallel_integration(
+      arma::mat current_network,
+      arma::vec statistics_to_use,
+      arma::vec thetas,
+      arma::Mat<double> triples,
+      arma::Mat<double> pairs,
+      arma::umat save_statistics_selected_rows_matrix,
+      arma::vec rows_to_use,
+      arma::vec base_statistics_to_save,
+      arma::vec base_statistic_alphas,
+      int num_non_base_statistics,
+      arma::vec non_base_statistic_indicator,
+      arma::vec alphas,
+      int together,
+      int sender,
+      int recipient,
+      arma::vec integration_interval) {
+
+    int innterval_size = integration_interval.n_elem;
+    arma::vec return_vec = arma::zeros(innterval_size);
+
+    gergm::parallel_for(0, innterval_size,
+                        [&](std::size_t begin, std::size_t end) {
+      for (std::size_t i = begin; i < end; i++) {
+        return_vec[i] = gergm::integrand(current_network,
+                                         statistics_to_use,
+                                         thetas,
+                                         triples,
+                                         pairs,
+                                         save_statistics_selected_rows_matrix,
+                                         rows_to_use,
+                                         base_statistics_to_save,
+                                         base_statistic_alphas,
+                                         num_non_base_statistics,
+                                         non_base_statistic_indicator,
+                                         alphas,
+                                         together,
+                                         sender,
+                                         recipient,
+                                         integration_interval[i]);
+      }
+    });
+
+    return return_vec;
+  };
+
+  // do the same thing for distributions
+  inline arma::vec distribution_parallel_integration(
+      arma::mat current_network,
+      arma::vec statistics_to_use,
+      arma::vec thetas,
+      arma::Mat<double> triples,
+      arma::Mat<double> pairs,
+      arma::umat save_statistics_selected_rows_matrix,
+      arma::vec rows_to_use,
+      arma::vec base_statistics_to_save,
+      arma::vec base_statistic_alphas,
+      int num_non_base_statistics,
+      arma::vec non_base_statistic_indicator,
+      arma::vec alphas,
+      int together,
+      int row,
+      int col1,
+      int col2,
+      arma::vec integration_interval) {
+
+    int innterval_size = integration_interval.n_elem;
+    arma::vec return_vec = arma::zeros(innterval_size);
+
+    gergm::parallel_for(0, innterval_size,
+                        [&](std::size_t begin, std::size_t end) {
+      for (std::size_t i = begin; i < end; i++) {
+        // for the pairwise version
+        double edge1 = current_network(row,col1);
+        double edge2 = current_network(row,col2);
+        // sum them
+        double cur_sum = edge1 + edge2;
+        //divy them up to the two new edge values to try
+        edge1 = integration_interval[i] * cur_sum;
+        edge2 = (1 - integration_interval[i]) * cur_sum;
+
+        return_vec[i] = gergm::distribution_integrand(
+          current_network,
+          statistics_to_use,
+          thetas,
+          triples,
+          pairs,
+          save_statistics_selected_rows_matrix,
+          rows_to_use,
+          base_statistics_to_save,
+          base_statistic_alphas,
+          num_non_base_statistics,
+          non_base_statistic_indicator,
+          alphas,
+          together,
+          row,
+          col1,
+          col2,
+          edge1,
+          edge2);
+      }
+    });
+
+    return return_vec;
+  };
+
+  inline double log_sum_exp_integrator (arma::mat current_network,
+                                        arma::vec statistics_to_use,
+                                        arma::vec thetas,
+                                        arma::Mat<double> triples,
+                                        arma::Mat<double> pairs,
+                                        arma::umat save_statistics_selected_rows_matrix,
+                                        arma::vec rows_to_use,
+                                        arma::vec base_statistics_to_save,
+                                        arma::vec base_statistic_alphas,
+                                        int num_non_base_statistics,
+                                        arma::vec non_base_statistic_indicator,
+                                        arma::vec alphas,
+                                        int together,
+                                        int sender,
+                                        int recipient,
+                                        arma::vec integration_interval,
+                                        bool parallel) {
+
+    int num_evaluations = integration_interval.n_elem;
+    arma::vec integral_evaluations = arma::zeros(num_evaluations);
+
+    if (parallel) {
+      integral_evaluations = parallel_integration(
+        current_network,
+        statistics_to_use,
+        thetas,
+        triples,
+        pairs,
+        save_statistics_selected_rows_matrix,
+        rows_to_use,
+        base_statistics_to_save,
+        base_statistic_alphas,
+        num_non_base_statistics,
+        non_base_statistic_indicator,
+        alphas,
+        together,
+        sender,
+        recipient,
+        integration_interval);
+    } else {
+      for (int i = 0; i < num_evaluations; ++i) {
+        integral_evaluations[i] = integrand(current_network,
+                                            statistics_to_use,
+                                            thetas,
+                                            triples,
+                                            pairs,
+                                            save_statistics_selected_rows_matrix,
+                                            rows_to_use,
+                                            base_statistics_to_save,
+                                            base_statistic_alphas,
+                                            num_non_base_statistics,
+                                            non_base_statistic_indicator,
+                                            alphas,
+                                            together,
+                                            sender,
+                                            recipient,
+                                            integration_interval[i]);
+      }
+    }
+
+
+    // find the max on the interval
+    double max_val = arma::max(integral_evaluations);
+
+    // now calculate log sum exp, the same sum with or without parallel
+    std::vector<double> exp_terms(num_evaluations);
+    for (int i = 0; i < num_evaluations; ++i) {
+      exp_terms[i] = exp(integral_evaluations[i] - max_val);
+    }
+    double sum_term = gergm::pairwise_sum(exp_terms.data(), num_evaluations);
+
+    // we are taking the average
+    sum_term = sum_term/double(num_evaluations);
+
+    sum_term = max_val + log(sum_term);
+
+    return sum_term;
+
+  };
+
+  // now do the same thing for the distribution estimator
+  inline double distribution_log_sum_exp_integrator (arma::mat current_network,
+                                 arma::vec statistics_to_use,
+                                 arma::vec thetas,
+                                 arma::Mat<double> triples,
+                                 arma::Mat<double> pairs,
+                                 arma::umat save_statistics_selected_rows_matrix,
+                                 arma::vec rows_to_use,
+                                 arma::vec base_statistics_to_save,
+                                 arma::vec base_statistic_alphas,
+                                 int num_non_base_statistics,
+                                 arma::vec non_base_statistic_indicator,
+                                 arma::vec alphas,
+                                 int together,
+                                 int row,
+                                 int col1,
+                                 int col2,
+                                 arma::vec integration_interval,
+                                 bool parallel) {
+
+    int num_evaluations = integration_interval.n_elem;
+    arma::vec integral_evaluations = arma::zeros(num_evaluations);
+
+    if (parallel) {
+      integral_evaluations = distribution_parallel_integration(
+        current_network,
+        statistics_to_use,
+        thetas,
+        triples,
+        pairs,
+        save_statistics_selected_rows_matrix,
+        rows_to_use,
+        base_statistics_to_save,
+        base_statistic_alphas,
+        num_non_base_statistics,
+        non_base_statistic_indicator,
+        alphas,
+        together,
+        row,
+        col1,
+        col2,
+        integration_interval);
+    } else {
+      for (int i = 0; i < num_evaluations; ++i) {
+        //determine hte edge values to pass in
+        //get the current values
+        // double edge1 = integration_interval[i];
+        // double edge2 = current_network(row,col1);
+
+
+        double edge1 = current_network(row,col1);
+        double edge2 = current_network(row,col2);
+        // sum them
+        double cur_sum = edge1 + edge2;
+        //divy them up to the two new edge values to try
+        edge1 = integration_interval[i] * cur_sum;
+        edge2 = (1 - integration_interval[i]) * cur_sum;
+
+        integral_evaluations[i] = distribution_integrand(current_network,
+                                            statistics_to_use,
+                                            thetas,
+                                            triples,
+                                            pairs,
+                                            save_statistics_selected_rows_matrix,
+                                            rows_to_use,
+                                            base_statistics_to_save,
+                                            base_statistic_alphas,
+                                            num_non_base_statistics,
+                                            non_base_statistic_indicator,
+                                            alphas,
+                                            together,
+                                            row,
+                                            col1,
+                                            col2,
+                                            edge1,
+                                            edge2);
+      }
+    }
+
+
+    // find the max on the interval
+    double max_val = arma::max(integral_evaluations);
+
+    // now calculate log sum exp, the same sum with or without parallel
+    std::vector<double> exp_terms(num_evaluations);
+    for (int i = 0; i < num_evaluations; ++i) {
+      exp_terms[i] = exp(integral_evaluations[i] - max_val);
+    }
+    double sum_term = gergm::pairwise_sum(exp_terms.data(), num_evaluations);
+
+    // we are taking the average
+    sum_term = sum_term/double(num_evaluations);
+
+    sum_term = max_val + log(sum_term);
+
+    return sum_term;
+
+  };
+
+  // theta times the model statistics of network
+  inline double model_integrand(const GergmModel& model,
+                                const arma::vec& thetas,
+                                const arma::mat& network) {
+    arma::vec save_stats = model.mple_network_statistics(network);
+    int num_theta = thetas.n_elem;
+    double to_return = 0;
+    for (int i = 0; i < num_theta; ++i) {
+      to_return += thetas[i] * save_stats[i];
+    }
+    return to_return;
+  }
+
+  // log of the mean of exp(values), the integral over one edge
+  inline double log_mean_exp(const std::vector<double>& values) {
+    int num_evaluations = values.size();
+    double max_val = *std::max_element(values.begin(), values.end());
+    std::vector<double> exp_terms(num_evaluations);
+    for (int i = 0; i < num_evaluations; ++i) {
+      exp_terms[i] = exp(values[i] - max_val);
+    }
+    double sum_term = gergm::pairwise_sum(exp_terms.data(), num_evaluations);
+    return max_val + log(sum_term/double(num_evaluations));
+  }
+
+  // The weighted MPLE objective of a compiled model: for every edge, theta
+  // times the statistics of network, less the log of the mean over
+  // integration_interval of exp(theta times the statistics) with that edge
+  // set to each point. The same value as extended_weighted_mple_objective()
+  // on the model's statistics.
+  //
+  // The statistics of the unchanged network are the same for every edge, so
+  // they are calculated once. Edges are spread over parallel_for() when
+  // parallel is true. Each block works on its own copy of the network,
+  // changing one edge at a time and putting it back, rather than copying the
+  // network for every point of integration. The edge terms are added up in
+  // order afterwards, so the value does not depend on the number of threads.
+  inline double mple_objective(const GergmModel& model,
+                               const arma::vec& thetas,
+                               const arma::mat& network,
+                               const arma::vec& integration_interval,
+                               bool parallel) {
+    int number_of_nodes = network.n_rows;
+    int num_evaluations = integration_interval.n_elem;
+    double observed_value = model_integrand(model, thetas, network);
+    std::vector<double> edge_integrals(number_of_nodes * number_of_nodes);
+
+    RangeBody integrate_edges = [&](std::size_t begin, std::size_t end) {
+      arma::mat workspace = network;
+      std::vector<double> integral_evaluations(num_evaluations);
+      for (std::size_t e = begin; e < end; e++) {
+        int i = e / number_of_nodes;
+        int j = e % number_of_nodes;
+        double edge_value = workspace(i, j);
+        for (int k = 0; k < num_evaluations; ++k) {
+          workspace(i, j) = integration_interval[k];
+          integral_evaluations[k] = model_integrand(model, thetas, workspace);
+        }
+        workspace(i, j) = edge_value;
+        edge_integrals[e] = log_mean_exp(integral_evaluations);
+      }
+    };
+    if (parallel) {
+      gergm::parallel_for(0, edge_integrals.size(), integrate_edges);
+    } else {
+      integrate_edges(0, edge_integrals.size());
+    }
+
+    double objective = 0;
+    for (std::size_t e = 0; e < edge_integrals.size(); ++e) {
+      objective += observed_value - edge_integrals[e];
+    }
+    return objective;
+  }
+
+  // mple_objective() for the distribution estimator, the same value as
+  // mple_distribution_objective(). For every row and pair of columns the
+  // integral moves the total weight of the two edges between them.
+  inline double mple_distribution_objective(
+      const GergmModel& model,
+      const arma::vec& thetas,
+      const arma::mat& network,
+      const arma::vec& integration_interval,
+      bool parallel) {
+    int number_of_nodes = network.n_rows;
+    int num_evaluations = integration_interval.n_elem;
+    int pairs_per_row = number_of_nodes * (number_of_nodes - 1) / 2;
+    double observed_value = model_integrand(model, thetas, network);
+    std::vector<double> pair_integrals(number_of_nodes * pairs_per_row);
+
+    RangeBody integrate_pairs = [&](std::size_t begin, std::size_t end) {
+      arma::mat workspace = network;
+      std::vector<double> integral_evaluations(num_evaluations);
+      for (std::size_t e = begin; e < end; e++) {
+        // pairs run over (j, k) with k < j, as in mple_distribution_objective()
+        int row = e / pairs_per_row;
+        int pair = e % pairs_per_row;
+        int col1 = 1;
+        while (pair >= col1) {
+          pair -= col1;
+          col1 += 1;
+        }
+        int col2 = pair;
+        double edge1 = workspace(row, col1);
+        double edge2 = workspace(row, col2);
+        double cur_sum = edge1 + edge2;
+        for (int k = 0; k < num_evaluations; ++k) {
+          workspace(row, col1) = integration_interval[k] * cur_sum;
+          workspace(row, col2) = (1 - integration_interval[k]) * cur_sum;
+          integral_evaluations[k] = model_integrand(model, thetas, workspace);
+        }
+        workspace(row, col1) = edge1;
+        workspace(row, col2) = edge2;
+        pair_integrals[e] = log_mean_exp(integral_evaluations);
+      }
+    };
+    if (parallel) {
+      gergm::parallel_for(0, pair_integrals.size(), integrate_pairs);
+    } else {
+      integrate_pairs(0, pair_integrals.size());
+    }
+
+    double objective = 0;
+    for (std::size_t e = 0; e < pair_integrals.size(); ++e) {
+      objective += observed_value - pair_integrals[e];
+    }
+    return objective;
+  }
+
+} // end of gergm namespace
+
+#endif
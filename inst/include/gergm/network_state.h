@@ -0,0 +1,80 @@
+#ifndef GERGM_NETWORK_STATE_H
+#define GERGM_NETWORK_STATE_H
+
+// Proposals that only change a few edges of a network. The samplers keep a
+// proposed network alongside the current one. Rather than copying the whole
+// network into the proposal every iteration, changes are made in place and
+// logged with the value they replaced, so that accepting (copy the changed
+// edges to the current network) or rejecting (put the old values back) only
+// touches the edges that changed.
+
+#include <armadillo>
+#include <cstddef>
+#include <vector>
+
+namespace gergm {
+
+class EdgeUndoLog {
+public:
+  // capacity is the most entries a single proposal will change, reserving it
+  // up front means logging never allocates inside the sampler loop.
+  explicit EdgeUndoLog(std::size_t capacity = 0) {
+    entries.reserve(capacity);
+  }
+
+  // Set network(i, j) to value, remembering the old value.
+  void set(arma::mat& network, arma::uword i, arma::uword j, double value) {
+    arma::uword index = i + j * network.n_rows;
+    double* memory = network.memptr();
+    Entry entry;
+    entry.index = index;
+    entry.previous_value = memory[index];
+    entries.push_back(entry);
+    memory[index] = value;
+  }
+
+  // Copy the logged entries of from into to (accept), leaving out any on the
+  // diagonal unless include_diagonal is true.
+  void apply(const arma::mat& from,
+             arma::mat& to,
+             bool include_diagonal = true) const {
+    const double* source = from.memptr();
+    double* destination = to.memptr();
+    arma::uword diagonal_stride = from.n_rows + 1;
+    for (std::size_t e = 0; e < entries.size(); ++e) {
+      arma::uword index = entries[e].index;
+      if (include_diagonal || index % diagonal_stride != 0) {
+        destination[index] = source[index];
+      }
+    }
+  }
+
+  // Restore the logged entries of network, latest first so that an edge
+  // changed twice gets its original value back (reject).
+  void undo(arma::mat& network) const {
+    double* memory = network.memptr();
+    for (std::size_t e = entries.size(); e > 0; --e) {
+      memory[entries[e - 1].index] = entries[e - 1].previous_value;
+    }
+  }
+
+  // Forget the logged entries, keeping the memory for the next proposal.
+  void clear() {
+    entries.clear();
+  }
+
+  std::size_t size() const {
+    return entries.size();
+  }
+
+private:
+  struct Entry {
+    arma::uword index;
+    double previous_value;
+  };
+  std::vector<Entry> entries;
+};
+
+} // end of gergm namespace
+
+#endif
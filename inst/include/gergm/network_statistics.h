@@ -0,0 +1,841 @@
+#ifndef GERGM_NETWORK_STATISTICS_H
+#define GERGM_NETWORK_STATISTICS_H
+
+// The base network statistics, the h function theta' h(net) used by the
+// samplers and the statistics saved for each sampled network.
+
+#include <armadillo>
+#include <cmath>
+#include <vector>
+#include "parallel.h"
+
+namespace gergm {
+
+using std::pow;
+
+// Function to calculate the number of out 2-stars
+inline double Out2Star(const arma::mat& net,
+                       const arma::mat& triples,
+                       double alpha,
+                       int together) {
+
+  int number_of_triples = triples.n_rows;
+  double st1 = 0;
+  double st2 = 0;
+  double st3 = 0;
+
+  double to_return = 0;
+  if (together == 1) {
+    for (int i = 0; i < number_of_triples; ++i) {
+      st1 += net(triples(i, 0), triples(i, 1)) * net(triples(i, 0),
+                 triples(i, 2));
+      st2 += net(triples(i, 1), triples(i, 0)) * net(triples(i, 1),
+                 triples(i, 2));
+      st3 += net(triples(i, 2), triples(i, 0)) * net(triples(i, 2),
+                 triples(i, 1));
+    }
+    to_return = pow((st1 + st2 + st3), alpha);
+  } else {
+    for (int i = 0; i < number_of_triples; ++i) {
+      st1 += pow(net(triples(i, 0), triples(i, 1)), alpha) *
+        pow(net(triples(i, 0), triples(i, 2)), alpha);
+      st2 += pow(net(triples(i, 1), triples(i, 0)), alpha) *
+        pow(net(triples(i, 1), triples(i, 2)), alpha);
+      st3 += pow(net(triples(i, 2), triples(i, 0)), alpha) *
+        pow(net(triples(i, 2),triples(i, 1)), alpha);
+    }
+    to_return = st1 + st2 + st3;
+  }
+  return to_return;
+};
+
+// Function to calculate the number of in 2-stars
+inline double In2Star(const arma::mat& net,
+                      const arma::mat& triples,
+                      double alpha,
+                      int together) {
+
+  int number_of_triples = triples.n_rows;
+  double st1 = 0;
+  double st2 = 0;
+  double st3 = 0;
+
+  double to_return = 0;
+  if (together == 1) {
+    for (int i = 0; i < number_of_triples; ++i) {
+      st1 += net(triples(i, 2), triples(i, 0)) * net(triples(i, 1),
+                 triples(i, 0));
+      st2 += net(triples(i, 2), triples(i, 1)) * net(triples(i, 0),
+                 triples(i, 1));
+      st3 += net(triples(i, 0), triples(i, 2)) * net(triples(i, 1),
+                 triples(i, 2));
+    }
+    to_return = pow((st1 + st2 + st3), alpha);
+  } else {
+    for (int i = 0; i < number_of_triples; ++i) {
+      st1 += pow(net(triples(i, 2), triples(i, 0)), alpha) *
+        pow(net(triples(i, 1), triples(i, 0)), alpha);
+      st2 += pow(net(triples(i, 2), triples(i, 1)), alpha) *
+        pow(net(triples(i, 0), triples(i, 1)), alpha);
+      st3 += pow(net(triples(i, 0), triples(i, 2)), alpha) *
+        pow(net(triples(i, 1),triples(i, 2)), alpha);
+    }
+    to_return = st1 + st2 + st3;
+  }
+  return to_return;
+};
+
+// Function to calculate the number of transitive triads
+inline double TTriads(const arma::mat& net,
+                      const arma::mat& triples,
+                      double alpha,
+                      int together) {
+
+  int number_of_triples = triples.n_rows;
+  double st1 = 0;
+  double st2 = 0;
+  double st3 = 0;
+  double st4 = 0;
+  double st5 = 0;
+  double st6 = 0;
+
+  double to_return = 0;
+  if (together == 1) {
+    for (int i = 0; i < number_of_triples; ++i) {
+      st1 += net(triples(i, 0), triples(i, 1)) * net(triples(i, 1),
+                 triples(i, 2)) * net(triples(i, 0), triples(i, 2));
+      st2 += net(triples(i, 0), triples(i, 1)) * net(triples(i, 2),
+                 triples(i, 1)) * net(triples(i, 2), triples(i, 0));
+      st3 += net(triples(i, 0), triples(i, 1)) * net(triples(i, 2),
+                 triples(i, 1)) * net(triples(i, 0), triples(i, 2));
+      st4 += net(triples(i, 1), triples(i, 0)) * net(triples(i, 1),
+                 triples(i, 2)) * net(triples(i, 2), triples(i, 0));
+      st5 += net(triples(i, 1), triples(i, 0)) * net(triples(i, 1),
+                 triples(i, 2)) * net(triples(i, 0), triples(i, 2));
+      st6 += net(triples(i, 1), triples(i, 0)) * net(triples(i, 2),
+                 triples(i, 1)) * net(triples(i, 2), triples(i, 0));
+    }
+    to_return = pow((st1 + st2 + st3 + st4 + st5 + st6), alpha);
+  } else {
+    for (int i = 0; i < number_of_triples; ++i) {
+      st1 += pow(net(triples(i, 0), triples(i, 1)), alpha) *
+        pow(net(triples(i, 1), triples(i, 2)), alpha) *
+        pow(net(triples(i, 0), triples(i, 2)), alpha);
+      st2 += pow(net(triples(i, 0), triples(i, 1)), alpha) *
+        pow(net(triples(i, 2), triples(i, 1)), alpha) *
+        pow(net(triples(i, 2), triples(i, 0)), alpha);
+      st3 += pow(net(triples(i, 0), triples(i, 1)), alpha) *
+        pow(net(triples(i, 2),triples(i, 1)), alpha) *
+        pow(net(triples(i, 0), triples(i, 2)), alpha);
+      st4 += pow(net(triples(i, 1), triples(i, 0)), alpha) *
+        pow(net(triples(i, 1), triples(i, 2)), alpha) *
+        pow(net(triples(i, 2), triples(i, 0)), alpha);
+      st5 += pow(net(triples(i, 1), triples(i, 0)), alpha) *
+        pow(net(triples(i, 1), triples(i, 2)), alpha) *
+        pow(net(triples(i, 0), triples(i, 2)), alpha);
+      st6 += pow(net(triples(i, 1), triples(i, 0)), alpha) *
+        pow(net(triples(i, 2), triples(i, 1)), alpha) *
+        pow(net(triples(i, 2), triples(i, 0)), alpha);
+    }
+    to_return = st1 + st2 + st3 + st4 + st5 + st6;
+  }
+  return to_return;
+};
+
+// Function to calculate the number of closed triads
+inline double CTriads(const arma::mat& net,
+                      const arma::mat& triples,
+                      double alpha,
+                      int together){
+
+  int number_of_triples = triples.n_rows;
+  double st1 = 0;
+  double st2 = 0;
+
+  double to_return = 0;
+  if (together == 1) {
+    for (int i = 0; i < number_of_triples; ++i) {
+      st1 += net(triples(i, 0), triples(i, 1)) * net(triples(i, 1),
+                 triples(i, 2)) * net(triples(i, 2), triples(i, 0));
+      st2 += net(triples(i, 1), triples(i, 0)) * net(triples(i, 2),
+                 triples(i,1)) * net(triples(i, 0), triples(i, 2));
+    }
+    to_return = pow((st1 + st2), alpha);
+  } else {
+    for (int i = 0; i < number_of_triples; ++i) {
+      st1 += pow(net(triples(i, 0), triples(i, 1)), alpha) *
+        pow(net(triples(i, 1), triples(i, 2)), alpha) *
+        pow(net(triples(i, 2), triples(i, 0)), alpha);
+      st2 += pow(net(triples(i, 1), triples(i, 0)), alpha) *
+        pow(net(triples(i, 2), triples(i,1)), alpha) *
+        pow(net(triples(i, 0), triples(i, 2)), alpha);
+    }
+    to_return = st1 + st2;
+  }
+  return to_return;
+};
+
+// Function to calculate the number of reciprocated edges
+inline double Recip(const arma::mat& net,
+                    const arma::mat& pairs,
+                    double alpha,
+                    int together) {
+
+  int number_of_pairs = pairs.n_rows;
+  double st1 = 0;
+
+  double to_return = 0;
+  if(together == 1) {
+    for (int i = 0; i < number_of_pairs; ++i) {
+      st1 += net(pairs(i, 0), pairs(i, 1)) * net(pairs(i, 1), pairs(i, 0));
+    }
+    to_return = pow(st1, alpha);
+  } else {
+    for (int i = 0; i < number_of_pairs; ++i) {
+      st1 += pow(net(pairs(i, 0), pairs(i, 1)), alpha) *
+        pow(net(pairs(i, 1), pairs(i, 0)), alpha);
+    }
+    to_return = st1;
+  }
+
+
+  return to_return;
+};
+
+// Function to calculate the density of the network
+inline double EdgeDensity(const arma::mat& net,
+                          const arma::mat& pairs,
+                          double alpha,
+                          int together) {
+
+  int number_of_pairs = pairs.n_rows;
+  double st1 = 0;
+  double st2 = 0;
+  double to_return = 0;
+
+  for (int i = 0; i < number_of_pairs; ++i) {
+    st1 += net(pairs(i, 0), pairs(i, 1));
+    st1 += net(pairs(i, 1), pairs(i, 0));
+    st2 += pow(net(pairs(i, 0), pairs(i, 1)), alpha);
+    st2 += pow(net(pairs(i, 1), pairs(i, 0)), alpha);
+  }
+
+  if (together == 1) {
+    to_return = pow(st1, alpha);
+  } else {
+    to_return = st2;
+  }
+  return to_return;
+};
+
+
+
+
+// Function to calculate the number of transitive triads
+inline arma::vec indiviual_triad_values(const arma::mat& net,
+               const arma::mat& triples,
+               double alpha,
+               int together) {
+
+  int number_of_triples = triples.n_rows;
+  double st1 = 0;
+  double st2 = 0;
+  double st3 = 0;
+  double st4 = 0;
+  double st5 = 0;
+  double st6 = 0;
+
+  arma::vec to_return = arma::zeros(number_of_triples);
+  if (together == 1) {
+    for (int i = 0; i < number_of_triples; ++i) {
+      st1 = net(triples(i, 0), triples(i, 1)) * net(triples(i, 1),
+                 triples(i, 2)) * net(triples(i, 0), triples(i, 2));
+      st2 = net(triples(i, 0), triples(i, 1)) * net(triples(i, 2),
+                 triples(i, 1)) * net(triples(i, 2), triples(i, 0));
+      st3 = net(triples(i, 0), triples(i, 1)) * net(triples(i, 2),
+                 triples(i, 1)) * net(triples(i, 0), triples(i, 2));
+      st4 = net(triples(i, 1), triples(i, 0)) * net(triples(i, 1),
+                 triples(i, 2)) * net(triples(i, 2), triples(i, 0));
+      st5 = net(triples(i, 1), triples(i, 0)) * net(triples(i, 1),
+                 triples(i, 2)) * net(triples(i, 0), triples(i, 2));
+      st6 = net(triples(i, 1), triples(i, 0)) * net(triples(i, 2),
+                 triples(i, 1)) * net(triples(i, 2), triples(i, 0));
+      to_return[i] = pow((st1 + st2 + st3 + st4 + st5 + st6), alpha);
+    }
+
+  } else {
+    for (int i = 0; i < number_of_triples; ++i) {
+      st1 = pow(net(triples(i, 0), triples(i, 1)), alpha) *
+        pow(net(triples(i, 1), triples(i, 2)), alpha) *
+        pow(net(triples(i, 0), triples(i, 2)), alpha);
+      st2 = pow(net(triples(i, 0), triples(i, 1)), alpha) *
+        pow(net(triples(i, 2), triples(i, 1)), alpha) *
+        pow(net(triples(i, 2), triples(i, 0)), alpha);
+      st3 = pow(net(triples(i, 0), triples(i, 1)), alpha) *
+        pow(net(triples(i, 2),triples(i, 1)), alpha) *
+        pow(net(triples(i, 0), triples(i, 2)), alpha);
+      st4 = pow(net(triples(i, 1), triples(i, 0)), alpha) *
+        pow(net(triples(i, 1), triples(i, 2)), alpha) *
+        pow(net(triples(i, 2), triples(i, 0)), alpha);
+      st5 = pow(net(triples(i, 1), triples(i, 0)), alpha) *
+        pow(net(triples(i, 1), triples(i, 2)), alpha) *
+        pow(net(triples(i, 0), triples(i, 2)), alpha);
+      st6 = pow(net(triples(i, 1), triples(i, 0)), alpha) *
+        pow(net(triples(i, 2), triples(i, 1)), alpha) *
+        pow(net(triples(i, 2), triples(i, 0)), alpha);
+      to_return[i] = st1 + st2 + st3 + st4 + st5 + st6;
+    }
+  }
+  return to_return;
+};
+
+// get triad weights for resampling triads for approximate MH
+inline arma::vec triad_weights (
+    const arma::mat& net,
+    const arma::Mat<double>& triples,
+    double alpha,
+    int together,
+    double smoothing_parameter) {
+
+  int number_of_triples = triples.n_rows;
+
+  arma::vec triad_values = gergm::indiviual_triad_values(net,
+                                                         triples,
+                                                         alpha,
+                                                         together);
+
+  double mean_val = arma::accu(triad_values)/double(number_of_triples);
+
+  // loop over all values and calculate the absolute difference
+  for (int i = 0; i < number_of_triples; ++i) {
+    triad_values[i] = mean_val - triad_values[i];
+  }
+  // make differences absolute
+  triad_values = arma::abs(triad_values);
+
+  //get the maximum difference and multiply by smoothing_parameter > 1
+  double max_diff = arma::max(triad_values) * smoothing_parameter;
+
+  // get the un-normalized weights
+  for (int i = 0; i < number_of_triples; ++i) {
+    triad_values[i] = max_diff - triad_values[i];
+  }
+
+  // normalize
+  double sum = arma::accu(triad_values);
+  for (int i = 0; i < number_of_triples; ++i) {
+    triad_values[i] = triad_values[i]/sum;
+  }
+
+  return triad_values;
+}
+
+
+// Contribution of the triple (a,b,c) (or the pair (a,b) for the dyad
+// statistics) to a base statistic, with each edge raised to the power p. This
+// is one row of the sums in Out2Star(), In2Star(), CTriads(), Recip(),
+// TTriads() and EdgeDensity().
+inline double base_statistic_term(const arma::mat& net,
+                                  int base_statistic_index,
+                                  int a,
+                                  int b,
+                                  int c,
+                                  double p) {
+  if (base_statistic_index == 3) {
+    return pow(net(a, b), p) * pow(net(b, a), p);
+  }
+  if (base_statistic_index == 5) {
+    return pow(net(a, b), p) + pow(net(b, a), p);
+  }
+  double ab = pow(net(a, b), p);
+  double ba = pow(net(b, a), p);
+  double ac = pow(net(a, c), p);
+  double ca = pow(net(c, a), p);
+  double bc = pow(net(b, c), p);
+  double cb = pow(net(c, b), p);
+  double to_return = 0;
+  if (base_statistic_index == 0) {
+    to_return = ab * ac + ba * bc + ca * cb;
+  }
+  if (base_statistic_index == 1) {
+    to_return = ca * ba + cb * ab + ac * bc;
+  }
+  if (base_statistic_index == 2) {
+    to_return = ab * bc * ca + ba * cb * ac;
+  }
+  if (base_statistic_index == 4) {
+    to_return = ab * bc * ac + ab * cb * ca + ab * cb * ac +
+      ba * bc * ca + ba * bc * ac + ba * cb * ca;
+  }
+  return to_return;
+}
+
+// Estimate a base statistic from an importance weighted subsample. The last
+// column of triad_samples and dyad_samples holds the Horvitz-Thompson weight
+// of each sampled row, so the weighted sum estimates the sum over all triples
+// (or pairs) and no further rescaling is needed.
+inline double weighted_sample_statistic(const arma::mat& current_network,
+                                        int base_statistic_index,
+                                        const arma::Mat<double>& triad_samples,
+                                        const arma::Mat<double>& dyad_samples,
+                                        double alpha,
+                                        int together) {
+  if (base_statistic_index == 6) {
+    return arma::accu(arma::diagvec(current_network));
+  }
+  double p = alpha;
+  if (together == 1) {
+    p = 1;
+  }
+  double total = 0;
+  if (base_statistic_index == 3 || base_statistic_index == 5) {
+    for (int i = 0; i < int(dyad_samples.n_rows); ++i) {
+      total += dyad_samples(i, 2) * base_statistic_term(
+        current_network, base_statistic_index, dyad_samples(i, 0),
+        dyad_samples(i, 1), 0, p);
+    }
+  } else {
+    for (int i = 0; i < int(triad_samples.n_rows); ++i) {
+      total += triad_samples(i, 3) * base_statistic_term(
+        current_network, base_statistic_index, triad_samples(i, 0),
+        triad_samples(i, 1), triad_samples(i, 2), p);
+    }
+  }
+  if (together == 1) {
+    total = pow(total, alpha);
+  }
+  return total;
+}
+
+// Evaluate a base statistic over a node subset, given the indices of the
+// rows of triples (or pairs, for the dyad statistics) that lie entirely inside
+// the subset. The rows are read in place, so nothing is allocated and the cost
+// is proportional to the number of rows in the subset.
+inline double subset_statistic(const arma::mat& current_network,
+                               int base_statistic_index,
+                               const arma::Mat<double>& triples,
+                               const arma::Mat<double>& pairs,
+                               const arma::uword* selected_rows,
+                               int number_of_rows,
+                               double alpha,
+                               int together) {
+  if (base_statistic_index == 6) {
+    // may want to update this in the future
+    return arma::accu(arma::diagvec(current_network));
+  }
+  double p = alpha;
+  if (together == 1) {
+    p = 1;
+  }
+  double total = 0;
+  if (base_statistic_index == 3 || base_statistic_index == 5) {
+    for (int i = 0; i < number_of_rows; ++i) {
+      arma::uword row = selected_rows[i];
+      total += base_statistic_term(current_network, base_statistic_index,
+                                   pairs(row, 0), pairs(row, 1), 0, p);
+    }
+  } else {
+    for (int i = 0; i < number_of_rows; ++i) {
+      arma::uword row = selected_rows[i];
+      total += base_statistic_term(current_network, base_statistic_index,
+                                   triples(row, 0), triples(row, 1),
+                                   triples(row, 2), p);
+    }
+  }
+  if (together == 1) {
+    total = pow(total, alpha);
+  }
+  return total;
+}
+
+// Function that will calculate h statistics
+inline double calculate_individual_statistic(const arma::mat& current_network,
+                                  int base_statistic_index,
+                                  const arma::Mat<double>& triples,
+                                  const arma::Mat<double>& pairs,
+                                  double alpha,
+                                  int together,
+                                  const arma::uvec& use_selected_rows,
+                                  bool use_all_rows) {
+
+  if (!use_all_rows) {
+    return subset_statistic(current_network,
+                            base_statistic_index,
+                            triples,
+                            pairs,
+                            use_selected_rows.memptr(),
+                            use_selected_rows.n_elem,
+                            alpha,
+                            together);
+  }
+
+  double to_return = 0;
+
+  if (base_statistic_index == 0) {
+    to_return = Out2Star(current_network,
+                         triples,
+                         alpha,
+                         together);
+  }
+  if (base_statistic_index == 1) {
+    to_return = In2Star(current_network,
+                        triples,
+                        alpha,
+                        together);
+  }
+  if (base_statistic_index == 2) {
+    to_return = CTriads(current_network,
+                        triples,
+                        alpha,
+                        together);
+  }
+  if (base_statistic_index == 3) {
+    to_return = Recip(current_network,
+                      pairs,
+                      alpha,
+                      together);
+  }
+  if (base_statistic_index == 4) {
+    to_return = TTriads(current_network,
+                        triples,
+                        alpha,
+                        together);
+  }
+  if (base_statistic_index == 5) {
+    to_return = EdgeDensity(current_network,
+                            pairs,
+                            alpha,
+                            together);
+  }
+  if (base_statistic_index == 6) {
+    to_return = arma::accu(arma::diagvec(current_network));
+  }
+
+  return to_return;
+}
+
+
+// Function to set up h statistic calculation
+inline double get_individual_statistic_value(const arma::mat& current_network,
+                                             const arma::vec& statistics_to_use,
+                                             int index,
+                                             const arma::Mat<double>& triples,
+                                             const arma::Mat<double>& pairs,
+                                             double alpha,
+                                             int together,
+                                             const arma::umat& selected_rows_matrix,
+                                             const arma::vec& rows_to_use,
+                                             const arma::vec& non_base_statistic_indicator,
+                                             const arma::Mat<double>& random_triad_samples,
+                                             const arma::Mat<double>& random_dyad_samples,
+                                             bool use_triad_sampling,
+                                             bool use_weighted_triad_sampling) {
+
+    // some notes on particular arguments:
+    //
+    // use_selected_rows -- for statistics we wish to calculate on some subnetwork,
+    // this matrix will provide the row indices. The matrix will have one column
+    // for each statistic to be included in the model and will have a number of
+    // rows equal to the maximum number of indicies indicated for any particular
+    // statistic.
+    //
+    // rows_to_use -- tells us how many rows in each column shoul actually be used.
+    // this is meant to avoid having to pass in a list which would be horribly slow.
+    //
+    // statistics_to_use -- a vector for each statistic included in the model
+    // indicating which base statistic it corresponds to.
+    //
+    // index  -- the numeric index of which entry in statistics_to_use we are
+    // operating on
+    //
+    // use_weighted_triad_sampling -- the triad samples are an importance
+    // weighted subsample from draw_weighted_random_triad_samples() rather than
+    // a uniform one.
+
+    // get the current statistic index
+    int base_statistic_index = statistics_to_use[index];
+
+    double to_return = 0;
+    // an empty row selection, we use all rows for base statistics
+    arma::uvec all_rows;
+    if (non_base_statistic_indicator[index] == 1) {
+      // node subset statistics iterate directly over their column of the
+      // selected rows matrix, the first rows_to_use[index] + 1 entries of
+      // which are in the subset.
+      to_return = subset_statistic(current_network,
+                                   base_statistic_index,
+                                   triples,
+                                   pairs,
+                                   selected_rows_matrix.colptr(index),
+                                   int(rows_to_use[index]) + 1,
+                                   alpha,
+                                   together);
+    } else {
+      // if we are using a base statistic and are using triad down-sampling then
+      // set use selected rows to this.
+      if (use_triad_sampling && use_weighted_triad_sampling) {
+        // importance weighted subsample, see draw_weighted_random_triad_samples()
+        to_return = weighted_sample_statistic(current_network,
+                                              base_statistic_index,
+                                              random_triad_samples,
+                                              random_dyad_samples,
+                                              alpha,
+                                              together);
+      } else if (use_triad_sampling) {
+        // Function that will calculate h statistics
+        to_return = calculate_individual_statistic(current_network,
+                                                   base_statistic_index,
+                                                   random_triad_samples,
+                                                   random_dyad_samples,
+                                                   alpha,
+                                                   together,
+                                                   all_rows,
+                                                   true);
+      } else {
+        // Function that will calculate h statistics
+        to_return = calculate_individual_statistic(current_network,
+                                                   base_statistic_index,
+                                                   triples,
+                                                   pairs,
+                                                   alpha,
+                                                   together,
+                                                   all_rows,
+                                                   true);
+      }
+    }
+
+    return to_return;
+  }
+
+
+// theta' h computed with the statistics spread over parallel_for(), one
+// statistic per chunk of parallel_sum(). The terms are added in the order of
+// statistics_to_use whatever the number of threads, which is also the order
+// CalculateNetworkStatistics() adds them in without parallel.
+inline double parallel_CalculateNetworkStatistics(
+    const arma::mat& current_network,
+    const arma::vec& statistics_to_use,
+    const arma::Mat<double>& triples,
+    const arma::Mat<double>& pairs,
+    const arma::vec& alphas,
+    int together,
+    const arma::umat& selected_rows_matrix,
+    const arma::vec& rows_to_use,
+    const arma::vec& non_base_statistic_indicator,
+    const arma::Mat<double>& random_triad_samples,
+    const arma::Mat<double>& random_dyad_samples,
+    bool use_triad_sampling,
+    bool use_weighted_triad_sampling,
+    const arma::vec& thetas) {
+
+  int number_of_stats = statistics_to_use.n_elem;
+  return gergm::parallel_sum(0, number_of_stats, 1, [&](std::size_t i) {
+    return thetas[i] * get_individual_statistic_value(
+      current_network,
+      statistics_to_use,
+      i,
+      triples,
+      pairs,
+      alphas[i],
+      together,
+      selected_rows_matrix,
+      rows_to_use,
+      non_base_statistic_indicator,
+      random_triad_samples,
+      random_dyad_samples,
+      use_triad_sampling,
+      use_weighted_triad_sampling);
+  });
+}
+
+// Function that will calculate h statistics
+inline double CalculateNetworkStatistics(const arma::mat& current_network,
+                                         const arma::vec& statistics_to_use,
+                                         const arma::vec& thetas,
+                                         const arma::Mat<double>& triples,
+                                         const arma::Mat<double>& pairs,
+                                         const arma::vec& alphas,
+                                         int together,
+                                         bool parallel,
+                                         const arma::umat& selected_rows_matrix,
+                                         const arma::vec& rows_to_use,
+                                         const arma::vec& non_base_statistic_indicator,
+                                         const arma::Mat<double>& random_triad_samples,
+                                         const arma::Mat<double>& random_dyad_samples,
+                                         bool use_triad_sampling,
+                                         bool use_weighted_triad_sampling) {
+
+  // this is the number of statistics we will be operating on in sampling
+  int number_of_thetas = statistics_to_use.n_elem;
+
+  double to_return = 0;
+  if (parallel) {
+    to_return = gergm::parallel_CalculateNetworkStatistics(
+      current_network,
+      statistics_to_use,
+      triples,
+      pairs,
+      alphas,
+      together,
+      selected_rows_matrix,
+      rows_to_use,
+      non_base_statistic_indicator,
+      random_triad_samples,
+      random_dyad_samples,
+      use_triad_sampling,
+      use_weighted_triad_sampling,
+      thetas);
+  } else {
+    for (int i = 0; i < number_of_thetas; ++i) {
+      to_return += thetas[i] * get_individual_statistic_value(
+          current_network,
+          statistics_to_use,
+          i,
+          triples,
+          pairs,
+          alphas[i],
+          together,
+          selected_rows_matrix,
+          rows_to_use,
+          non_base_statistic_indicator,
+          random_triad_samples,
+          random_dyad_samples,
+          use_triad_sampling,
+          use_weighted_triad_sampling);
+    }
+  }
+  return to_return;
+};
+
+  // Function that will calculate and save all of the h statistics for a network
+  // Work out which statistics save_network_statistics() calculates: all of
+  // the base_statistics_to_save, followed by the non-base statistics from the
+  // statistics_to_use vector we use in the normal MH updates.
+  inline void plan_saved_statistics(const arma::vec& statistics_to_use,
+                                    const arma::vec& base_statistics_to_save,
+                                    const arma::vec& base_statistic_alphas,
+                                    const arma::vec& alphas,
+                                    const arma::vec& rows_to_use,
+                                    int num_non_base_statistics,
+                                    const arma::vec& non_base_statistic_indicator,
+                                    arma::vec& combined_statistics_to_use,
+                                    arma::vec& combined_alphas,
+                                    arma::vec& combined_rows_to_use,
+                                    arma::vec& combined_non_base_statistic_indicator) {
+
+    int num_base_statistics_to_save = base_statistics_to_save.n_elem;
+    int statistics_to_save = num_non_base_statistics + num_base_statistics_to_save;
+
+    combined_statistics_to_use = arma::zeros(statistics_to_save);
+    combined_alphas = arma::zeros(statistics_to_save);
+    combined_rows_to_use = arma::zeros(statistics_to_save);
+    combined_non_base_statistic_indicator = arma::zeros(statistics_to_save);
+
+    // loop through and populate with base statistic values
+    for (int i = 0; i < num_base_statistics_to_save; ++i) {
+      combined_statistics_to_use[i] = base_statistics_to_save[i];
+      combined_alphas[i] = base_statistic_alphas[i];
+    }
+    int counter = num_base_statistics_to_save;
+    for (int i = 0; i < int(non_base_statistic_indicator.n_elem); ++i) {
+      if (non_base_statistic_indicator[i] == 1) {
+        combined_statistics_to_use[counter] = statistics_to_use[i];
+        combined_alphas[counter] = alphas[i];
+        combined_rows_to_use[counter] = rows_to_use[i];
+        combined_non_base_statistic_indicator[counter] = 1;
+        counter += 1;
+      }
+    }
+  }
+
+  // Calculate the statistics laid out by plan_saved_statistics(). The proxy
+  // triad samples are only passed along, the saved statistics are never
+  // subsampled.
+  inline arma::vec calculate_saved_statistics(
+      const arma::mat& current_network,
+      const arma::vec& combined_statistics_to_use,
+      const arma::vec& combined_alphas,
+      const arma::vec& combined_rows_to_use,
+      const arma::vec& combined_non_base_statistic_indicator,
+      const arma::Mat<double>& triples,
+      const arma::Mat<double>& pairs,
+      int together,
+      const arma::umat& save_statistics_selected_rows_matrix,
+      const arma::Mat<double>& proxy_random_triad_samples,
+      const arma::Mat<double>& proxy_random_dyad_samples) {
+
+    int statistics_to_save = combined_statistics_to_use.n_elem;
+    arma::vec statistic_values = arma::zeros(statistics_to_save);
+
+    // loop through and calculate the statistics we are going to save and store
+    // them in a vector.
+    for (int i = 0; i < statistics_to_save; ++i) {
+      statistic_values[i] = get_individual_statistic_value(
+        current_network,
+        combined_statistics_to_use,
+        i,
+        triples,
+        pairs,
+        combined_alphas[i],
+        together,
+        save_statistics_selected_rows_matrix,
+        combined_rows_to_use,
+        combined_non_base_statistic_indicator,
+        proxy_random_triad_samples,
+        proxy_random_dyad_samples,
+        false,
+        false);
+    }
+
+    return statistic_values;
+  }
+
+  inline arma::vec save_network_statistics(const arma::mat& current_network,
+                                           const arma::vec& statistics_to_use,
+                                           const arma::vec& base_statistics_to_save,
+                                           const arma::vec& base_statistic_alphas,
+                                           const arma::Mat<double>& triples,
+                                           const arma::Mat<double>& pairs,
+                                           const arma::vec& alphas,
+                                           int together,
+                                           const arma::umat& save_statistics_selected_rows_matrix,
+                                           const arma::vec& rows_to_use,
+                                           int num_non_base_statistics,
+                                           const arma::vec& non_base_statistic_indicator) {
+
+    arma::vec combined_statistics_to_use;
+    arma::vec combined_alphas;
+    arma::vec combined_rows_to_use;
+    arma::vec combined_non_base_statistic_indicator;
+    plan_saved_statistics(statistics_to_use,
+                          base_statistics_to_save,
+                          base_statistic_alphas,
+                          alphas,
+                          rows_to_use,
+                          num_non_base_statistics,
+                          non_base_statistic_indicator,
+                          combined_statistics_to_use,
+                          combined_alphas,
+                          combined_rows_to_use,
+                          combined_non_base_statistic_indicator);
+
+    int statistics_to_save = combined_statistics_to_use.n_elem;
+    arma::Mat<double> proxy_random_triad_samples(2,statistics_to_save);
+    arma::Mat<double> proxy_random_dyad_samples(2,statistics_to_save);
+
+    return calculate_saved_statistics(current_network,
+                                      combined_statistics_to_use,
+                                      combined_alphas,
+                                      combined_rows_to_use,
+                                      combined_non_base_statistic_indicator,
+                                      triples,
+                                      pairs,
+                                      together,
+                                      save_statistics_selected_rows_matrix,
+                                      proxy_random_triad_samples,
+                                      proxy_random_dyad_samples);
+  };
+
+} // end of gergm namespace
+
+#endif
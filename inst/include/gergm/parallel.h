@@ -0,0 +1,134 @@
+#ifndef GERGM_PARALLEL_H
+#define GERGM_PARALLEL_H
+
+// The loops with a parallel option (statistics in the h function and the
+// MPLE integration points) hand their index range to parallel_for(). Outside
+// of R the range is split over std::threads. The R package registers
+// RcppParallel::parallelFor() as the backend instead, so that these loops
+// share R's thread pool and respect RcppParallel::setThreadOptions().
+//
+// Backends split ranges however they like (RcppParallel partitions them
+// dynamically), so sums over parallel work go through parallel_sum() or
+// pairwise_sum(), which add in an order that does not depend on how the
+// range was split. Results, and so the accept decisions of the samplers, are
+// the same with any number of threads.
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace gergm {
+
+// body(begin, end) processes the indices in [begin, end)
+typedef std::function<void(std::size_t, std::size_t)> RangeBody;
+typedef void (*ParallelForFunction)(std::size_t, std::size_t,
+                                    const RangeBody&);
+
+// The number of threads thread_parallel_for() uses, 0 (the default) for one
+// per hardware thread.
+inline std::size_t& parallel_thread_count() {
+  static std::size_t number_of_threads = 0;
+  return number_of_threads;
+}
+
+// Split [begin, end) into one contiguous block per thread.
+inline void thread_parallel_for(std::size_t begin,
+                                std::size_t end,
+                                const RangeBody& body) {
+  if (end <= begin) {
+    return;
+  }
+  std::size_t length = end - begin;
+  std::size_t number_of_threads = parallel_thread_count();
+  if (number_of_threads == 0) {
+    number_of_threads = std::max<std::size_t>(
+      1, std::thread::hardware_concurrency());
+  }
+  number_of_threads = std::min(number_of_threads, length);
+  if (number_of_threads == 1) {
+    body(begin, end);
+    return;
+  }
+  std::size_t block_size = (length + number_of_threads - 1) / number_of_threads;
+  std::vector<std::thread> threads;
+  for (std::size_t start = begin + block_size; start < end;
+       start += block_size) {
+    threads.push_back(std::thread(body, start,
+                                  std::min(start + block_size, end)));
+  }
+  body(begin, begin + block_size);
+  for (std::size_t t = 0; t < threads.size(); ++t) {
+    threads[t].join();
+  }
+}
+
+// The backend used by parallel_for(), assign to it to replace the default.
+inline ParallelForFunction& parallel_for_backend() {
+  static ParallelForFunction backend = &thread_parallel_for;
+  return backend;
+}
+
+inline void parallel_for(std::size_t begin,
+                         std::size_t end,
+                         const RangeBody& body) {
+  parallel_for_backend()(begin, end, body);
+}
+
+// pairwise_sum() adds blocks of this many values in order.
+const std::size_t pairwise_block_size = 256;
+
+// Sum values[0], ..., values[length - 1]: in order within blocks of
+// pairwise_block_size, and the blocks pairwise, splitting on block
+// boundaries. Up to one block this is the plain left to right sum, and
+// rounding error grows with the log of the number of blocks rather than with
+// length.
+inline double pairwise_sum(const double* values, std::size_t length) {
+  if (length <= pairwise_block_size) {
+    double total = 0;
+    for (std::size_t i = 0; i < length; ++i) {
+      total += values[i];
+    }
+    return total;
+  }
+  std::size_t blocks = (length + pairwise_block_size - 1) /
+    pairwise_block_size;
+  std::size_t half = (blocks / 2) * pairwise_block_size;
+  return pairwise_sum(values, half) +
+    pairwise_sum(values + half, length - half);
+}
+
+// The sum of term(i) over [begin, end), over parallel_for(). The range is cut
+// into chunks of chunk_size terms from begin, each chunk is summed in order
+// and the chunk totals are added with pairwise_sum(). The result only depends
+// on the terms and chunk_size, never on which thread computed which chunk.
+// With chunk_size 1 and up to pairwise_block_size terms it is the plain left
+// to right sum. term must be safe to call from several threads at once.
+template<class Term>
+inline double parallel_sum(std::size_t begin,
+                           std::size_t end,
+                           std::size_t chunk_size,
+                           const Term& term) {
+  if (end <= begin) {
+    return 0;
+  }
+  std::size_t chunks = (end - begin + chunk_size - 1) / chunk_size;
+  std::vector<double> chunk_totals(chunks);
+  parallel_for(0, chunks, [&](std::size_t first, std::size_t last) {
+    for (std::size_t c = first; c < last; ++c) {
+      std::size_t chunk_begin = begin + c * chunk_size;
+      std::size_t chunk_end = std::min(chunk_begin + chunk_size, end);
+      double total = 0;
+      for (std::size_t i = chunk_begin; i < chunk_end; ++i) {
+        total += term(i);
+      }
+      chunk_totals[c] = total;
+    }
+  });
+  return pairwise_sum(chunk_totals.data(), chunks);
+}
+
+} // end of gergm namespace
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef GERGM_PROPOSAL_H
+#define GERGM_PROPOSAL_H
+
+// Truncated normal edge proposals, shared by all of the Metropolis Hastings
+// samplers, and the network sweeps of the full network sampler.
+
+#include <armadillo>
+#include <cmath>
+#include "random.h"
+#include "sampler_profile.h"
+
+namespace gergm {
+
+// Draw a new edge value from a normal centered at current_edge_value and
+// truncated to (0,1), and add log q(current | new) - log q(new | current) to
+// log_q_ratio.
+template<class Engine>
+inline double propose_edge_value(double current_edge_value,
+                                 double variance,
+                                 Engine& generator,
+                                 double& log_q_ratio,
+                                 SamplerProfile& profile) {
+  normal_distribution<double> proposal(current_edge_value, variance);
+  int in_zero_one = 0;
+  double new_edge_value = 0.5;
+  while (in_zero_one == 0) {
+    new_edge_value = proposal(generator);
+    GERGM_PROFILE_COUNT(profile, proposal_draws, 1);
+    if ((new_edge_value > 0) & (new_edge_value < 1)) {
+      in_zero_one = 1;
+      GERGM_PROFILE_COUNT(profile, proposed_edges, 1);
+    }
+  }
+  // calculate the probability of the new edge under current beta dist
+  double lower_bound = random::normal_cdf(0, current_edge_value, variance);
+  double upper_bound = random::normal_cdf(1, current_edge_value, variance);
+  double raw_prob = random::normal_density(new_edge_value, current_edge_value,
+                                           variance);
+  double prob_new_edge_under_old = raw_prob / (upper_bound - lower_bound);
+  // calculate the probability of the current edge under new beta dist
+  lower_bound = random::normal_cdf(0, new_edge_value, variance);
+  upper_bound = random::normal_cdf(1, new_edge_value, variance);
+  raw_prob = random::normal_density(current_edge_value, new_edge_value,
+                                    variance);
+  double prob_old_edge_under_new = raw_prob / (upper_bound - lower_bound);
+  log_q_ratio += (std::log(prob_old_edge_under_new) -
+                  std::log(prob_new_edge_under_old));
+  return new_edge_value;
+}
+
+// For samplers that do not keep a profile.
+template<class Engine>
+inline double propose_edge_value(double current_edge_value,
+                                 double variance,
+                                 Engine& generator,
+                                 double& log_q_ratio) {
+  SamplerProfile profile;
+  return propose_edge_value(current_edge_value, variance, generator,
+                            log_q_ratio, profile);
+}
+
+// Propose a new value for every free edge, writing them into proposed, and
+// return the log q ratio of the whole proposal. Every free edge of proposed
+// is overwritten, so it may hold any earlier network (the samplers swap it
+// with current on accept), but its fixed entries (the diagonal, when it is
+// not modeled) must already agree with current. Edges are visited row by
+// row, only up to the diagonal for undirected networks, which is the order
+// the samplers have always drawn them in. The network type is a template
+// parameter so that the loop bounds replace the per edge tests of the
+// network type and the diagonal.
+template<bool Undirected, bool IncludeDiagonal, class Engine>
+inline double propose_network(const arma::mat& current,
+                              arma::mat& proposed,
+                              double variance,
+                              Engine& generator,
+                              SamplerProfile& profile) {
+  int number_of_nodes = current.n_rows;
+  double log_q_ratio = 0;
+  for (int i = 0; i < number_of_nodes; ++i) {
+    for (int j = 0; j < i; ++j) {
+      double new_edge_value = propose_edge_value(current(i, j), variance,
+                                                 generator, log_q_ratio,
+                                                 profile);
+      proposed(i, j) = new_edge_value;
+      if (Undirected) {
+        proposed(j, i) = new_edge_value;
+      }
+    }
+    if (IncludeDiagonal) {
+      proposed(i, i) = propose_edge_value(current(i, i), variance, generator,
+                                          log_q_ratio, profile);
+    }
+    if (!Undirected) {
+      for (int j = i + 1; j < number_of_nodes; ++j) {
+        proposed(i, j) = propose_edge_value(current(i, j), variance,
+                                            generator, log_q_ratio, profile);
+      }
+    }
+  }
+  return log_q_ratio;
+}
+
+} // end of gergm namespace
+
+#endif
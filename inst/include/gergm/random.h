@@ -0,0 +1,137 @@
+#ifndef GERGM_RANDOM_H
+#define GERGM_RANDOM_H
+
+// Random number generation for the samplers. The samplers use std::mt19937,
+// which gives the same stream as boost::mt19937 for the same seed, and the
+// distributions below reproduce the Boost ones they replace, so seeded runs
+// are unchanged.
+
+#include <cmath>
+#include <limits>
+#include <random>
+
+namespace gergm {
+
+namespace random {
+
+// Uniform draws on [0,1) from an integer engine, the same algorithm as
+// boost::uniform_01.
+template<class RealType = double>
+class uniform_01
+{
+public:
+  typedef RealType result_type;
+
+  template<class Engine>
+  result_type operator()(Engine& eng)
+  {
+    for (;;) {
+      typedef typename Engine::result_type base_result;
+      result_type factor = result_type(1) /
+        (result_type(base_result((eng.max)() - (eng.min)())) +
+         result_type(std::numeric_limits<base_result>::is_integer ? 1 : 0));
+      result_type result = result_type(base_result(eng() - (eng.min)())) *
+        factor;
+      if (result < result_type(1)) {
+        return result;
+      }
+    }
+  }
+};
+
+// Distributed under the Boost Software License, Version 1.0.
+//    (See http://www.boost.org/LICENSE_1_0.txt)
+// Coppied from the Boost libraries because they use an assert statement
+// which will not pass r cmd check.
+// http://www.boost.org/doc/libs/1_53_0/boost/random/normal_distribution.hpp
+// deterministic Box-Muller method, uses trigonometric functions
+
+/**
+* Instantiations of class template normal_distribution model a
+* \random_distribution. Such a distribution produces random numbers
+* @c x distributed with probability density function
+* \f$\displaystyle p(x) =
+*   \frac{1}{\sqrt{2\pi\sigma}} e^{-\frac{(x-\mu)^2}{2\sigma^2}}
+* \f$,
+* where mean and sigma are the parameters of the distribution.
+*/
+template<class RealType = double>
+class normal_distribution
+{
+public:
+  typedef RealType input_type;
+  typedef RealType result_type;
+
+  /**
+  * Constructs a @c normal_distribution object. @c mean and @c sigma are
+  * the parameters for the distribution.
+  *
+  * Requires: sigma >= 0
+  */
+  explicit normal_distribution(const RealType& mean_arg = RealType(0.0),
+                               const RealType& sigma_arg = RealType(1.0))
+    : _mean(mean_arg), _sigma(sigma_arg),
+      _r1(0), _r2(0), _cached_rho(0), _valid(false)
+  {}
+
+  /**  Returns the mean of the distribution. */
+  RealType mean() const { return _mean; }
+  /** Returns the standard deviation of the distribution. */
+  RealType sigma() const { return _sigma; }
+
+  /**
+  * Effects: Subsequent uses of the distribution do not depend
+  * on values produced by any engine prior to invoking reset.
+  */
+  void reset() { _valid = false; }
+
+  /**  Returns a normal variate. */
+  template<class Engine>
+  result_type operator()(Engine& eng)
+  {
+    using std::sqrt;
+    using std::log;
+    using std::sin;
+    using std::cos;
+
+    if(!_valid) {
+      _r1 = uniform_01<RealType>()(eng);
+      _r2 = uniform_01<RealType>()(eng);
+      _cached_rho = sqrt(-result_type(2) * log(result_type(1)-_r2));
+      _valid = true;
+    } else {
+      _valid = false;
+    }
+    const result_type pi = result_type(3.14159265358979323846);
+
+    return _cached_rho * (_valid ?
+                            cos(result_type(2)*pi*_r1) :
+                            sin(result_type(2)*pi*_r1))
+      * _sigma + _mean;
+  }
+
+private:
+  RealType _mean, _sigma;
+  RealType _r1, _r2, _cached_rho;
+  bool _valid;
+
+};
+
+// Normal distribution function and density, in place of R::pnorm and
+// R::dnorm (lower tail, not logged).
+inline double normal_cdf(double x, double mean, double sd) {
+  return 0.5 * std::erfc(-(x - mean) / (sd * std::sqrt(2.0)));
+}
+
+inline double normal_density(double x, double mean, double sd) {
+  double z = (x - mean) / sd;
+  return std::exp(-0.5 * z * z) / (sd * std::sqrt(2 * 3.14159265358979323846));
+}
+
+} // namespace random
+
+using random::normal_distribution;
+
+} // end of gergm namespace
+
+#endif
@@ -0,0 +1,432 @@
+#ifndef GERGM_SAMPLE_FILE_H
+#define GERGM_SAMPLE_FILE_H
+
+// Sample files: the statistics and networks of a Metropolis Hastings run on
+// disk, so that they can be kept and reloaded without going through R's
+// serialization, and read back lazily, one network at a time, from a memory
+// mapped file.
+//
+// Layout (native byte order, every section starts at a multiple of 8 bytes):
+//
+//   offset 0    magic "GERGMSMP"
+//   offset 8    16 uint64_t header fields:
+//                 0  format version (1)
+//                 1  number of nodes
+//                 2  number of samples
+//                 3  number of statistics
+//                 4  number of thetas
+//                 5  flags: 1 directed, 2 include diagonal, 4 correlation
+//                    network, 8 packed (each network is its lower triangle)
+//                 6  first sample after the burnin
+//                 7  statistic names offset   8  statistic names size
+//                 9  thetas offset
+//                 10 statistics offset
+//                 11 networks offset          12 networks size
+//                 13 network storage (a NetworkStorage)
+//                 14, 15 reserved (0)
+//   names       the statistic names, each followed by '\n'
+//   thetas      number of thetas doubles
+//   statistics  samples x statistics doubles, column major
+//   networks    a serialized NetworkSampleArchive: per sample offsets, then
+//               the samples, each encoded on its own (doubles, floats, fixed
+//               point, or deltas from the previous sample with a whole
+//               keyframe every 32 samples)
+//
+// Files are written to a temporary name and renamed into place, so readers
+// that still map an older file with the same name are not disturbed.
+
+#include <armadillo>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "metropolis_hastings.h"
+#include "sample_storage.h"
+
+#ifdef _WIN32
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace gergm {
+
+// Everything in a sample file other than the statistics and networks.
+struct SampleFileInfo {
+  int number_of_nodes;
+  bool directed;
+  bool include_diagonal;
+  bool correlation;
+  bool packed;
+  std::size_t first_sample;
+  std::vector<std::string> statistic_names;
+  std::vector<double> thetas;
+};
+
+namespace detail {
+
+const char sample_file_magic[8] = {'G', 'E', 'R', 'G', 'M', 'S', 'M', 'P'};
+const std::size_t sample_file_header_fields = 16;
+const std::size_t sample_file_header_size = sizeof(sample_file_magic) +
+  sample_file_header_fields * sizeof(uint64_t);
+
+inline std::size_t pad_to_eight(std::size_t size) {
+  return (size + 7) / 8 * 8;
+}
+
+inline void write_padding(std::ostream& out, std::size_t size) {
+  static const char zeros[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+  out.write(zeros, pad_to_eight(size) - size);
+}
+
+// The serialized form of a STORE_DOUBLE archive (see
+// NetworkSampleArchive::serialize) of number_of_samples contiguous samples,
+// written without copying them into an archive first.
+inline void write_double_archive(std::ostream& out,
+                                 const double* samples,
+                                 std::size_t sample_length,
+                                 std::size_t number_of_samples) {
+  uint64_t header[4] = {uint64_t(STORE_DOUBLE), uint64_t(sample_length), 1,
+                        uint64_t(number_of_samples)};
+  double bounds[2] = {0, 1};
+  out.write(reinterpret_cast<const char*>(header), sizeof(header));
+  out.write(reinterpret_cast<const char*>(bounds), sizeof(bounds));
+  if (number_of_samples == 0) {
+    return;
+  }
+  for (std::size_t s = 0; s <= number_of_samples; ++s) {
+    uint64_t offset = s * sample_length * sizeof(double);
+    out.write(reinterpret_cast<const char*>(&offset), sizeof(uint64_t));
+  }
+  out.write(reinterpret_cast<const char*>(samples),
+            number_of_samples * sample_length * sizeof(double));
+}
+
+inline std::size_t double_archive_size(std::size_t sample_length,
+                                       std::size_t number_of_samples) {
+  if (number_of_samples == 0) {
+    return archive_header_size;
+  }
+  return archive_header_size + (number_of_samples + 1) * sizeof(uint64_t) +
+    number_of_samples * sample_length * sizeof(double);
+}
+
+// Write the header and everything before the networks. networks_size is the
+// size of the serialized archive that follows.
+inline void write_sample_file_start(std::ostream& out,
+                                    const SampleFileInfo& info,
+                                    const arma::mat& statistics,
+                                    int network_storage,
+                                    std::size_t number_of_samples,
+                                    std::size_t networks_size) {
+  std::string names;
+  for (std::size_t s = 0; s < info.statistic_names.size(); ++s) {
+    names += info.statistic_names[s];
+    names += '\n';
+  }
+  std::size_t names_offset = sample_file_header_size;
+  std::size_t thetas_offset = names_offset + pad_to_eight(names.size());
+  std::size_t statistics_offset = thetas_offset +
+    info.thetas.size() * sizeof(double);
+  std::size_t networks_offset = statistics_offset +
+    statistics.n_elem * sizeof(double);
+
+  uint64_t header[sample_file_header_fields] = {0};
+  header[0] = 1;
+  header[1] = uint64_t(info.number_of_nodes);
+  header[2] = uint64_t(number_of_samples);
+  header[3] = uint64_t(statistics.n_cols);
+  header[4] = uint64_t(info.thetas.size());
+  header[5] = (info.directed ? 1 : 0) | (info.include_diagonal ? 2 : 0) |
+    (info.correlation ? 4 : 0) | (info.packed ? 8 : 0);
+  header[6] = uint64_t(info.first_sample);
+  header[7] = uint64_t(names_offset);
+  header[8] = uint64_t(names.size());
+  header[9] = uint64_t(thetas_offset);
+  header[10] = uint64_t(statistics_offset);
+  header[11] = uint64_t(networks_offset);
+  header[12] = uint64_t(networks_size);
+  header[13] = uint64_t(network_storage);
+
+  out.write(sample_file_magic, sizeof(sample_file_magic));
+  out.write(reinterpret_cast<const char*>(header), sizeof(header));
+  out.write(names.data(), names.size());
+  write_padding(out, names.size());
+  if (!info.thetas.empty()) {
+    out.write(reinterpret_cast<const char*>(&info.thetas[0]),
+              info.thetas.size() * sizeof(double));
+  }
+  out.write(reinterpret_cast<const char*>(statistics.memptr()),
+            statistics.n_elem * sizeof(double));
+}
+
+inline void finish_sample_file(std::ofstream& out,
+                               const std::string& temporary_path,
+                               const std::string& path) {
+  out.close();
+  if (!out) {
+    std::remove(temporary_path.c_str());
+    throw std::runtime_error("Could not write sample file " + path);
+  }
+  // rename does not replace existing files on Windows
+  std::remove(path.c_str());
+  if (std::rename(temporary_path.c_str(), path.c_str()) != 0) {
+    std::remove(temporary_path.c_str());
+    throw std::runtime_error("Could not write sample file " + path);
+  }
+}
+
+} // end of detail namespace
+
+// Write statistics (one row per sample) and networks to a sample file.
+inline void write_sample_file(const std::string& path,
+                              const SampleFileInfo& info,
+                              const arma::mat& statistics,
+                              const NetworkSampleArchive& networks) {
+  std::vector<unsigned char> archive;
+  networks.serialize(archive);
+  std::string temporary_path = path + ".tmp";
+  std::ofstream out(temporary_path.c_str(),
+                    std::ios::binary | std::ios::trunc);
+  if (!out) {
+    throw std::runtime_error("Could not write sample file " + path);
+  }
+  detail::write_sample_file_start(out, info, statistics,
+                                  networks.storage_type(),
+                                  networks.number_of_samples(),
+                                  archive.size());
+  out.write(reinterpret_cast<const char*>(&archive[0]), archive.size());
+  detail::finish_sample_file(out, temporary_path, path);
+}
+
+// Write the statistics and networks of a Metropolis Hastings run (which must
+// have stored its networks) to a sample file. The packed, directed and
+// diagonal fields of info are taken from the model.
+inline void write_sample_file(const std::string& path,
+                              const GergmModel& model,
+                              SampleFileInfo info,
+                              const MetropolisHastingsOutput& output) {
+  info.number_of_nodes = model.number_of_nodes;
+  info.directed = model.undirect_network == 0 &&
+    model.using_correlation_network == 0;
+  info.include_diagonal = model.include_diagonal;
+  info.correlation = model.using_correlation_network == 1;
+  info.packed = output.packed_networks;
+  if (output.network_storage != STORE_DOUBLE) {
+    write_sample_file(path, info, output.Save_H_Statistics,
+                      output.Archived_Network_Samples);
+    return;
+  }
+  // double samples are already contiguous, one after another
+  const double* samples = output.packed_networks ?
+    output.Packed_Network_Samples.memptr() : output.Network_Samples.memptr();
+  std::size_t sample_length = output.packed_networks ?
+    output.Packed_Network_Samples.n_rows :
+    output.Network_Samples.n_rows * output.Network_Samples.n_cols;
+  std::size_t number_of_samples = output.packed_networks ?
+    output.Packed_Network_Samples.n_cols : output.Network_Samples.n_slices;
+  std::string temporary_path = path + ".tmp";
+  std::ofstream out(temporary_path.c_str(),
+                    std::ios::binary | std::ios::trunc);
+  if (!out) {
+    throw std::runtime_error("Could not write sample file " + path);
+  }
+  detail::write_sample_file_start(
+    out, info, output.Save_H_Statistics, STORE_DOUBLE, number_of_samples,
+    detail::double_archive_size(sample_length, number_of_samples));
+  detail::write_double_archive(out, samples, sample_length,
+                               number_of_samples);
+  detail::finish_sample_file(out, temporary_path, path);
+}
+
+// Read access to a sample file. The file is memory mapped (read into memory
+// on Windows), so opening it only reads the header, and networks are decoded
+// when they are asked for.
+class SampleFile {
+public:
+  explicit SampleFile(const std::string& path)
+    : bytes(NULL),
+      size(0) {
+    map(path);
+    try {
+      read_header(path);
+    } catch (...) {
+      unmap();
+      throw;
+    }
+  }
+
+  ~SampleFile() {
+    unmap();
+  }
+
+  const SampleFileInfo& info() const {
+    return file_info;
+  }
+
+  std::size_t number_of_samples() const {
+    return network_samples.number_of_samples();
+  }
+
+  std::size_t number_of_statistics() const {
+    return statistic_count;
+  }
+
+  int network_storage() const {
+    return network_samples.storage_type();
+  }
+
+  double statistic(std::size_t sample, std::size_t statistic) const {
+    double value;
+    std::memcpy(&value, statistics_bytes +
+                (sample + statistic * number_of_samples()) * sizeof(double),
+                sizeof(double));
+    return value;
+  }
+
+  // The (packed or full) samples as stored.
+  const NetworkSampleArchiveView& networks() const {
+    return network_samples;
+  }
+
+  // Decode a sample into an n x n (column major) network.
+  void network(std::size_t sample, double* network) const {
+    int number_of_nodes = file_info.number_of_nodes;
+    if (!file_info.packed) {
+      network_samples.decode(sample, network);
+      return;
+    }
+    std::vector<double> values(network_samples.sample_length());
+    network_samples.decode(sample, values.data());
+    std::fill(network, network + number_of_nodes * number_of_nodes, 0.0);
+    unpack_network(values.data(), network, number_of_nodes,
+                   file_info.include_diagonal);
+  }
+
+private:
+  const unsigned char* bytes;
+  std::size_t size;
+#ifdef _WIN32
+  std::vector<unsigned char> contents;
+#endif
+  SampleFileInfo file_info;
+  std::size_t statistic_count;
+  const unsigned char* statistics_bytes;
+  NetworkSampleArchiveView network_samples;
+
+  SampleFile(const SampleFile&);
+  SampleFile& operator=(const SampleFile&);
+
+  void map(const std::string& path) {
+#ifdef _WIN32
+    std::ifstream in(path.c_str(), std::ios::binary);
+    if (!in) {
+      throw std::runtime_error("Could not open sample file " + path);
+    }
+    contents.assign(std::istreambuf_iterator<char>(in),
+                    std::istreambuf_iterator<char>());
+    bytes = contents.empty() ? NULL : &contents[0];
+    size = contents.size();
+#else
+    int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+      throw std::runtime_error("Could not open sample file " + path);
+    }
+    struct stat file_status;
+    if (fstat(descriptor, &file_status) != 0 || file_status.st_size == 0) {
+      close(descriptor);
+      throw std::runtime_error("Could not open sample file " + path);
+    }
+    size = std::size_t(file_status.st_size);
+    void* mapped = mmap(NULL, size, PROT_READ, MAP_SHARED, descriptor, 0);
+    // the mapping stays valid after the descriptor is closed
+    close(descriptor);
+    if (mapped == MAP_FAILED) {
+      size = 0;
+      throw std::runtime_error("Could not map sample file " + path);
+    }
+    bytes = static_cast<const unsigned char*>(mapped);
+#endif
+  }
+
+  void unmap() {
+#ifndef _WIN32
+    if (bytes != NULL) {
+      munmap(const_cast<unsigned char*>(bytes), size);
+    }
+#endif
+    bytes = NULL;
+    size = 0;
+  }
+
+  void read_header(const std::string& path) {
+    if (size < detail::sample_file_header_size ||
+        std::memcmp(bytes, detail::sample_file_magic,
+                    sizeof(detail::sample_file_magic)) != 0) {
+      throw std::runtime_error(path + " is not a GERGM sample file.");
+    }
+    uint64_t header[detail::sample_file_header_fields];
+    std::memcpy(header, bytes + sizeof(detail::sample_file_magic),
+                sizeof(header));
+    if (header[0] != 1) {
+      throw std::runtime_error(path + " has an unsupported sample file version.");
+    }
+    std::size_t number_of_samples = std::size_t(header[2]);
+    statistic_count = std::size_t(header[3]);
+    std::size_t number_of_thetas = std::size_t(header[4]);
+    std::size_t names_offset = std::size_t(header[7]);
+    std::size_t names_size = std::size_t(header[8]);
+    std::size_t thetas_offset = std::size_t(header[9]);
+    std::size_t statistics_offset = std::size_t(header[10]);
+    std::size_t networks_offset = std::size_t(header[11]);
+    std::size_t networks_size = std::size_t(header[12]);
+    if (names_offset + names_size > size ||
+        thetas_offset + number_of_thetas * sizeof(double) > size ||
+        statistics_offset + number_of_samples * statistic_count *
+          sizeof(double) > size ||
+        networks_offset + networks_size > size) {
+      throw std::runtime_error(path + " is truncated.");
+    }
+
+    file_info.number_of_nodes = int(header[1]);
+    file_info.directed = (header[5] & 1) != 0;
+    file_info.include_diagonal = (header[5] & 2) != 0;
+    file_info.correlation = (header[5] & 4) != 0;
+    file_info.packed = (header[5] & 8) != 0;
+    file_info.first_sample = std::size_t(header[6]);
+    file_info.statistic_names.clear();
+    std::string names(reinterpret_cast<const char*>(bytes + names_offset),
+                      names_size);
+    std::size_t start = 0;
+    while (start < names.size()) {
+      std::size_t end = names.find('\n', start);
+      if (end == std::string::npos) {
+        end = names.size();
+      }
+      file_info.statistic_names.push_back(names.substr(start, end - start));
+      start = end + 1;
+    }
+    file_info.thetas.resize(number_of_thetas);
+    if (number_of_thetas > 0) {
+      std::memcpy(&file_info.thetas[0], bytes + thetas_offset,
+                  number_of_thetas * sizeof(double));
+    }
+    statistics_bytes = bytes + statistics_offset;
+    network_samples = NetworkSampleArchiveView(bytes + networks_offset,
+                                               networks_size);
+    if (network_samples.number_of_samples() != number_of_samples) {
+      throw std::runtime_error(path + " is not a valid sample file.");
+    }
+  }
+};
+
+} // end of gergm namespace
+
+#endif
@@ -0,0 +1,470 @@
+#ifndef GERGM_SAMPLE_STORAGE_H
+#define GERGM_SAMPLE_STORAGE_H
+
+// Compact storage for sampled networks. The samples a sampler keeps are the
+// largest object in an estimation run, and edge weights on [0,1] (or
+// correlations on [-1,1]) rarely need double precision downstream, so they
+// can be kept as single precision floats, as 16 bit fixed point, or
+// losslessly as the entries that changed since the previous sample (which is
+// most of the saving when few proposals are accepted between samples).
+// Samples are decoded one at a time, when they are needed.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <stdint.h>
+#include <vector>
+
+namespace gergm {
+
+enum NetworkStorage {
+  STORE_DOUBLE = 0,
+  STORE_FLOAT = 1,
+  STORE_FIXED16 = 2,
+  STORE_DELTA = 3
+};
+
+// Write a packed (column major) lower triangle into an n x n network,
+// mirroring the off diagonal entries.
+inline void unpack_network(const double* values,
+                           double* network,
+                           int number_of_nodes,
+                           bool include_diagonal) {
+  int k = 0;
+  for (int j = 0; j < number_of_nodes; ++j) {
+    for (int i = j; i < number_of_nodes; ++i) {
+      if (i == j) {
+        if (include_diagonal) {
+          network[i + j * number_of_nodes] = values[k];
+          k += 1;
+        }
+      } else {
+        network[i + j * number_of_nodes] = values[k];
+        network[j + i * number_of_nodes] = values[k];
+        k += 1;
+      }
+    }
+  }
+}
+
+namespace detail {
+
+// How the samples of an archive are encoded.
+struct ArchiveLayout {
+  int storage;
+  std::size_t length;
+  double lower;
+  double upper;
+  std::size_t keyframe_every;
+};
+
+// A serialized archive starts with the storage, sample length, keyframe
+// spacing and number of samples (uint64_t), then the bounds (double), then
+// one offset (uint64_t) per sample and one past the last, then the samples.
+const std::size_t archive_header_size = 4 * sizeof(uint64_t) +
+  2 * sizeof(double);
+
+// 7 bits at a time, low bits first
+inline std::size_t read_varint(const unsigned char*& bytes) {
+  std::size_t value = 0;
+  int shift = 0;
+  while (*bytes & 0x80) {
+    value |= std::size_t(*bytes & 0x7f) << shift;
+    shift += 7;
+    ++bytes;
+  }
+  value |= std::size_t(*bytes) << shift;
+  ++bytes;
+  return value;
+}
+
+inline void apply_delta(const ArchiveLayout& layout,
+                        const unsigned char* bytes,
+                        double* values) {
+  std::size_t changed = read_varint(bytes);
+  if (changed == layout.length) {
+    std::memcpy(values, bytes, layout.length * sizeof(double));
+    return;
+  }
+  std::size_t next_index = 0;
+  for (std::size_t c = 0; c < changed; ++c) {
+    std::size_t k = next_index + read_varint(bytes);
+    std::memcpy(&values[k], bytes, sizeof(double));
+    bytes += sizeof(double);
+    next_index = k + 1;
+  }
+}
+
+// Decoding shared by NetworkSampleArchive and NetworkSampleArchiveView,
+// offsets[s] is where sample s starts in data.
+template<class Offsets>
+inline void decode_network_sample(const ArchiveLayout& layout,
+                                  const unsigned char* data,
+                                  const Offsets& offsets,
+                                  std::size_t sample,
+                                  double* values,
+                                  bool values_hold_previous) {
+  const unsigned char* bytes = data + offsets[sample];
+  std::size_t length = layout.length;
+  if (layout.storage == STORE_DOUBLE) {
+    std::memcpy(values, bytes, length * sizeof(double));
+  } else if (layout.storage == STORE_FLOAT) {
+    for (std::size_t k = 0; k < length; ++k) {
+      float value;
+      std::memcpy(&value, bytes + k * sizeof(float), sizeof(float));
+      values[k] = value;
+    }
+  } else if (layout.storage == STORE_FIXED16) {
+    double scale = (layout.upper - layout.lower) / 65535.0;
+    for (std::size_t k = 0; k < length; ++k) {
+      uint16_t quantized = uint16_t(bytes[2 * k]) |
+        uint16_t(uint16_t(bytes[2 * k + 1]) << 8);
+      values[k] = layout.lower + quantized * scale;
+    }
+  } else {
+    std::size_t keyframe = sample - sample % layout.keyframe_every;
+    std::size_t first = keyframe;
+    if (values_hold_previous && sample != keyframe) {
+      first = sample;
+    } else {
+      std::memcpy(values, data + offsets[keyframe], length * sizeof(double));
+      first = keyframe + 1;
+    }
+    for (std::size_t s = first; s <= sample; ++s) {
+      apply_delta(layout, data + offsets[s], values);
+    }
+  }
+}
+
+// Offsets read in place from a serialized archive.
+struct SerializedOffsets {
+  const unsigned char* bytes;
+
+  std::size_t operator[](std::size_t sample) const {
+    uint64_t offset;
+    std::memcpy(&offset, bytes + sample * sizeof(uint64_t), sizeof(uint64_t));
+    return std::size_t(offset);
+  }
+};
+
+// Check a serialized archive and read its layout, number of samples and
+// where its offsets and samples start.
+inline ArchiveLayout read_archive_header(const unsigned char* bytes,
+                                         std::size_t size,
+                                         std::size_t& number_of_samples,
+                                         const unsigned char*& offsets,
+                                         const unsigned char*& data) {
+  if (size < archive_header_size) {
+    throw std::invalid_argument("Network sample archive is truncated.");
+  }
+  uint64_t header[4];
+  double bounds[2];
+  std::memcpy(header, bytes, sizeof(header));
+  std::memcpy(bounds, bytes + sizeof(header), sizeof(bounds));
+  ArchiveLayout layout = {static_cast<int>(header[0]),
+                          static_cast<std::size_t>(header[1]),
+                          bounds[0],
+                          bounds[1],
+                          std::max<std::size_t>(1, header[2])};
+  if (layout.storage < STORE_DOUBLE || layout.storage > STORE_DELTA) {
+    throw std::invalid_argument("Unknown network sample storage type.");
+  }
+  number_of_samples = static_cast<std::size_t>(header[3]);
+  std::size_t number_of_offsets = number_of_samples == 0 ? 0 :
+    number_of_samples + 1;
+  std::size_t position = archive_header_size;
+  if (size < position + number_of_offsets * sizeof(uint64_t)) {
+    throw std::invalid_argument("Network sample archive is truncated.");
+  }
+  offsets = bytes + position;
+  position += number_of_offsets * sizeof(uint64_t);
+  data = bytes + position;
+  if (number_of_offsets > 0) {
+    SerializedOffsets sample_offsets = {offsets};
+    if (size - position != sample_offsets[number_of_samples]) {
+      throw std::invalid_argument("Network sample archive is truncated.");
+    }
+  }
+  return layout;
+}
+
+} // end of detail namespace
+
+class NetworkSampleArchive {
+public:
+  NetworkSampleArchive()
+    : storage(STORE_DOUBLE),
+      length(0),
+      lower(0),
+      upper(1),
+      keyframe_every(32) {}
+
+  // Each sample is sample_length values. Fixed point storage covers
+  // [lower, upper], and delta storage keeps every keyframe_every-th sample
+  // whole so that decoding a sample never replays more than that many.
+  NetworkSampleArchive(int storage,
+                       std::size_t sample_length,
+                       double lower = 0,
+                       double upper = 1,
+                       std::size_t keyframe_every = 32)
+    : storage(storage),
+      length(sample_length),
+      lower(lower),
+      upper(upper),
+      keyframe_every(std::max<std::size_t>(1, keyframe_every)) {
+    if (storage < STORE_DOUBLE || storage > STORE_DELTA) {
+      throw std::invalid_argument("Unknown network sample storage type.");
+    }
+    if (storage == STORE_DELTA) {
+      previous.resize(length);
+    }
+  }
+
+  void reserve(std::size_t number_of_samples) {
+    offsets.reserve(number_of_samples + 1);
+    if (storage != STORE_DELTA) {
+      data.reserve(number_of_samples * length * value_size());
+    }
+  }
+
+  void append(const double* sample) {
+    if (offsets.empty()) {
+      offsets.push_back(0);
+    }
+    std::size_t sample_index = offsets.size() - 1;
+    if (storage == STORE_DOUBLE) {
+      push_bytes(sample, length * sizeof(double));
+    } else if (storage == STORE_FLOAT) {
+      for (std::size_t k = 0; k < length; ++k) {
+        float value = float(sample[k]);
+        push_bytes(&value, sizeof(float));
+      }
+    } else if (storage == STORE_FIXED16) {
+      double scale = 65535.0 / (upper - lower);
+      for (std::size_t k = 0; k < length; ++k) {
+        double scaled = std::floor((sample[k] - lower) * scale + 0.5);
+        uint16_t quantized = uint16_t(std::min(65535.0, std::max(0.0, scaled)));
+        data.push_back((unsigned char)(quantized & 0xff));
+        data.push_back((unsigned char)(quantized >> 8));
+      }
+    } else if (sample_index % keyframe_every == 0) {
+      push_bytes(sample, length * sizeof(double));
+      std::copy(sample, sample + length, previous.begin());
+    } else {
+      // the number of changed entries, then each as the gap since the last
+      // changed index and its value. When the index gaps would cost more
+      // than they save (the full network sampler moves every edge on
+      // acceptance) the whole sample is stored, marked as length changes.
+      std::size_t changed = 0;
+      for (std::size_t k = 0; k < length; ++k) {
+        if (std::memcmp(&sample[k], &previous[k], sizeof(double)) != 0) {
+          changed += 1;
+        }
+      }
+      if (changed * (sizeof(double) + 1) >= length * sizeof(double)) {
+        push_varint(length);
+        push_bytes(sample, length * sizeof(double));
+        std::copy(sample, sample + length, previous.begin());
+        offsets.push_back(data.size());
+        return;
+      }
+      push_varint(changed);
+      std::size_t next_index = 0;
+      for (std::size_t k = 0; k < length; ++k) {
+        if (std::memcmp(&sample[k], &previous[k], sizeof(double)) != 0) {
+          push_varint(k - next_index);
+          push_bytes(&sample[k], sizeof(double));
+          previous[k] = sample[k];
+          next_index = k + 1;
+        }
+      }
+    }
+    offsets.push_back(data.size());
+  }
+
+  // Decode a sample into values (sample_length of them). If values already
+  // holds the previous sample, say so with values_hold_previous and delta
+  // storage only applies this sample's changes.
+  void decode(std::size_t sample,
+              double* values,
+              bool values_hold_previous = false) const {
+    if (sample >= number_of_samples()) {
+      throw std::out_of_range("Network sample index out of range.");
+    }
+    detail::decode_network_sample(layout(), data.data(), offsets, sample,
+                                  values, values_hold_previous);
+  }
+
+  // A new archive holding the given samples, in order.
+  NetworkSampleArchive select(const std::vector<std::size_t>& samples) const {
+    NetworkSampleArchive selected(storage, length, lower, upper,
+                                  keyframe_every);
+    selected.reserve(samples.size());
+    std::vector<double> values(length);
+    for (std::size_t s = 0; s < samples.size(); ++s) {
+      bool consecutive = s > 0 && samples[s] == samples[s - 1] + 1;
+      decode(samples[s], values.data(), consecutive);
+      selected.append(values.data());
+    }
+    return selected;
+  }
+
+  std::size_t number_of_samples() const {
+    return offsets.empty() ? 0 : offsets.size() - 1;
+  }
+
+  std::size_t sample_length() const {
+    return length;
+  }
+
+  int storage_type() const {
+    return storage;
+  }
+
+  // bytes used by the encoded samples
+  std::size_t size_in_bytes() const {
+    return data.size() + offsets.size() * sizeof(uint64_t);
+  }
+
+  // A self contained byte string (native byte order), for keeping the
+  // archive in an R raw vector or a sample file. NetworkSampleArchiveView
+  // reads it in place.
+  void serialize(std::vector<unsigned char>& out) const {
+    out.clear();
+    uint64_t header[4] = {uint64_t(storage), uint64_t(length),
+                          uint64_t(keyframe_every),
+                          uint64_t(number_of_samples())};
+    append_bytes(out, header, sizeof(header));
+    double bounds[2] = {lower, upper};
+    append_bytes(out, bounds, sizeof(bounds));
+    for (std::size_t s = 0; s < offsets.size(); ++s) {
+      uint64_t offset = offsets[s];
+      append_bytes(out, &offset, sizeof(uint64_t));
+    }
+    out.insert(out.end(), data.begin(), data.end());
+  }
+
+  static NetworkSampleArchive deserialize(const unsigned char* bytes,
+                                          std::size_t size) {
+    std::size_t number_of_samples = 0;
+    const unsigned char* offsets = NULL;
+    const unsigned char* samples = NULL;
+    detail::ArchiveLayout layout = detail::read_archive_header(
+      bytes, size, number_of_samples, offsets, samples);
+    NetworkSampleArchive archive(layout.storage, layout.length, layout.lower,
+                                 layout.upper, layout.keyframe_every);
+    detail::SerializedOffsets sample_offsets = {offsets};
+    if (number_of_samples > 0) {
+      archive.offsets.resize(number_of_samples + 1);
+      for (std::size_t s = 0; s <= number_of_samples; ++s) {
+        archive.offsets[s] = sample_offsets[s];
+      }
+    }
+    archive.data.assign(samples, bytes + size);
+    return archive;
+  }
+
+private:
+  int storage;
+  std::size_t length;
+  double lower;
+  double upper;
+  std::size_t keyframe_every;
+  std::vector<unsigned char> data;
+  // where each sample starts in data, and one past the last sample
+  std::vector<std::size_t> offsets;
+  // the last sample appended, for delta storage
+  std::vector<double> previous;
+
+  detail::ArchiveLayout layout() const {
+    detail::ArchiveLayout archive_layout = {storage, length, lower, upper,
+                                            keyframe_every};
+    return archive_layout;
+  }
+
+  std::size_t value_size() const {
+    if (storage == STORE_FLOAT) {
+      return sizeof(float);
+    }
+    if (storage == STORE_FIXED16) {
+      return 2;
+    }
+    return sizeof(double);
+  }
+
+  static void append_bytes(std::vector<unsigned char>& out,
+                           const void* source,
+                           std::size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(source);
+    out.insert(out.end(), bytes, bytes + size);
+  }
+
+  void push_bytes(const void* source, std::size_t size) {
+    append_bytes(data, source, size);
+  }
+
+  // 7 bits at a time, low bits first
+  void push_varint(std::size_t value) {
+    while (value >= 0x80) {
+      data.push_back((unsigned char)((value & 0x7f) | 0x80));
+      value >>= 7;
+    }
+    data.push_back((unsigned char)value);
+  }
+};
+
+// Decodes samples straight from a serialized archive (for example in a
+// memory mapped sample file) without copying it. The bytes must outlive the
+// view.
+class NetworkSampleArchiveView {
+public:
+  NetworkSampleArchiveView()
+    : count(0),
+      data(NULL) {
+    layout.storage = STORE_DOUBLE;
+    layout.length = 0;
+    layout.lower = 0;
+    layout.upper = 1;
+    layout.keyframe_every = 1;
+    offsets.bytes = NULL;
+  }
+
+  NetworkSampleArchiveView(const unsigned char* bytes, std::size_t size) {
+    layout = detail::read_archive_header(bytes, size, count, offsets.bytes,
+                                         data);
+  }
+
+  void decode(std::size_t sample,
+              double* values,
+              bool values_hold_previous = false) const {
+    if (sample >= count) {
+      throw std::out_of_range("Network sample index out of range.");
+    }
+    detail::decode_network_sample(layout, data, offsets, sample, values,
+                                  values_hold_previous);
+  }
+
+  std::size_t number_of_samples() const {
+    return count;
+  }
+
+  std::size_t sample_length() const {
+    return layout.length;
+  }
+
+  int storage_type() const {
+    return layout.storage;
+  }
+
+private:
+  detail::ArchiveLayout layout;
+  std::size_t count;
+  detail::SerializedOffsets offsets;
+  const unsigned char* data;
+};
+
+} // end of gergm namespace
+
+#endif
@@ -0,0 +1,149 @@
+#ifndef GERGM_SAMPLER_CONTROL_H
+#define GERGM_SAMPLER_CONTROL_H
+
+// Progress reporting and cancellation for a sampler running on one thread
+// while others watch it (see async_sampler.h). The sampler records every
+// iteration and stored sample, and stops after the current iteration once a
+// cancel has been requested. Counters are published after the values they
+// count are written, so a watcher that reads a count can read that many
+// iterations and samples of the output. Samplers run without a control (a
+// NULL pointer) skip all of this.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+namespace gergm {
+
+struct SamplerProgress {
+  int iterations_done;
+  int number_of_iterations;
+  int samples_stored;
+  // of the iterations done, 0 before the first
+  double acceptance_rate;
+  double elapsed_seconds;
+  // estimated from the time per iteration so far, -1 before the first
+  double remaining_seconds;
+  bool cancel_requested;
+};
+
+class SamplerControl {
+public:
+  SamplerControl()
+    : number_of_iterations(0),
+      iterations_done(0),
+      accepted(0),
+      samples_stored(0),
+      start_ticks(0),
+      cancel_flag(false) {}
+
+  // Called by the sampler before its first iteration.
+  void start(int iterations) {
+    iterations_done.store(0, std::memory_order_relaxed);
+    accepted.store(0, std::memory_order_relaxed);
+    samples_stored.store(0, std::memory_order_relaxed);
+    start_ticks.store(now_ticks(), std::memory_order_relaxed);
+    number_of_iterations.store(iterations, std::memory_order_release);
+  }
+
+  void record_iteration(bool proposal_accepted) {
+    if (proposal_accepted) {
+      accepted.fetch_add(1, std::memory_order_relaxed);
+    }
+    iterations_done.fetch_add(1, std::memory_order_release);
+  }
+
+  void record_sample() {
+    samples_stored.fetch_add(1, std::memory_order_release);
+  }
+
+  void request_cancel() {
+    cancel_flag.store(true, std::memory_order_relaxed);
+  }
+
+  bool cancel_requested() const {
+    return cancel_flag.load(std::memory_order_relaxed);
+  }
+
+  int completed_iterations() const {
+    return iterations_done.load(std::memory_order_acquire);
+  }
+
+  int stored_samples() const {
+    return samples_stored.load(std::memory_order_acquire);
+  }
+
+  SamplerProgress progress() const {
+    SamplerProgress progress;
+    progress.number_of_iterations =
+      number_of_iterations.load(std::memory_order_acquire);
+    progress.iterations_done = completed_iterations();
+    progress.samples_stored = stored_samples();
+    progress.cancel_requested = cancel_requested();
+    int accepted_proposals = accepted.load(std::memory_order_relaxed);
+    progress.acceptance_rate = 0;
+    progress.elapsed_seconds = 0;
+    progress.remaining_seconds = -1;
+    if (progress.number_of_iterations > 0) {
+      progress.elapsed_seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::duration(
+          now_ticks() - start_ticks.load(std::memory_order_relaxed))).count();
+    }
+    if (progress.iterations_done > 0) {
+      progress.acceptance_rate =
+        double(accepted_proposals) / double(progress.iterations_done);
+      progress.remaining_seconds = progress.elapsed_seconds *
+        double(progress.number_of_iterations - progress.iterations_done) /
+        double(progress.iterations_done);
+    }
+    return progress;
+  }
+
+  // Held by the sampler while it changes output that a watcher may be
+  // copying: growing an archive of samples, and trimming the output of a
+  // cancelled run.
+  std::mutex& output_mutex() const {
+    return output_guard;
+  }
+
+private:
+  static std::int64_t now_ticks() {
+    return std::int64_t(
+      std::chrono::steady_clock::now().time_since_epoch().count());
+  }
+
+  std::atomic<int> number_of_iterations;
+  std::atomic<int> iterations_done;
+  std::atomic<int> accepted;
+  std::atomic<int> samples_stored;
+  std::atomic<std::int64_t> start_ticks;
+  std::atomic<bool> cancel_flag;
+  mutable std::mutex output_guard;
+};
+
+// Locks the output mutex of a control, if there is one.
+class SamplerOutputLock {
+public:
+  explicit SamplerOutputLock(const SamplerControl* control)
+    : mutex(control == NULL ? NULL : &control->output_mutex()) {
+    if (mutex != NULL) {
+      mutex->lock();
+    }
+  }
+
+  ~SamplerOutputLock() {
+    if (mutex != NULL) {
+      mutex->unlock();
+    }
+  }
+
+private:
+  SamplerOutputLock(const SamplerOutputLock&);
+  SamplerOutputLock& operator=(const SamplerOutputLock&);
+  std::mutex* mutex;
+};
+
+} // end of gergm namespace
+
+#endif
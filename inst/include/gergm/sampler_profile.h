@@ -0,0 +1,64 @@
+#ifndef GERGM_SAMPLER_PROFILE_H
+#define GERGM_SAMPLER_PROFILE_H
+
+// Optional instrumentation of the sampler hot paths. Compile with
+// -DGERGM_PROFILE (see Makevars) to record cumulative time per sampler phase
+// and counts of the expensive operations. Without the flag the macros below
+// expand to nothing, so there is no cost in normal builds. The R package
+// converts the profile to a list, or returns NULL in its place (see
+// src/gergm_r.h).
+
+#ifdef GERGM_PROFILE
+#include <chrono>
+#endif
+
+namespace gergm {
+
+struct SamplerProfile {
+  // cumulative seconds in each phase
+  double proposal_seconds;
+  double statistic_seconds;
+  double correlation_transform_seconds;
+  double accept_seconds;
+  double storage_seconds;
+  // number of calls to the h function (each evaluates every statistic once)
+  double statistic_evaluations;
+  // truncated normal draws, including those rejected for falling outside
+  // [0,1], and the number of edges proposed
+  double proposal_draws;
+  double proposed_edges;
+  // bytes of network copied between buffers (proposals and sample storage)
+  double bytes_copied;
+
+  SamplerProfile()
+    : proposal_seconds(0),
+      statistic_seconds(0),
+      correlation_transform_seconds(0),
+      accept_seconds(0),
+      storage_seconds(0),
+      statistic_evaluations(0),
+      proposal_draws(0),
+      proposed_edges(0),
+      bytes_copied(0) {}
+};
+
+} // end of gergm namespace
+
+#ifdef GERGM_PROFILE
+#define GERGM_PROFILE_START(phase) \
+  std::chrono::steady_clock::time_point phase##_start = \
+    std::chrono::steady_clock::now()
+#define GERGM_PROFILE_STOP(profile, phase) \
+  (profile).phase##_seconds += std::chrono::duration<double>( \
+    std::chrono::steady_clock::now() - phase##_start).count()
+#define GERGM_PROFILE_COUNT(profile, counter, amount) \
+  (profile).counter += (amount)
+#else
+// the profile is still referenced so that a SamplerProfile& passed in only
+// for profiling is not an unused parameter
+#define GERGM_PROFILE_START(phase)
+#define GERGM_PROFILE_STOP(profile, phase) ((void)(profile))
+#define GERGM_PROFILE_COUNT(profile, counter, amount) ((void)(profile))
+#endif
+
+#endif
@@ -0,0 +1,249 @@
+#ifndef GERGM_STATISTIC_GRADIENTS_H
+#define GERGM_STATISTIC_GRADIENTS_H
+
+// Gradients of the h function theta' h(net), for samplers that move every
+// edge along the gradient (see hamiltonian_monte_carlo.h). The base
+// statistics are polynomials in the edge values raised to a power p (alpha,
+// or 1 when the statistics are downweighted together), so the gradients are
+// worked out with respect to those powered values V = net^p and the chain
+// rule is applied once per edge. Over every triple and pair of nodes they
+// are matrix expressions of V: row and column sums for the 2-stars, V' for
+// reciprocity and products of V for the triads. Over some of the rows (node
+// subset statistics, or triples that are not all of them) they are summed
+// row by row.
+
+#include <armadillo>
+#include <cmath>
+#include "model.h"
+#include "network_statistics.h"
+
+namespace gergm {
+
+// Add weight times the gradient of base_statistic_term(V, index, a, b, c, 1)
+// with respect to V into gradient.
+inline void add_base_statistic_term_gradient(const arma::mat& V,
+                                             int base_statistic_index,
+                                             int a,
+                                             int b,
+                                             int c,
+                                             double weight,
+                                             arma::mat& gradient) {
+  if (base_statistic_index == 3) {
+    gradient(a, b) += weight * V(b, a);
+    gradient(b, a) += weight * V(a, b);
+    return;
+  }
+  if (base_statistic_index == 5) {
+    gradient(a, b) += weight;
+    gradient(b, a) += weight;
+    return;
+  }
+  double ab = V(a, b);
+  double ba = V(b, a);
+  double ac = V(a, c);
+  double ca = V(c, a);
+  double bc = V(b, c);
+  double cb = V(c, b);
+  if (base_statistic_index == 0) {
+    // ab * ac + ba * bc + ca * cb
+    gradient(a, b) += weight * ac;
+    gradient(a, c) += weight * ab;
+    gradient(b, a) += weight * bc;
+    gradient(b, c) += weight * ba;
+    gradient(c, a) += weight * cb;
+    gradient(c, b) += weight * ca;
+  }
+  if (base_statistic_index == 1) {
+    // ca * ba + cb * ab + ac * bc
+    gradient(c, a) += weight * ba;
+    gradient(b, a) += weight * ca;
+    gradient(c, b) += weight * ab;
+    gradient(a, b) += weight * cb;
+    gradient(a, c) += weight * bc;
+    gradient(b, c) += weight * ac;
+  }
+  if (base_statistic_index == 2) {
+    // ab * bc * ca + ba * cb * ac
+    gradient(a, b) += weight * bc * ca;
+    gradient(b, c) += weight * ab * ca;
+    gradient(c, a) += weight * ab * bc;
+    gradient(b, a) += weight * cb * ac;
+    gradient(c, b) += weight * ba * ac;
+    gradient(a, c) += weight * ba * cb;
+  }
+  if (base_statistic_index == 4) {
+    // ab * bc * ac + ab * cb * ca + ab * cb * ac +
+    // ba * bc * ca + ba * bc * ac + ba * cb * ca
+    gradient(a, b) += weight * (bc * ac + cb * ca + cb * ac);
+    gradient(b, a) += weight * (bc * ca + bc * ac + cb * ca);
+    gradient(b, c) += weight * (ab * ac + ba * ca + ba * ac);
+    gradient(c, b) += weight * (ab * ca + ab * ac + ba * ca);
+    gradient(a, c) += weight * (ab * bc + ab * cb + ba * bc);
+    gradient(c, a) += weight * (ab * cb + ba * bc + ba * cb);
+  }
+}
+
+// The sum of a base statistic's terms over the given rows of triples (or
+// pairs, for the dyad statistics) of V, adding its gradient with respect to
+// V into gradient. selected_rows may be NULL to use every row.
+inline double rowwise_statistic_gradient(const arma::mat& V,
+                                         int base_statistic_index,
+                                         const arma::Mat<double>& triples,
+                                         const arma::Mat<double>& pairs,
+                                         const arma::uword* selected_rows,
+                                         int number_of_rows,
+                                         arma::mat& gradient) {
+  bool dyadic = base_statistic_index == 3 || base_statistic_index == 5;
+  const arma::Mat<double>& rows = dyadic ? pairs : triples;
+  double total = 0;
+  for (int i = 0; i < number_of_rows; ++i) {
+    arma::uword row = selected_rows == NULL ? arma::uword(i) :
+      selected_rows[i];
+    int a = rows(row, 0);
+    int b = rows(row, 1);
+    int c = dyadic ? 0 : int(rows(row, 2));
+    total += base_statistic_term(V, base_statistic_index, a, b, c, 1);
+    add_base_statistic_term_gradient(V, base_statistic_index, a, b, c, 1,
+                                     gradient);
+  }
+  return total;
+}
+
+// The same over every triple and pair of nodes, from matrix products. V must
+// have a zero diagonal, which leaves out the terms with repeated nodes.
+// Writes the gradient with respect to V into gradient.
+inline double complete_statistic_gradient(const arma::mat& V,
+                                          int base_statistic_index,
+                                          arma::mat& gradient) {
+  int number_of_nodes = V.n_rows;
+  double total = 0;
+  if (base_statistic_index == 0 || base_statistic_index == 1) {
+    // every pair of out (in) edges of each node: (r^2 - sum of squares) / 2,
+    // with r the row (column) sums
+    bool out = base_statistic_index == 0;
+    arma::vec sums = arma::zeros(number_of_nodes);
+    double squares = 0;
+    for (int j = 0; j < number_of_nodes; ++j) {
+      for (int i = 0; i < number_of_nodes; ++i) {
+        sums[out ? i : j] += V(i, j);
+        squares += V(i, j) * V(i, j);
+      }
+    }
+    for (int i = 0; i < number_of_nodes; ++i) {
+      total += sums[i] * sums[i];
+    }
+    total = (total - squares) / 2;
+    gradient = arma::zeros(number_of_nodes, number_of_nodes);
+    for (int j = 0; j < number_of_nodes; ++j) {
+      for (int i = 0; i < number_of_nodes; ++i) {
+        gradient(i, j) = sums[out ? i : j] - V(i, j);
+      }
+    }
+  } else if (base_statistic_index == 2) {
+    // every 3-cycle is counted three times in trace(V^3)
+    arma::mat V2 = V * V;
+    gradient = V2.t();
+    total = arma::accu(gradient % V) / 3;
+  } else if (base_statistic_index == 3) {
+    gradient = V.t();
+    total = arma::accu(gradient % V) / 2;
+  } else if (base_statistic_index == 4) {
+    // sum over i -> j -> k with i -> k of V(i,j) V(j,k) V(i,k)
+    arma::mat V2 = V * V;
+    total = arma::accu(V2 % V);
+    gradient = V * V.t() + V.t() * V + V2;
+  } else if (base_statistic_index == 5) {
+    total = arma::accu(V);
+    gradient = arma::ones(number_of_nodes, number_of_nodes);
+  }
+  gradient.diag().zeros();
+  return total;
+}
+
+// True when triples and pairs hold every triple and pair of nodes (as passed
+// in by the R package), so complete_statistic_gradient() can be used for the
+// base statistics.
+inline bool uses_all_node_combinations(const GergmModel& model) {
+  double n = model.number_of_nodes;
+  return double(model.triples.n_rows) == n * (n - 1) * (n - 2) / 6 &&
+    double(model.pairs.n_rows) == n * (n - 1) / 2;
+}
+
+// theta' h(net) for the statistics of the model, calculated on its triples
+// and pairs (triad sampling is not used), and its gradient with respect to
+// the logits log(w / (1 - w)) of the edge values w of net, written into
+// gradient. Each edge value of the diagonal and of both triangles has its
+// own entry, so for undirected networks the gradient of an edge is the sum
+// of its two entries. net must be in (0,1) off the diagonal.
+inline double h_function_logit_gradient(const GergmModel& model,
+                                        const arma::vec& thetas,
+                                        const arma::mat& net,
+                                        arma::mat& gradient) {
+  int number_of_nodes = model.number_of_nodes;
+  bool complete = uses_all_node_combinations(model);
+  gradient = arma::zeros(number_of_nodes, number_of_nodes);
+  // d w / d logit(w)
+  arma::mat edge_derivative = net % (1 - net);
+  arma::mat V;
+  arma::mat statistic_gradient;
+  double previous_power = -1;
+  double h_value = 0;
+
+  for (int m = 0; m < int(model.statistics_to_use.n_elem); ++m) {
+    int base_statistic_index = model.statistics_to_use[m];
+    double alpha = model.alphas[m];
+    if (base_statistic_index == 6) {
+      // the sum of the diagonal, not raised to any power
+      h_value += thetas[m] * arma::accu(arma::diagvec(net));
+      for (int i = 0; i < number_of_nodes; ++i) {
+        gradient(i, i) += thetas[m] * edge_derivative(i, i);
+      }
+      continue;
+    }
+    double p = model.together == 1 ? 1 : alpha;
+    if (p != previous_power) {
+      V = p == 1 ? net : arma::mat(arma::pow(net, p));
+      // the matrix forms need a zero diagonal. Row by row, the diagonal is
+      // kept for the (i,i,j) triples of models that include it, which read
+      // the diagonal edge values as the Metropolis Hastings sampler does.
+      if (complete) {
+        V.diag().zeros();
+      }
+      previous_power = p;
+    }
+    double statistic = 0;
+    if (model.non_base_statistic_indicator[m] == 1) {
+      statistic_gradient = arma::zeros(number_of_nodes, number_of_nodes);
+      statistic = rowwise_statistic_gradient(
+        V, base_statistic_index, model.triples, model.pairs,
+        model.use_selected_rows.colptr(m), int(model.rows_to_use[m]) + 1,
+        statistic_gradient);
+    } else if (complete) {
+      statistic = complete_statistic_gradient(V, base_statistic_index,
+                                              statistic_gradient);
+    } else {
+      bool dyadic = base_statistic_index == 3 || base_statistic_index == 5;
+      statistic_gradient = arma::zeros(number_of_nodes, number_of_nodes);
+      statistic = rowwise_statistic_gradient(
+        V, base_statistic_index, model.triples, model.pairs, NULL,
+        dyadic ? model.pairs.n_rows : model.triples.n_rows,
+        statistic_gradient);
+    }
+    // d V / d logit(w) is p V (1 - w), and h = statistic^alpha when the
+    // statistics are downweighted together
+    double scale = thetas[m];
+    if (model.together == 1) {
+      h_value += thetas[m] * std::pow(statistic, alpha);
+      scale *= alpha * std::pow(statistic, alpha - 1);
+      gradient += scale * (statistic_gradient % edge_derivative);
+    } else {
+      h_value += thetas[m] * statistic;
+      gradient += (scale * p) * (statistic_gradient % V % (1 - net));
+    }
+  }
+  return h_value;
+}
+
+} // end of gergm namespace
+
+#endif
@@ -0,0 +1,317 @@
+#ifndef GERGM_TRIAD_SAMPLING_H
+#define GERGM_TRIAD_SAMPLING_H
+
+// Random subsamples of triples and pairs for stochastic MH.
+
+#include <armadillo>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <unordered_set>
+#include <vector>
+#include "network_statistics.h"
+#include "random.h"
+
+namespace gergm {
+
+  // Stochastic MH subsampling. Rather than having R build tables of random
+  // rows of triples and pairs, we draw positions in the colex ordering of all
+  // node triples (or pairs) and unrank them directly, so each refresh is
+  // O(sample size) and needs no copy of the full triples matrix.
+
+  // number of ways to choose k of n, as a double so large networks are fine
+  inline double choose_nodes(double n, int k) {
+    if (n < k) {
+      return 0;
+    }
+    if (k == 2) {
+      return n * (n - 1) / 2;
+    }
+    return n * (n - 1) * (n - 2) / 6;
+  }
+
+  // largest m such that choose(m, k) <= rank
+  inline double largest_index_below(double rank, int k) {
+    double m = 0;
+    if (k == 2) {
+      m = std::floor(std::sqrt(2 * rank));
+    } else {
+      m = std::floor(std::cbrt(6 * rank));
+    }
+    while (choose_nodes(m + 1, k) <= rank) {
+      m += 1;
+    }
+    while (m > 0 && choose_nodes(m, k) > rank) {
+      m -= 1;
+    }
+    return m;
+  }
+
+  // Floyd's algorithm for sample_size distinct draws from 0, ..., population - 1,
+  // returned in increasing order.
+  inline std::vector<double> sample_positions(double population,
+                                              int sample_size,
+                                              std::mt19937& generator) {
+    random::uniform_01<double> uniform_distribution;
+    std::unordered_set<double> drawn;
+    std::vector<double> positions;
+    positions.reserve(sample_size);
+    for (double j = population - sample_size; j < population; j += 1) {
+      double t = std::floor(uniform_distribution(generator) * (j + 1));
+      if (drawn.count(t) > 0) {
+        t = j;
+      }
+      drawn.insert(t);
+      positions.push_back(t);
+    }
+    std::sort(positions.begin(), positions.end());
+    return positions;
+  }
+
+  // True when triples also holds the n(n-1) rows (i,i,j) that R appends
+  // after the distinct node triples for models that include the diagonal
+  // (see node_tuples()).
+  inline bool triples_include_diagonal(int number_of_nodes,
+                                       const arma::Mat<double>& triples) {
+    return double(triples.n_rows) > choose_nodes(number_of_nodes, 3);
+  }
+
+  // Draw a new subsample of stochastic_MH_proportion of the triples and pairs
+  // (at least two of each), in the same 0-indexed format as the triples and
+  // pairs matrices passed in from R. With include_diagonal the triples are
+  // drawn from the distinct node triples followed by every (i,i,j), i != j,
+  // in the order R builds them.
+  inline void draw_random_triad_samples(int number_of_nodes,
+                                        double stochastic_MH_proportion,
+                                        bool include_diagonal,
+                                        std::mt19937& generator,
+                                        arma::Mat<double>& random_triad_samples,
+                                        arma::Mat<double>& random_dyad_samples) {
+
+    double number_of_distinct_triples = choose_nodes(number_of_nodes, 3);
+    double number_of_triples = number_of_distinct_triples;
+    if (include_diagonal) {
+      number_of_triples += double(number_of_nodes) * (number_of_nodes - 1);
+    }
+    double number_of_pairs = choose_nodes(number_of_nodes, 2);
+    int triad_sample_size = std::min(
+      std::max(std::ceil(number_of_triples * stochastic_MH_proportion), 2.0),
+      number_of_triples);
+    int dyad_sample_size = std::min(
+      std::max(std::ceil(number_of_pairs * stochastic_MH_proportion), 2.0),
+      number_of_pairs);
+
+    std::vector<double> positions = sample_positions(number_of_triples,
+                                                     triad_sample_size,
+                                                     generator);
+    random_triad_samples.set_size(triad_sample_size, 3);
+    for (int i = 0; i < triad_sample_size; ++i) {
+      double rank = positions[i];
+      if (rank >= number_of_distinct_triples) {
+        // row (i,i,j) of the diagonal block, i major and skipping j == i
+        double offset = rank - number_of_distinct_triples;
+        double node = std::floor(offset / (number_of_nodes - 1));
+        double other = offset - node * (number_of_nodes - 1);
+        if (other >= node) {
+          other += 1;
+        }
+        random_triad_samples(i, 0) = node;
+        random_triad_samples(i, 1) = node;
+        random_triad_samples(i, 2) = other;
+        continue;
+      }
+      double c = largest_index_below(rank, 3);
+      rank -= choose_nodes(c, 3);
+      double b = largest_index_below(rank, 2);
+      rank -= choose_nodes(b, 2);
+      random_triad_samples(i, 0) = rank;
+      random_triad_samples(i, 1) = b;
+      random_triad_samples(i, 2) = c;
+    }
+
+    positions = sample_positions(number_of_pairs, dyad_sample_size, generator);
+    random_dyad_samples.set_size(dyad_sample_size, 2);
+    for (int i = 0; i < dyad_sample_size; ++i) {
+      double rank = positions[i];
+      double b = largest_index_below(rank, 2);
+      random_dyad_samples(i, 0) = rank - choose_nodes(b, 2);
+      random_dyad_samples(i, 1) = b;
+    }
+  }
+
+  // Vose's alias method, after an O(n) setup each draw from probabilities is
+  // O(1). alias_probability[k] is the chance of keeping bucket k rather than
+  // moving to alias[k].
+  inline void build_alias_table(const arma::vec& probabilities,
+                                arma::vec& alias_probability,
+                                arma::uvec& alias) {
+    int n = probabilities.n_elem;
+    alias_probability = probabilities * double(n);
+    alias = arma::regspace<arma::uvec>(0, n - 1);
+    std::vector<int> small;
+    std::vector<int> large;
+    for (int k = 0; k < n; ++k) {
+      if (alias_probability[k] < 1) {
+        small.push_back(k);
+      } else {
+        large.push_back(k);
+      }
+    }
+    while (!small.empty() && !large.empty()) {
+      int s = small.back();
+      small.pop_back();
+      int l = large.back();
+      alias[s] = l;
+      alias_probability[l] -= 1 - alias_probability[s];
+      if (alias_probability[l] < 1) {
+        large.pop_back();
+        small.push_back(l);
+      }
+    }
+    // anything left over is only off from one by rounding error
+    for (int k = 0; k < int(small.size()); ++k) {
+      alias_probability[small[k]] = 1;
+    }
+    for (int k = 0; k < int(large.size()); ++k) {
+      alias_probability[large[k]] = 1;
+    }
+  }
+
+  inline int draw_from_alias_table(const arma::vec& alias_probability,
+                                   const arma::uvec& alias,
+                                   std::mt19937& generator) {
+    random::uniform_01<double> uniform_distribution;
+    int n = alias_probability.n_elem;
+    int k = std::min(int(uniform_distribution(generator) * n), n - 1);
+    if (uniform_distribution(generator) < alias_probability[k]) {
+      return k;
+    }
+    return alias[k];
+  }
+
+  // Sampling probabilities for the weighted subsample, proportional to the
+  // absolute contribution of each triple to theta' h on network. Only the
+  // triad base statistics (0, 1, 2 and 4) are summed over triples. When the
+  // statistics are exponentiated after summing (together == 1) each term is
+  // scaled by the derivative alpha S^(alpha - 1) of its statistic S, so the
+  // contributions are those of the linearized h. A fraction
+  // uniform_proportion of the probability is spread evenly over the triples,
+  // which keeps every Horvitz-Thompson weight below 1/uniform_proportion times
+  // the uniform one when the network moves away from the one the
+  // probabilities were calculated on.
+  inline void triad_contribution_probabilities(
+      const arma::mat& network,
+      const arma::Mat<double>& triples,
+      const arma::vec& statistics_to_use,
+      const arma::vec& thetas,
+      const arma::vec& alphas,
+      int together,
+      const arma::vec& non_base_statistic_indicator,
+      double uniform_proportion,
+      arma::vec& triad_probabilities) {
+    int number_of_triples = triples.n_rows;
+    triad_probabilities.zeros(number_of_triples);
+    arma::vec terms(number_of_triples);
+    for (int s = 0; s < int(statistics_to_use.n_elem); ++s) {
+      int base_statistic_index = statistics_to_use[s];
+      if (non_base_statistic_indicator[s] == 1 || base_statistic_index == 3 ||
+          base_statistic_index == 5 || base_statistic_index == 6) {
+        continue;
+      }
+      double p = alphas[s];
+      if (together == 1) {
+        p = 1;
+      }
+      for (int t = 0; t < number_of_triples; ++t) {
+        terms[t] = gergm::base_statistic_term(network, base_statistic_index,
+                                              triples(t, 0), triples(t, 1),
+                                              triples(t, 2), p);
+      }
+      double scale = thetas[s];
+      if (together == 1) {
+        scale *= alphas[s] * pow(arma::accu(terms), alphas[s] - 1);
+      }
+      if (!std::isfinite(scale)) {
+        // the statistic is zero on network and alpha < 1
+        continue;
+      }
+      triad_probabilities += scale * terms;
+    }
+    triad_probabilities = arma::abs(triad_probabilities);
+    double total = arma::accu(triad_probabilities);
+    if (!(total > 0) || !std::isfinite(total)) {
+      // no triple contributes, so there is nothing to weight by
+      triad_probabilities.fill(1.0 / number_of_triples);
+      return;
+    }
+    triad_probabilities = (1 - uniform_proportion) * triad_probabilities / total
+      + uniform_proportion / number_of_triples;
+  }
+
+  // Importance weighted version of draw_random_triad_samples(). Triples are
+  // drawn with replacement in proportion to triad_contribution_probabilities()
+  // and pairs are drawn uniformly without replacement. An extra last column
+  // holds the Horvitz-Thompson weight of each row (1/(m p_t) for triples,
+  // number_of_pairs/m for pairs) so weighted_sample_statistic() gives an
+  // unbiased estimate of the full sums. The probabilities and alias table are
+  // only recalculated when update_weights is true; the sampler does this on a
+  // fixed schedule rather than every time the network moves, since it costs a
+  // pass over all triples.
+  inline void draw_weighted_random_triad_samples(const arma::mat& network,
+                                                 const arma::Mat<double>& triples,
+                                                 int number_of_nodes,
+                                                 double stochastic_MH_proportion,
+                                                 const arma::vec& statistics_to_use,
+                                                 const arma::vec& thetas,
+                                                 const arma::vec& alphas,
+                                                 int together,
+                                                 const arma::vec& non_base_statistic_indicator,
+                                                 bool update_weights,
+                                                 arma::vec& triad_probabilities,
+                                                 arma::vec& alias_probability,
+                                                 arma::uvec& alias,
+                                                 std::mt19937& generator,
+                                                 arma::Mat<double>& random_triad_samples,
+                                                 arma::Mat<double>& random_dyad_samples) {
+
+    double number_of_triples = triples.n_rows;
+    double number_of_pairs = choose_nodes(number_of_nodes, 2);
+    if (update_weights) {
+      gergm::triad_contribution_probabilities(network, triples,
+                                              statistics_to_use, thetas,
+                                              alphas, together,
+                                              non_base_statistic_indicator,
+                                              0.1, triad_probabilities);
+      gergm::build_alias_table(triad_probabilities, alias_probability, alias);
+    }
+
+    int triad_sample_size = std::max(
+      std::ceil(number_of_triples * stochastic_MH_proportion), 2.0);
+    random_triad_samples.set_size(triad_sample_size, 4);
+    for (int i = 0; i < triad_sample_size; ++i) {
+      int t = gergm::draw_from_alias_table(alias_probability, alias, generator);
+      random_triad_samples(i, 0) = triples(t, 0);
+      random_triad_samples(i, 1) = triples(t, 1);
+      random_triad_samples(i, 2) = triples(t, 2);
+      random_triad_samples(i, 3) = 1/(triad_sample_size * triad_probabilities[t]);
+    }
+
+    int dyad_sample_size = std::min(
+      std::max(std::ceil(number_of_pairs * stochastic_MH_proportion), 2.0),
+      number_of_pairs);
+    std::vector<double> positions = sample_positions(number_of_pairs,
+                                                     dyad_sample_size,
+                                                     generator);
+    random_dyad_samples.set_size(dyad_sample_size, 3);
+    for (int i = 0; i < dyad_sample_size; ++i) {
+      double rank = positions[i];
+      double b = largest_index_below(rank, 2);
+      random_dyad_samples(i, 0) = rank - choose_nodes(b, 2);
+      random_dyad_samples(i, 1) = b;
+      random_dyad_samples(i, 2) = number_of_pairs / dyad_sample_size;
+    }
+  }
+
+} // end of gergm namespace
+
+#endif
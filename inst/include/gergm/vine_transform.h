@@ -0,0 +1,167 @@
+#ifndef GERGM_VINE_TRANSFORM_H
+#define GERGM_VINE_TRANSFORM_H
+
+// Shared D-vine transform between partial correlations and correlations. Used
+// by the samplers in both the mjd and gergm namespaces and by the exported
+// Corr_to_Part()/Part_to_Corr() functions. Only depends on Armadillo.
+
+#include <armadillo>
+#include <cmath>
+
+namespace vine {
+
+// Walk the D-vine band by band (k = 1, ..., d - 1). For every window [a, b]
+// we carry the coefficients of the regression of X_b on X_a..X_{b-1}
+// (forward) and of X_a on X_{a+1}..X_b (backward), along with their residual
+// variances. Moving from band k - 1 to band k is a single Schur complement
+// step on these coefficients, so we never form or invert the (k-1) x (k-1)
+// sub-blocks of the correlation matrix and the whole sweep is O(d^3).
+//
+// If fill_correlations is true, partials is read and correlations is filled
+// in off of the first band, otherwise correlations is read and partials is
+// filled in. Both matrices are assumed to be symmetric.
+inline void d_vine_sweep(arma::mat& correlations,
+                         arma::mat& partials,
+                         bool fill_correlations) {
+
+  int d = correlations.n_rows;
+
+  // column a holds the coefficients for the window starting at node a. Both
+  // sets of coefficients are indexed by t - (a + 1) on the band below.
+  arma::mat forward = arma::zeros(d, d);
+  arma::mat backward = arma::zeros(d, d);
+  arma::mat next_forward = arma::zeros(d, d);
+  arma::mat next_backward = arma::zeros(d, d);
+  arma::vec forward_variance = arma::ones(d);
+  arma::vec backward_variance = arma::ones(d);
+  arma::vec next_forward_variance = arma::ones(d);
+  arma::vec next_backward_variance = arma::ones(d);
+
+  for (int k = 1; k < d; ++k) {
+    for (int a = 0; a < (d - k); ++a) {
+      int b = a + k;
+      // regression of X_b and X_a on X_{a+1}..X_{b-1} from the band below
+      const double* f = forward.colptr(a + 1);
+      const double* g = backward.colptr(a);
+      const double* r_a = correlations.colptr(a);
+      double vf = forward_variance[a + 1];
+      double vb = backward_variance[a];
+      double scale = std::sqrt(vf * vb);
+
+      // the part of r_ab explained by the intermediate nodes
+      double explained = 0;
+      for (int t = 0; t < (k - 1); ++t) {
+        explained += f[t] * r_a[a + 1 + t];
+      }
+
+      double rho = 0;
+      if (fill_correlations) {
+        rho = partials(a, b);
+        double r = explained + rho * scale;
+        correlations(a, b) = r;
+        correlations(b, a) = r;
+      } else {
+        if (scale > 0) {
+          rho = (correlations(a, b) - explained) / scale;
+        }
+        partials(a, b) = rho;
+        partials(b, a) = rho;
+      }
+
+      // update both regressions to include the new end point
+      double beta = 0;
+      double gamma = 0;
+      if (vb > 0) {
+        beta = rho * std::sqrt(vf / vb);
+      }
+      if (vf > 0) {
+        gamma = rho * std::sqrt(vb / vf);
+      }
+      double* nf = next_forward.colptr(a);
+      double* ng = next_backward.colptr(a);
+      nf[0] = beta;
+      for (int t = 0; t < (k - 1); ++t) {
+        nf[t + 1] = f[t] - beta * g[t];
+        ng[t] = g[t] - gamma * f[t];
+      }
+      ng[k - 1] = gamma;
+      next_forward_variance[a] = vf * (1 - rho * rho);
+      next_backward_variance[a] = vb * (1 - rho * rho);
+    }
+    forward.swap(next_forward);
+    backward.swap(next_backward);
+    forward_variance.swap(next_forward_variance);
+    backward_variance.swap(next_backward_variance);
+  }
+}
+
+// D-vine partial correlations to correlations.
+inline arma::mat partials_to_correlations(const arma::mat& partial_correlations) {
+  int nrow = partial_correlations.n_rows;
+  arma::mat partials = partial_correlations;
+  arma::mat correlations = arma::ones(nrow, nrow);
+  vine::d_vine_sweep(correlations, partials, true);
+  return correlations;
+}
+
+// Correlations to D-vine partial correlations.
+inline arma::mat correlations_to_partials(const arma::mat& correlations) {
+  int nrow = correlations.n_rows;
+  arma::mat corrs = correlations;
+  arma::mat partials = arma::ones(nrow, nrow);
+  vine::d_vine_sweep(corrs, partials, false);
+  return partials;
+}
+
+// Exponent on (1 - r^2) for a partial correlation on band k (k = j - i) in
+// the Jacobian of the partial correlation to bounded network transform,
+// including the outer square root. These match jacobian() in the R code, up
+// to its constant factor of 2: the first band is raised to (d - 2)^2, bands
+// 2, ..., d - 2 to d - 1 - k, and the last band does not enter.
+inline double log_jacobian_exponent(int d, int k) {
+  if (k == 1) {
+    return 0.5 * (d - 2) * (d - 2);
+  }
+  if (k < (d - 1)) {
+    return 0.5 * (d - 1 - k);
+  }
+  return 0;
+}
+
+// log of the Jacobian, accumulated as a sum of log1p(-r^2) terms rather than
+// as a product, which underflows for larger networks. Only the upper triangle
+// is read.
+inline double log_jacobian(const arma::mat& partial_correlations) {
+  int d = partial_correlations.n_rows;
+  double result = 0;
+  for (int k = 1; k < (d - 1); ++k) {
+    double exponent = vine::log_jacobian_exponent(d, k);
+    double band_sum = 0;
+    for (int i = 0; i < (d - k); ++i) {
+      double r = partial_correlations(i, (i + k));
+      band_sum += std::log1p(-r * r);
+    }
+    result += exponent * band_sum;
+  }
+  return result;
+}
+
+// Change in log_jacobian() when the single partial correlation (i, j) moves
+// from old_partial to new_partial, all other entries held fixed.
+inline double log_jacobian_delta(int d,
+                                 int i,
+                                 int j,
+                                 double old_partial,
+                                 double new_partial) {
+  int k = (i < j) ? (j - i) : (i - j);
+  double exponent = vine::log_jacobian_exponent(d, k);
+  if (exponent == 0) {
+    return 0;
+  }
+  return exponent * (std::log1p(-new_partial * new_partial) -
+                     std::log1p(-old_partial * old_partial));
+}
+
+} // namespace vine
+
+#endif
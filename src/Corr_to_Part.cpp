@@ -1,4 +1,5 @@
 #include <RcppArmadillo.h>
+#include <gergm/vine_transform.h>
 //[[Rcpp::depends(RcppArmadillo)]]
 using namespace Rcpp;
 
@@ -7,30 +8,35 @@ arma::mat Corr_to_Part (int d,
                         arma::mat correlations,
                         arma::mat partials) {
 
-  for (int k = 2; k < (d + 1); ++k) {
-    for (int i = 1; i < (d-k + 1); ++i) {
-
-      arma::mat R2 = correlations.submat((i ),  (i ), (i + k - 2), (i + k - 2));
-      // R2 <- correlations[(i + 1):(i + k - 1), (i + 1):(i + k - 1)]
-      arma::mat r1 = correlations.submat(i-1,  (i), i-1, (i + k -2));
-      // r1 <- correlations[i, (i + 1):(i + k - 1)]
-      arma::mat r3 = correlations.submat((i + k-1),  (i), (i + k -1), (i + k -2));
-      // r3 <- correlations[i + k, (i + 1):(i + k - 1)]
-
-      arma::mat solved = arma::inv_sympd(R2);
-      arma::mat temp = r1 * solved * r1.t();
-      arma::mat temp5 = solved * r1.t();
-      arma::mat temp2 = r3 * solved * r3.t();
-
-      double D = (1 - temp(0,0)) * (1 - temp2(0,0));
-      D = std::sqrt(D);
-
-      arma::mat temp3 = r1 * solved * r3.t();
-      double temp4 = (correlations(i -1, (i + k -1)) -  temp3(0,0)) / D;
-      partials(i -1, (i + k - 1)) = temp4;
-      partials((i + k - 1), i -1) = temp4;
+  // the super- and sub-diagonals (and the diagonal) are passed in already
+  // filled, so only copy over the higher order partial correlations.
+  arma::mat all_partials = vine::correlations_to_partials(correlations);
+  for (int k = 2; k < d; ++k) {
+    for (int i = 0; i < (d - k); ++i) {
+      partials(i, (i + k)) = all_partials(i, (i + k));
+      partials((i + k), i) = all_partials((i + k), i);
     }
   }
 
   return partials;
 }
+
+// [[Rcpp::export]]
+arma::mat Part_to_Corr (arma::mat partials) {
+  return vine::partials_to_correlations(partials);
+}
+
+// [[Rcpp::export]]
+double Log_Jacobian (arma::mat partials) {
+  return vine::log_jacobian(partials);
+}
+
+// i and j are 0 based.
+// [[Rcpp::export]]
+double Log_Jacobian_Delta (int d,
+                           int i,
+                           int j,
+                           double old_partial,
+                           double new_partial) {
+  return vine::log_jacobian_delta(d, i, j, old_partial, new_partial);
+}
@@ -1,2245 +1,769 @@
 // [[Rcpp::depends(RcppArmadillo)]]
-// [[Rcpp::depends(BH)]]
 // [[Rcpp::depends(RcppParallel)]]
 
-#include <RcppParallel.h>
-#include <RcppArmadillo.h>
-#include <boost/random.hpp>
-#include <boost/random/uniform_real_distribution.hpp>
-
-#include <boost/config/no_tr1/cmath.hpp>
-#include <istream>
-#include <iosfwd>
-#include <boost/assert.hpp>
-#include <boost/limits.hpp>
-#include <boost/static_assert.hpp>
-#include <boost/random/detail/config.hpp>
-#include <boost/random/detail/operators.hpp>
-#include <boost/random/uniform_01.hpp>
+#include "gergm_r.h"
+#include <unordered_set>
+#include <algorithm>
+#include <random>
 
+// The model, statistics and Metropolis Hastings sampler live in the core
+// library (inst/include/gergm). This file has the R facing wrappers, and the
+// samplers that are only used from R.
 
 using namespace Rcpp;
 using namespace arma;
 
 namespace gergm {
 
-namespace random {
-// Distributed under the Boost Software License, Version 1.0.
-//    (See http://www.boost.org/LICENSE_1_0.txt)
-// Coppied from the Boost libraries because they use an assert statement
-// which will not pass r cmd check.
-// http://www.boost.org/doc/libs/1_53_0/boost/random/normal_distribution.hpp
-// deterministic Box-Muller method, uses trigonometric functions
-
-/**
-* Instantiations of class template normal_distribution model a
-* \random_distribution. Such a distribution produces random numbers
-* @c x distributed with probability density function
-* \f$\displaystyle p(x) =
-*   \frac{1}{\sqrt{2\pi\sigma}} e^{-\frac{(x-\mu)^2}{2\sigma^2}}
-* \f$,
-* where mean and sigma are the parameters of the distribution.
-*/
-template<class RealType = double>
-class normal_distribution
-{
-public:
-  typedef RealType input_type;
-  typedef RealType result_type;
-
-  class param_type {
-  public:
-    typedef normal_distribution distribution_type;
-
-    /**
-    * Constructs a @c param_type with a given mean and
-    * standard deviation.
-    *
-    * Requires: sigma >= 0
-    */
-    explicit param_type(RealType mean_arg = RealType(0.0),
-                        RealType sigma_arg = RealType(1.0))
-      : _mean(mean_arg),
-        _sigma(sigma_arg)
-    {}
-
-    /** Returns the mean of the distribution. */
-    RealType mean() const { return _mean; }
-
-    /** Returns the standand deviation of the distribution. */
-    RealType sigma() const { return _sigma; }
-
-    /** Writes a @c param_type to a @c std::ostream. */
-    BOOST_RANDOM_DETAIL_OSTREAM_OPERATOR(os, param_type, parm)
-    { os << parm._mean << " " << parm._sigma ; return os; }
-
-    /** Reads a @c param_type from a @c std::istream. */
-    BOOST_RANDOM_DETAIL_ISTREAM_OPERATOR(is, param_type, parm)
-    { is >> parm._mean >> std::ws >> parm._sigma; return is; }
-
-    /** Returns true if the two sets of parameters are the same. */
-    BOOST_RANDOM_DETAIL_EQUALITY_OPERATOR(param_type, lhs, rhs)
-    { return lhs._mean == rhs._mean && lhs._sigma == rhs._sigma; }
-
-    /** Returns true if the two sets of parameters are the different. */
-    BOOST_RANDOM_DETAIL_INEQUALITY_OPERATOR(param_type)
-
-  private:
-    RealType _mean;
-    RealType _sigma;
-  };
-
-  /**
-  * Constructs a @c normal_distribution object. @c mean and @c sigma are
-  * the parameters for the distribution.
-  *
-  * Requires: sigma >= 0
-  */
-  explicit normal_distribution(const RealType& mean_arg = RealType(0.0),
-                               const RealType& sigma_arg = RealType(1.0))
-    : _mean(mean_arg), _sigma(sigma_arg),
-      _r1(0), _r2(0), _cached_rho(0), _valid(false)
-  {}
-
-  /**
-  * Constructs a @c normal_distribution object from its parameters.
-  */
-  explicit normal_distribution(const param_type& parm)
-    : _mean(parm.mean()), _sigma(parm.sigma()),
-      _r1(0), _r2(0), _cached_rho(0), _valid(false)
-  {}
-
-  /**  Returns the mean of the distribution. */
-  RealType mean() const { return _mean; }
-  /** Returns the standard deviation of the distribution. */
-  RealType sigma() const { return _sigma; }
-
-  /** Returns the smallest value that the distribution can produce. */
-  RealType min BOOST_PREVENT_MACRO_SUBSTITUTION () const
-  { return -std::numeric_limits<RealType>::infinity(); }
-  /** Returns the largest value that the distribution can produce. */
-  RealType max BOOST_PREVENT_MACRO_SUBSTITUTION () const
-  { return std::numeric_limits<RealType>::infinity(); }
-
-  /** Returns the parameters of the distribution. */
-  param_type param() const { return param_type(_mean, _sigma); }
-  /** Sets the parameters of the distribution. */
-  void param(const param_type& parm)
-  {
-    _mean = parm.mean();
-    _sigma = parm.sigma();
-    _valid = false;
-  }
+using std::pow;
+using std::exp;
+using std::sqrt;
 
-  /**
-  * Effects: Subsequent uses of the distribution do not depend
-  * on values produced by any engine prior to invoking reset.
-  */
-  void reset() { _valid = false; }
-
-  /**  Returns a normal variate. */
-  template<class Engine>
-  result_type operator()(Engine& eng)
-  {
-    using std::sqrt;
-    using std::log;
-    using std::sin;
-    using std::cos;
-
-    if(!_valid) {
-      _r1 = boost::uniform_01<RealType>()(eng);
-      _r2 = boost::uniform_01<RealType>()(eng);
-      _cached_rho = sqrt(-result_type(2) * log(result_type(1)-_r2));
-      _valid = true;
-    } else {
-      _valid = false;
-    }
-    // Can we have a boost::mathconst please?
-    const result_type pi = result_type(3.14159265358979323846);
+  arma::vec rdirichlet(arma::vec alpha_m) {
+    // this example is drawn from:
+    // https://en.wikipedia.org/wiki/Dirichlet_distribution#Random_number_generation
 
-    return _cached_rho * (_valid ?
-                            cos(result_type(2)*pi*_r1) :
-                            sin(result_type(2)*pi*_r1))
-      * _sigma + _mean;
-  }
+    int distribution_size = alpha_m.n_elem;
+    arma::vec distribution = arma::zeros(distribution_size);
 
-  /** Returns a normal variate with parameters specified by @c param. */
-  template<class URNG>
-  result_type operator()(URNG& urng, const param_type& parm)
-  {
-    return normal_distribution(parm)(urng);
-  }
+    // loop through the distribution and draw Gamma variables
+    for (int i = 0; i < distribution_size; ++i) {
+      double cur = R::rgamma(alpha_m[i],1.0);
+      distribution[i] = cur;
+    }
 
-  /** Writes a @c normal_distribution to a @c std::ostream. */
-  BOOST_RANDOM_DETAIL_OSTREAM_OPERATOR(os, normal_distribution, nd)
-  {
-    os << nd._mean << " " << nd._sigma << " "
-       << nd._valid << " " << nd._cached_rho << " " << nd._r1;
-    return os;
-  }
+    double gamma_sum = arma::sum(distribution);
 
-  /** Reads a @c normal_distribution from a @c std::istream. */
-  BOOST_RANDOM_DETAIL_ISTREAM_OPERATOR(is, normal_distribution, nd)
-  {
-    is >> std::ws >> nd._mean >> std::ws >> nd._sigma
-       >> std::ws >> nd._valid >> std::ws >> nd._cached_rho
-       >> std::ws >> nd._r1;
-       return is;
-  }
+    for (int i = 0; i < distribution_size; ++i) {
+      double temp = distribution[i];
+      distribution[i] = temp/gamma_sum;
+    }
 
-  /**
-  * Returns true if the two instances of @c normal_distribution will
-  * return identical sequences of values given equal generators.
-  */
-  BOOST_RANDOM_DETAIL_EQUALITY_OPERATOR(normal_distribution, lhs, rhs)
-  {
-    return lhs._mean == rhs._mean && lhs._sigma == rhs._sigma
-    && lhs._valid == rhs._valid
-    && (!lhs._valid || (lhs._r1 == rhs._r1 && lhs._r2 == rhs._r2));
+    return distribution;
   }
 
-  /**
-  * Returns true if the two instances of @c normal_distribution will
-  * return different sequences of values given equal generators.
-  */
-  BOOST_RANDOM_DETAIL_INEQUALITY_OPERATOR(normal_distribution)
+  arma::vec uniform_dirichlet_draw(arma::vec current_edge_values,
+                                   double variance) {
+    int len = current_edge_values.n_elem;
+    arma::vec alpha_m = arma::ones(len);
+    // get a uniform dirichlet draw
+    arma::vec uniform_dir = gergm::rdirichlet(alpha_m);
 
-private:
-  RealType _mean, _sigma;
-  RealType _r1, _r2, _cached_rho;
-  bool _valid;
+    // get a random uniform draw
+    double draw = R::runif(0,1);
 
-};
+    arma::vec proposal = arma::zeros(len);
+    if (draw < variance) {
+      // if it is less than the variance, then our proposal is just the uniform
+      // dirichlet (unmixed).
+      proposal = uniform_dir;
+    } else {
+      // we mix the old position with the new one
+      proposal = variance * uniform_dir + (1 - variance) * current_edge_values;
+    }
 
-} // namespace random
+    return(proposal);
+  }
 
-using random::normal_distribution;
-using std::pow;
-using std::exp;
-using std::sqrt;
+  bool point_in_simplex(arma::vec current_edge_values,
+                        arma::vec new_edge_values,
+                        double variance) {
 
-// add in the functions I wrote for correlation networks
-arma::mat partials_to_correlations(arma::mat partial_correlations){
-  int nrow = partial_correlations.n_rows;
-  arma::mat correlations = arma::ones(nrow,nrow);
-  correlations.diag(1) = partial_correlations.diag(1);
-  correlations.diag(-1) = partial_correlations.diag(-1);
-
-  for (int k = 2; k < (nrow); ++k) {
-    for (int i = 1; i < (nrow - k + 1); ++i) {
-      arma::mat R2 = correlations.submat(i,i,(i + k -2),(i + k -2));
-      arma::mat R2_ones = arma::ones(R2.n_cols,R2.n_cols);
-      arma::rowvec r1 = correlations(i-1,arma::span(i,(i + k -2)));
-      arma::rowvec r3 =  correlations((i + k -1),arma::span(i,(i + k- 2)));
-      arma::mat R2_solved = arma::inv(R2);
-
-      arma::mat temp1 = 1 - r1 * R2_solved * r1.t();
-      arma::mat temp2 =  1 - r3 * R2_solved * r3.t();
-      arma::mat D =  sqrt(temp1 * temp2);
-      arma::mat temp3 = r1 * R2_solved * r3.t() + partial_correlations(i -1, i + k-1)*D;
-      correlations((i-1), (i + k-1)) = temp3(0,0);
-      correlations((i + k-1), (i-1)) = correlations(i-1, i + k-1);
+    int len = current_edge_values.n_elem;
+    //loop over and check to see if there are any
+    bool in_simplex = true;
+    for (int i = 0; i < len; ++i) {
+      double cur = (new_edge_values[i] - (1 - variance) * current_edge_values[i])/variance;
+      if (cur < 0) {
+        in_simplex = false;
+        break;
+      }
     }
+    return(in_simplex);
   }
-  return correlations;
-}
 
 
-arma::mat bounded_to_correlations(arma::mat bounded_network){
-  //transform back to the partial space
-  arma::mat partials = 2 * bounded_network -1;
-  int temp = partials.n_rows;
-  partials.diag() = arma::ones(temp);
-  //transform to correlation space
-  arma::mat correlations =  gergm::partials_to_correlations(partials);
-  return correlations;
-}
 
+} //end of gergm namespace
 
-double jacobian(arma::mat partial_correlations){
-  int nrow = partial_correlations.n_rows;
-  arma::vec corrs_1 = partial_correlations.diag(1);
-  arma::vec temp = pow(corrs_1,2);
-  arma::vec temp2 = pow((1 - temp),(nrow -2));
-  double prod_1 =  arma::prod(temp2);
-  double prod_2 = 1;
+using std::log;
 
-  for (int k = 2; k < (nrow -1); ++k) {
-    for (int i = 0; i < (nrow - k); ++i) {
-      double temp3 = pow(partial_correlations(i,(i + k)),2);
-      prod_2 = prod_2 * pow((1 - temp3),(nrow - 1 - k));
-    }
-  }
+namespace gergm {
 
-  double temp4 = pow(prod_1,(nrow - 2));
-  double result = pow(temp4*prod_2,0.5);
-  return result;
+// The Metropolis Hastings sampler for a compiled model, called by both
+// Extended_Metropolis_Hastings_Sampler and GERGM_Model_MH_Sampler, returning
+// the list described at metropolis_hastings_output_to_r(). The chain runs on
+// a background thread so that the session stays responsive: an interrupt
+// (Ctrl-C) cancels it.
+List extended_metropolis_hastings(const GergmModel& model,
+                                  int number_of_iterations,
+                                  double shape_parameter,
+                                  arma::mat initial_network,
+                                  int take_sample_every,
+                                  arma::vec thetas,
+                                  int seed,
+                                  int number_of_samples_to_store,
+                                  bool parallel,
+                                  int network_storage = STORE_DOUBLE,
+                                  const std::string& sample_file = "",
+                                  const SampleFileInfo& sample_file_info =
+                                    SampleFileInfo()) {
+
+  AsyncMetropolisHastings run(model,
+                              number_of_iterations,
+                              shape_parameter,
+                              initial_network,
+                              take_sample_every,
+                              thetas,
+                              seed,
+                              number_of_samples_to_store,
+                              parallel,
+                              network_storage);
+  wait_checking_interrupts(run);
+  return metropolis_hastings_output_to_r(model, run.result(), sample_file,
+                                         sample_file_info);
 }
 
-// Function to calculate the number of out 2-stars
-double Out2Star(arma::mat net,
-                arma::mat triples,
-                double alpha,
-                int together) {
+} // end of gergm namespace
 
-  int number_of_triples = triples.n_rows;
-  double st1 = 0;
-  double st2 = 0;
-  double st3 = 0;
+// [[Rcpp::export]]
+List Extended_Metropolis_Hastings_Sampler (int number_of_iterations,
+                                  double shape_parameter,
+                                  int number_of_nodes,
+                                  arma::vec statistics_to_use,
+                                  arma::mat initial_network,
+                                  int take_sample_every,
+                                  arma::vec thetas,
+                                  arma::Mat<double> triples,
+                                  arma::Mat<double> pairs,
+                                  arma::vec alphas,
+                                  int together,
+                                  int seed,
+                                  int number_of_samples_to_store,
+                                  int using_correlation_network,
+                                  int undirect_network,
+                                  bool parallel,
+                                  arma::umat use_selected_rows,
+                                  arma::umat save_statistics_selected_rows_matrix,
+                                  arma::vec rows_to_use,
+                                  arma::vec base_statistics_to_save,
+                                  arma::vec base_statistic_alphas,
+                                  int num_non_base_statistics,
+                                  arma::vec non_base_statistic_indicator,
+                                  double p_ratio_multaplicative_factor,
+                                  double stochastic_MH_proportion,
+                                  bool use_triad_sampling,
+                                  bool use_weighted_triad_sampling,
+                                  bool include_diagonal) {
 
-  double to_return = 0;
-  if (together == 1) {
-    for (int i = 0; i < number_of_triples; ++i) {
-      st1 += net(triples(i, 0), triples(i, 1)) * net(triples(i, 0),
-                 triples(i, 2));
-      st2 += net(triples(i, 1), triples(i, 0)) * net(triples(i, 1),
-                 triples(i, 2));
-      st3 += net(triples(i, 2), triples(i, 0)) * net(triples(i, 2),
-                 triples(i, 1));
-    }
-    to_return = pow((st1 + st2 + st3), alpha);
-  } else {
-    for (int i = 0; i < number_of_triples; ++i) {
-      st1 += pow(net(triples(i, 0), triples(i, 1)), alpha) *
-        pow(net(triples(i, 0), triples(i, 2)), alpha);
-      st2 += pow(net(triples(i, 1), triples(i, 0)), alpha) *
-        pow(net(triples(i, 1), triples(i, 2)), alpha);
-      st3 += pow(net(triples(i, 2), triples(i, 0)), alpha) *
-        pow(net(triples(i, 2),triples(i, 1)), alpha);
-    }
-    to_return = st1 + st2 + st3;
-  }
-  return to_return;
-};
+  gergm::GergmModel model(number_of_nodes,
+                          statistics_to_use,
+                          triples,
+                          pairs,
+                          alphas,
+                          together,
+                          using_correlation_network,
+                          undirect_network,
+                          use_selected_rows,
+                          save_statistics_selected_rows_matrix,
+                          rows_to_use,
+                          base_statistics_to_save,
+                          base_statistic_alphas,
+                          num_non_base_statistics,
+                          non_base_statistic_indicator,
+                          p_ratio_multaplicative_factor,
+                          stochastic_MH_proportion,
+                          use_triad_sampling,
+                          use_weighted_triad_sampling,
+                          include_diagonal);
+
+  return gergm::extended_metropolis_hastings(model,
+                                             number_of_iterations,
+                                             shape_parameter,
+                                             initial_network,
+                                             take_sample_every,
+                                             thetas,
+                                             seed,
+                                             number_of_samples_to_store,
+                                             parallel);
+}
 
-// Function to calculate the number of in 2-stars
-double In2Star(arma::mat net,
-               arma::mat triples,
-               double alpha,
-               int together) {
 
-  int number_of_triples = triples.n_rows;
-  double st1 = 0;
-  double st2 = 0;
-  double st3 = 0;
+// [[Rcpp::export]]
+SEXP Create_GERGM_Model (int number_of_nodes,
+                         arma::vec statistics_to_use,
+                         arma::Mat<double> triples,
+                         arma::Mat<double> pairs,
+                         arma::vec alphas,
+                         int together,
+                         int using_correlation_network,
+                         int undirect_network,
+                         arma::umat use_selected_rows,
+                         arma::umat save_statistics_selected_rows_matrix,
+                         arma::vec rows_to_use,
+                         arma::vec base_statistics_to_save,
+                         arma::vec base_statistic_alphas,
+                         int num_non_base_statistics,
+                         arma::vec non_base_statistic_indicator,
+                         double p_ratio_multaplicative_factor,
+                         double stochastic_MH_proportion,
+                         bool use_triad_sampling,
+                         bool use_weighted_triad_sampling,
+                         bool include_diagonal) {
+
+  gergm::GergmModel* model = new gergm::GergmModel(
+    number_of_nodes,
+    statistics_to_use,
+    triples,
+    pairs,
+    alphas,
+    together,
+    using_correlation_network,
+    undirect_network,
+    use_selected_rows,
+    save_statistics_selected_rows_matrix,
+    rows_to_use,
+    base_statistics_to_save,
+    base_statistic_alphas,
+    num_non_base_statistics,
+    non_base_statistic_indicator,
+    p_ratio_multaplicative_factor,
+    stochastic_MH_proportion,
+    use_triad_sampling,
+    use_weighted_triad_sampling,
+    include_diagonal);
+  return Rcpp::XPtr<gergm::GergmModel>(model, true);
+}
 
-  double to_return = 0;
-  if (together == 1) {
-    for (int i = 0; i < number_of_triples; ++i) {
-      st1 += net(triples(i, 2), triples(i, 0)) * net(triples(i, 1),
-                 triples(i, 0));
-      st2 += net(triples(i, 2), triples(i, 1)) * net(triples(i, 0),
-                 triples(i, 1));
-      st3 += net(triples(i, 0), triples(i, 2)) * net(triples(i, 1),
-                 triples(i, 2));
-    }
-    to_return = pow((st1 + st2 + st3), alpha);
-  } else {
-    for (int i = 0; i < number_of_triples; ++i) {
-      st1 += pow(net(triples(i, 2), triples(i, 0)), alpha) *
-        pow(net(triples(i, 1), triples(i, 0)), alpha);
-      st2 += pow(net(triples(i, 2), triples(i, 1)), alpha) *
-        pow(net(triples(i, 0), triples(i, 1)), alpha);
-      st3 += pow(net(triples(i, 0), triples(i, 2)), alpha) *
-        pow(net(triples(i, 1),triples(i, 2)), alpha);
-    }
-    to_return = st1 + st2 + st3;
-  }
-  return to_return;
-};
 
-// Function to calculate the number of transitive triads
-double TTriads(arma::mat net,
-               arma::mat triples,
-               double alpha,
-               int together) {
-
-  int number_of_triples = triples.n_rows;
-  double st1 = 0;
-  double st2 = 0;
-  double st3 = 0;
-  double st4 = 0;
-  double st5 = 0;
-  double st6 = 0;
-
-  double to_return = 0;
-  if (together == 1) {
-    for (int i = 0; i < number_of_triples; ++i) {
-      st1 += net(triples(i, 0), triples(i, 1)) * net(triples(i, 1),
-                 triples(i, 2)) * net(triples(i, 0), triples(i, 2));
-      st2 += net(triples(i, 0), triples(i, 1)) * net(triples(i, 2),
-                 triples(i, 1)) * net(triples(i, 2), triples(i, 0));
-      st3 += net(triples(i, 0), triples(i, 1)) * net(triples(i, 2),
-                 triples(i, 1)) * net(triples(i, 0), triples(i, 2));
-      st4 += net(triples(i, 1), triples(i, 0)) * net(triples(i, 1),
-                 triples(i, 2)) * net(triples(i, 2), triples(i, 0));
-      st5 += net(triples(i, 1), triples(i, 0)) * net(triples(i, 1),
-                 triples(i, 2)) * net(triples(i, 0), triples(i, 2));
-      st6 += net(triples(i, 1), triples(i, 0)) * net(triples(i, 2),
-                 triples(i, 1)) * net(triples(i, 2), triples(i, 0));
-    }
-    to_return = pow((st1 + st2 + st3 + st4 + st5 + st6), alpha);
-  } else {
-    for (int i = 0; i < number_of_triples; ++i) {
-      st1 += pow(net(triples(i, 0), triples(i, 1)), alpha) *
-        pow(net(triples(i, 1), triples(i, 2)), alpha) *
-        pow(net(triples(i, 0), triples(i, 2)), alpha);
-      st2 += pow(net(triples(i, 0), triples(i, 1)), alpha) *
-        pow(net(triples(i, 2), triples(i, 1)), alpha) *
-        pow(net(triples(i, 2), triples(i, 0)), alpha);
-      st3 += pow(net(triples(i, 0), triples(i, 1)), alpha) *
-        pow(net(triples(i, 2),triples(i, 1)), alpha) *
-        pow(net(triples(i, 0), triples(i, 2)), alpha);
-      st4 += pow(net(triples(i, 1), triples(i, 0)), alpha) *
-        pow(net(triples(i, 1), triples(i, 2)), alpha) *
-        pow(net(triples(i, 2), triples(i, 0)), alpha);
-      st5 += pow(net(triples(i, 1), triples(i, 0)), alpha) *
-        pow(net(triples(i, 1), triples(i, 2)), alpha) *
-        pow(net(triples(i, 0), triples(i, 2)), alpha);
-      st6 += pow(net(triples(i, 1), triples(i, 0)), alpha) *
-        pow(net(triples(i, 2), triples(i, 1)), alpha) *
-        pow(net(triples(i, 2), triples(i, 0)), alpha);
-    }
-    to_return = st1 + st2 + st3 + st4 + st5 + st6;
+// An external pointer does not survive saving and reloading the GERGM object,
+// in which case the model needs to be rebuilt.
+// [[Rcpp::export]]
+bool GERGM_Model_Is_Valid (SEXP model) {
+  if (TYPEOF(model) != EXTPTRSXP) {
+    return false;
   }
-  return to_return;
-};
+  return R_ExternalPtrAddr(model) != NULL;
+}
 
-// Function to calculate the number of closed triads
-double CTriads(arma::mat net,
-               arma::mat triples,
-               double alpha,
-               int together){
 
-  int number_of_triples = triples.n_rows;
-  double st1 = 0;
-  double st2 = 0;
+// network_storage picks how the sampled networks are kept, see
+// gergm/sample_storage.h. If sample_file is not empty they are written to it
+// instead of returned, with the statistic names, thetas and the (0 based)
+// first sample after the burnin.
+// [[Rcpp::export]]
+List GERGM_Model_MH_Sampler (SEXP model,
+                             int number_of_iterations,
+                             double shape_parameter,
+                             arma::mat initial_network,
+                             int take_sample_every,
+                             arma::vec thetas,
+                             int seed,
+                             int number_of_samples_to_store,
+                             bool parallel,
+                             int network_storage = 0,
+                             std::string sample_file = "",
+                             Rcpp::CharacterVector statistic_names =
+                               Rcpp::CharacterVector::create(),
+                             int first_sample = 0) {
+
+  gergm::check_network_storage(network_storage);
+  gergm::SampleFileInfo sample_file_info;
+  sample_file_info.first_sample = first_sample;
+  sample_file_info.statistic_names =
+    Rcpp::as<std::vector<std::string> >(statistic_names);
+  sample_file_info.thetas = Rcpp::as<std::vector<double> >(Rcpp::wrap(thetas));
+  Rcpp::XPtr<gergm::GergmModel> compiled_model(model);
+  return gergm::extended_metropolis_hastings(*compiled_model,
+                                             number_of_iterations,
+                                             shape_parameter,
+                                             initial_network,
+                                             take_sample_every,
+                                             thetas,
+                                             seed,
+                                             number_of_samples_to_store,
+                                             parallel,
+                                             network_storage,
+                                             sample_file,
+                                             sample_file_info);
+}
 
-  double to_return = 0;
-  if (together == 1) {
-    for (int i = 0; i < number_of_triples; ++i) {
-      st1 += net(triples(i, 0), triples(i, 1)) * net(triples(i, 1),
-                 triples(i, 2)) * net(triples(i, 2), triples(i, 0));
-      st2 += net(triples(i, 1), triples(i, 0)) * net(triples(i, 2),
-                 triples(i,1)) * net(triples(i, 0), triples(i, 2));
-    }
-    to_return = pow((st1 + st2), alpha);
-  } else {
-    for (int i = 0; i < number_of_triples; ++i) {
-      st1 += pow(net(triples(i, 0), triples(i, 1)), alpha) *
-        pow(net(triples(i, 1), triples(i, 2)), alpha) *
-        pow(net(triples(i, 2), triples(i, 0)), alpha);
-      st2 += pow(net(triples(i, 1), triples(i, 0)), alpha) *
-        pow(net(triples(i, 2), triples(i,1)), alpha) *
-        pow(net(triples(i, 0), triples(i, 2)), alpha);
-    }
-    to_return = st1 + st2;
-  }
-  return to_return;
-};
 
-// Function to calculate the number of reciprocated edges
-double Recip(arma::mat net,
-             arma::mat pairs,
-             double alpha,
-             int together) {
+namespace gergm {
 
-  int number_of_pairs = pairs.n_rows;
-  double st1 = 0;
+// Runs one chain of warm started simulations per task. Chain c simulates at
+// the thetas in rows chain_starts[c] to chain_starts[c + 1] - 1 in order, each
+// row starting from the network the previous row finished at, so only the
+// first row of a chain needs a full burnin. Every row has its own seeds, so
+// the results do not depend on how the chains are scheduled over threads.
+struct Parallel_Multi_Theta_Chains : public RcppParallel::Worker {
+
+  const GergmModel& model;
+  const arma::mat& thetas;
+  const arma::uvec& chain_starts;
+  const arma::mat& initial_network;
+  int burnin_iterations;
+  int warm_start_burnin_iterations;
+  int number_of_iterations;
+  double shape_parameter;
+  int take_sample_every;
+  int number_of_samples_to_store;
+  int seed;
+  RcppParallel::RMatrix<double> statistics;
+  RcppParallel::RVector<double> acceptance_rates;
+  RcppParallel::RVector<double> final_networks;
+
+  Parallel_Multi_Theta_Chains(const GergmModel& model,
+                              const arma::mat& thetas,
+                              const arma::uvec& chain_starts,
+                              const arma::mat& initial_network,
+                              int burnin_iterations,
+                              int warm_start_burnin_iterations,
+                              int number_of_iterations,
+                              double shape_parameter,
+                              int take_sample_every,
+                              int number_of_samples_to_store,
+                              int seed,
+                              Rcpp::NumericMatrix statistics,
+                              Rcpp::NumericVector acceptance_rates,
+                              Rcpp::NumericVector final_networks)
+    : model(model),
+      thetas(thetas),
+      chain_starts(chain_starts),
+      initial_network(initial_network),
+      burnin_iterations(burnin_iterations),
+      warm_start_burnin_iterations(warm_start_burnin_iterations),
+      number_of_iterations(number_of_iterations),
+      shape_parameter(shape_parameter),
+      take_sample_every(take_sample_every),
+      number_of_samples_to_store(number_of_samples_to_store),
+      seed(seed),
+      statistics(statistics),
+      acceptance_rates(acceptance_rates),
+      final_networks(final_networks) {}
 
-  double to_return = 0;
-  if(together == 1) {
-    for (int i = 0; i < number_of_pairs; ++i) {
-      st1 += net(pairs(i, 0), pairs(i, 1)) * net(pairs(i, 1), pairs(i, 0));
-    }
-    to_return = pow(st1, alpha);
-  } else {
-    for (int i = 0; i < number_of_pairs; ++i) {
-      st1 += pow(net(pairs(i, 0), pairs(i, 1)), alpha) *
-        pow(net(pairs(i, 1), pairs(i, 0)), alpha);
+  void operator()(std::size_t begin, std::size_t end) {
+    int network_size = initial_network.n_elem;
+    // every run on this thread works in the same buffers
+    gergm::SamplerWorkspace workspace;
+    for (std::size_t c = begin; c < end; c++) {
+      arma::mat current_network = initial_network;
+      for (arma::uword row = chain_starts[c]; row < chain_starts[c + 1];
+           ++row) {
+        arma::vec theta = thetas.row(row).t();
+        int burnin = warm_start_burnin_iterations;
+        if (row == chain_starts[c]) {
+          burnin = burnin_iterations;
+        }
+        gergm::MetropolisHastingsOutput output;
+        if (burnin > 0) {
+          // nothing is stored during the burnin
+          gergm::run_metropolis_hastings(model, burnin, shape_parameter,
+                                         current_network, burnin + 1, theta,
+                                         seed + 2 * row, 0, false, false,
+                                         gergm::STORE_DOUBLE, NULL, workspace,
+                                         output);
+          current_network = output.final_network;
+        }
+        gergm::run_metropolis_hastings(model, number_of_iterations,
+                                       shape_parameter, current_network,
+                                       take_sample_every, theta,
+                                       seed + 2 * row + 1,
+                                       number_of_samples_to_store, false,
+                                       false, gergm::STORE_DOUBLE, NULL,
+                                       workspace, output);
+        current_network = output.final_network;
+
+        int statistics_to_save = output.Save_H_Statistics.n_cols;
+        for (int s = 0; s < number_of_samples_to_store; ++s) {
+          for (int m = 0; m < statistics_to_save; ++m) {
+            statistics(row * number_of_samples_to_store + s, m) =
+              output.Save_H_Statistics(s, m);
+          }
+        }
+        acceptance_rates[row] = arma::mean(output.Accept_or_Reject);
+        for (int k = 0; k < network_size; ++k) {
+          final_networks[row * network_size + k] = current_network[k];
+        }
+      }
     }
-    to_return = st1;
   }
-
-
-  return to_return;
 };
 
-// Function to calculate the density of the network
-double EdgeDensity(arma::mat net,
-                   arma::mat pairs,
-                   double alpha,
-                   int together) {
-
-  int number_of_pairs = pairs.n_rows;
-  double st1 = 0;
-  double st2 = 0;
-  double to_return = 0;
-
-  for (int i = 0; i < number_of_pairs; ++i) {
-    st1 += net(pairs(i, 0), pairs(i, 1));
-    st1 += net(pairs(i, 1), pairs(i, 0));
-    st2 += pow(net(pairs(i, 0), pairs(i, 1)), alpha);
-    st2 += pow(net(pairs(i, 1), pairs(i, 0)), alpha);
+} // end of gergm namespace
+
+// Simulate at every theta vector (row) in thetas for hysteresis plots and
+// grid searches. chain_lengths splits the rows into consecutive chains which
+// are warm started from one theta to the next (see
+// Parallel_Multi_Theta_Chains), different chains run in parallel. After the
+// burnin, each row runs number_of_iterations MH iterations and stores every
+// take_sample_every th network's statistics. Returns a list with the stacked
+// statistics (number_of_iterations / take_sample_every rows per theta, in the
+// order of the rows of thetas), the acceptance rate for each theta and the
+// final network of each theta as an array.
+// [[Rcpp::export]]
+List GERGM_Model_Multi_Theta_MH_Sampler (SEXP model,
+                                         arma::mat thetas,
+                                         arma::vec chain_lengths,
+                                         arma::mat initial_network,
+                                         int burnin_iterations,
+                                         int warm_start_burnin_iterations,
+                                         int number_of_iterations,
+                                         double shape_parameter,
+                                         int take_sample_every,
+                                         int seed,
+                                         bool parallel) {
+
+  Rcpp::XPtr<gergm::GergmModel> compiled_model(model);
+  int number_of_thetas = thetas.n_rows;
+  int number_of_chains = chain_lengths.n_elem;
+  arma::uvec chain_starts = arma::zeros<arma::uvec>(number_of_chains + 1);
+  for (int c = 0; c < number_of_chains; ++c) {
+    chain_starts[c + 1] = chain_starts[c] + arma::uword(chain_lengths[c]);
   }
-
-  if (together == 1) {
-    to_return = pow(st1, alpha);
-  } else {
-    to_return = st2;
+  if (int(chain_starts[number_of_chains]) != number_of_thetas) {
+    Rcpp::stop("chain_lengths must sum to the number of rows in thetas.");
+  }
+  if (take_sample_every < 1) {
+    Rcpp::stop("take_sample_every must be at least 1.");
   }
-  return to_return;
-};
-
-
-
-
-// Function to calculate the number of transitive triads
-arma::vec indiviual_triad_values(arma::mat net,
-               arma::mat triples,
-               double alpha,
-               int together) {
-
-  int number_of_triples = triples.n_rows;
-  double st1 = 0;
-  double st2 = 0;
-  double st3 = 0;
-  double st4 = 0;
-  double st5 = 0;
-  double st6 = 0;
-
-  arma::vec to_return = arma::zeros(number_of_triples);
-  if (together == 1) {
-    for (int i = 0; i < number_of_triples; ++i) {
-      st1 = net(triples(i, 0), triples(i, 1)) * net(triples(i, 1),
-                 triples(i, 2)) * net(triples(i, 0), triples(i, 2));
-      st2 = net(triples(i, 0), triples(i, 1)) * net(triples(i, 2),
-                 triples(i, 1)) * net(triples(i, 2), triples(i, 0));
-      st3 = net(triples(i, 0), triples(i, 1)) * net(triples(i, 2),
-                 triples(i, 1)) * net(triples(i, 0), triples(i, 2));
-      st4 = net(triples(i, 1), triples(i, 0)) * net(triples(i, 1),
-                 triples(i, 2)) * net(triples(i, 2), triples(i, 0));
-      st5 = net(triples(i, 1), triples(i, 0)) * net(triples(i, 1),
-                 triples(i, 2)) * net(triples(i, 0), triples(i, 2));
-      st6 = net(triples(i, 1), triples(i, 0)) * net(triples(i, 2),
-                 triples(i, 1)) * net(triples(i, 2), triples(i, 0));
-      to_return[i] = pow((st1 + st2 + st3 + st4 + st5 + st6), alpha);
-    }
 
+  int number_of_samples_to_store = number_of_iterations / take_sample_every;
+  int statistics_to_save = compiled_model->combined_statistics_to_use.n_elem;
+  Rcpp::NumericMatrix statistics(number_of_thetas * number_of_samples_to_store,
+                                 statistics_to_save);
+  Rcpp::NumericVector acceptance_rates(number_of_thetas);
+  Rcpp::NumericVector final_networks(Rcpp::Dimension(initial_network.n_rows,
+                                                     initial_network.n_cols,
+                                                     number_of_thetas));
+
+  gergm::Parallel_Multi_Theta_Chains Parallel_Multi_Theta_Chains(
+    *compiled_model,
+    thetas,
+    chain_starts,
+    initial_network,
+    burnin_iterations,
+    warm_start_burnin_iterations,
+    number_of_iterations,
+    shape_parameter,
+    take_sample_every,
+    number_of_samples_to_store,
+    seed,
+    statistics,
+    acceptance_rates,
+    final_networks);
+  if (parallel) {
+    RcppParallel::parallelFor(0, number_of_chains,
+                              Parallel_Multi_Theta_Chains);
   } else {
-    for (int i = 0; i < number_of_triples; ++i) {
-      st1 = pow(net(triples(i, 0), triples(i, 1)), alpha) *
-        pow(net(triples(i, 1), triples(i, 2)), alpha) *
-        pow(net(triples(i, 0), triples(i, 2)), alpha);
-      st2 = pow(net(triples(i, 0), triples(i, 1)), alpha) *
-        pow(net(triples(i, 2), triples(i, 1)), alpha) *
-        pow(net(triples(i, 2), triples(i, 0)), alpha);
-      st3 = pow(net(triples(i, 0), triples(i, 1)), alpha) *
-        pow(net(triples(i, 2),triples(i, 1)), alpha) *
-        pow(net(triples(i, 0), triples(i, 2)), alpha);
-      st4 = pow(net(triples(i, 1), triples(i, 0)), alpha) *
-        pow(net(triples(i, 1), triples(i, 2)), alpha) *
-        pow(net(triples(i, 2), triples(i, 0)), alpha);
-      st5 = pow(net(triples(i, 1), triples(i, 0)), alpha) *
-        pow(net(triples(i, 1), triples(i, 2)), alpha) *
-        pow(net(triples(i, 0), triples(i, 2)), alpha);
-      st6 = pow(net(triples(i, 1), triples(i, 0)), alpha) *
-        pow(net(triples(i, 2), triples(i, 1)), alpha) *
-        pow(net(triples(i, 2), triples(i, 0)), alpha);
-      to_return[i] = st1 + st2 + st3 + st4 + st5 + st6;
-    }
+    Parallel_Multi_Theta_Chains(0, number_of_chains);
   }
-  return to_return;
-};
-
-// get triad weights for resampling triads for approximate MH
-arma::vec triad_weights (
-    arma::mat net,
-    arma::Mat<double> triples,
-    double alpha,
-    int together,
-    double smoothing_parameter) {
 
-  int number_of_triples = triples.n_rows;
+  List to_return(3);
+  to_return[0] = statistics;
+  to_return[1] = acceptance_rates;
+  to_return[2] = final_networks;
+  return to_return;
+}
 
-  arma::vec triad_values = gergm::indiviual_triad_values(net,
-                                                         triples,
-                                                         alpha,
-                                                         together);
+// [[Rcpp::export]]
+arma::vec GERGM_Model_h_statistics (SEXP model,
+                                    arma::mat current_edge_weights) {
 
-  double mean_val = arma::accu(triad_values)/double(number_of_triples);
+  Rcpp::XPtr<gergm::GergmModel> compiled_model(model);
+  return compiled_model->save_network_statistics(current_edge_weights);
+}
 
-  // loop over all values and calculate the absolute difference
-  for (int i = 0; i < number_of_triples; ++i) {
-    triad_values[i] = mean_val - triad_values[i];
+// The weighted MPLE objective of a compiled model at thetas (one per model
+// statistic) for network, see gergm::mple_objective(). With
+// distribution_estimator = TRUE, the objective of the distribution estimator
+// instead (see gergm::mple_distribution_objective()).
+// [[Rcpp::export]]
+double GERGM_Model_MPLE_Objective (SEXP model,
+                                   arma::vec thetas,
+                                   arma::mat network,
+                                   arma::vec integration_interval,
+                                   bool parallel,
+                                   bool distribution_estimator) {
+
+  Rcpp::XPtr<gergm::GergmModel> compiled_model(model);
+  if (distribution_estimator) {
+    return gergm::mple_distribution_objective(*compiled_model, thetas,
+                                              network, integration_interval,
+                                              parallel);
   }
-  // make differences absolute
-  triad_values = arma::abs(triad_values);
+  return gergm::mple_objective(*compiled_model, thetas, network,
+                               integration_interval, parallel);
+}
 
-  //get the maximum difference and multiply by smoothing_parameter > 1
-  double max_diff = arma::max(triad_values) * smoothing_parameter;
+// theta' h for network estimated from number_of_draws independent stochastic
+// MH subsamples of a compiled model (uniform or importance weighted, as the
+// model was built), scaled up to the whole network the way the sampler scales
+// them. The importance weights are calculated once, on network.
+// [[Rcpp::export]]
+arma::vec GERGM_Model_Stochastic_h_Values (SEXP model,
+                                           arma::mat network,
+                                           arma::vec thetas,
+                                           int number_of_draws,
+                                           int seed) {
 
-  // get the un-normalized weights
-  for (int i = 0; i < number_of_triples; ++i) {
-    triad_values[i] = max_diff - triad_values[i];
+  Rcpp::XPtr<gergm::GergmModel> compiled_model(model);
+  const gergm::GergmModel& m = *compiled_model;
+  std::mt19937 generator(seed);
+  arma::Mat<double> random_triad_samples;
+  arma::Mat<double> random_dyad_samples;
+  arma::vec triad_probabilities;
+  arma::vec alias_probability;
+  arma::uvec alias;
+  double scale = m.p_ratio_multaplicative_factor;
+  if (m.use_weighted_triad_sampling) {
+    scale = 1;
   }
-
-  // normalize
-  double sum = arma::accu(triad_values);
-  for (int i = 0; i < number_of_triples; ++i) {
-    triad_values[i] = triad_values[i]/sum;
+  bool diagonal_triples = gergm::triples_include_diagonal(m.number_of_nodes,
+                                                         m.triples);
+  arma::vec estimates(number_of_draws);
+  for (int i = 0; i < number_of_draws; ++i) {
+    if (m.use_weighted_triad_sampling) {
+      gergm::draw_weighted_random_triad_samples(network,
+                                                m.triples,
+                                                m.number_of_nodes,
+                                                m.stochastic_MH_proportion,
+                                                m.statistics_to_use,
+                                                thetas,
+                                                m.alphas,
+                                                m.together,
+                                                m.non_base_statistic_indicator,
+                                                i == 0,
+                                                triad_probabilities,
+                                                alias_probability,
+                                                alias,
+                                                generator,
+                                                random_triad_samples,
+                                                random_dyad_samples);
+    } else {
+      gergm::draw_random_triad_samples(m.number_of_nodes,
+                                       m.stochastic_MH_proportion,
+                                       diagonal_triples,
+                                       generator,
+                                       random_triad_samples,
+                                       random_dyad_samples);
+    }
+    estimates[i] = scale * gergm::CalculateNetworkStatistics(
+      network,
+      m.statistics_to_use,
+      thetas,
+      m.triples,
+      m.pairs,
+      m.alphas,
+      m.together,
+      false,
+      m.use_selected_rows,
+      m.rows_to_use,
+      m.non_base_statistic_indicator,
+      random_triad_samples,
+      random_dyad_samples,
+      true,
+      m.use_weighted_triad_sampling);
   }
+  return estimates;
+}
 
-  return triad_values;
+// How many of number_of_draws draws from the alias table for probabilities
+// land on each entry, see gergm::build_alias_table().
+// [[Rcpp::export]]
+arma::vec alias_table_counts (arma::vec probabilities,
+                              int number_of_draws,
+                              int seed) {
+
+  std::mt19937 generator(seed);
+  arma::vec alias_probability;
+  arma::uvec alias;
+  gergm::build_alias_table(probabilities, alias_probability, alias);
+  arma::vec counts = arma::zeros(probabilities.n_elem);
+  for (int i = 0; i < number_of_draws; ++i) {
+    counts[gergm::draw_from_alias_table(alias_probability, alias,
+                                        generator)] += 1;
+  }
+  return counts;
 }
 
 
-// Function that will calculate h statistics
-double calculate_individual_statistic(arma::mat current_network,
-                                  int base_statistic_index,
-                                  arma::Mat<double> triples,
-                                  arma::Mat<double> pairs,
-                                  double alpha,
-                                  int together,
-                                  arma::uvec use_selected_rows,
-                                  bool use_all_rows) {
-
-  double to_return = 0;
-
-  if (base_statistic_index == 0) {
-    if (!use_all_rows) {
-      arma::mat pass_in = triples.rows(use_selected_rows);
-      to_return = Out2Star(current_network,
-                           pass_in,
-                           alpha,
-                           together);
-    } else {
-      // the base case for normal statistics
-      to_return = Out2Star(current_network,
-                           triples,
-                           alpha,
-                           together);
-    }
-  } // end of Out 2 stars conditional
-  if (base_statistic_index == 1) {
-    if (!use_all_rows) {
-      arma::mat pass_in = triples.rows(use_selected_rows);
-      to_return = In2Star(current_network,
-                           pass_in,
-                           alpha,
-                           together);
-    } else {
-      // the base case for normal statistics
-      to_return = In2Star(current_network,
-                           triples,
-                           alpha,
-                           together);
-    }
-  }
-  if (base_statistic_index == 2) {
-    if (!use_all_rows) {
-      arma::mat pass_in = triples.rows(use_selected_rows);
-      to_return = CTriads(current_network,
-                          pass_in,
-                          alpha,
-                          together);
-    } else {
-      // the base case for normal statistics
-      to_return = CTriads(current_network,
-                          triples,
-                          alpha,
-                          together);
-    }
-  }
-  if (base_statistic_index == 3) {
-    if (!use_all_rows) {
-      arma::mat pass_in = pairs.rows(use_selected_rows);
-      to_return = Recip(current_network,
-                          pass_in,
-                          alpha,
-                          together);
-    } else {
-      // the base case for normal statistics
-      to_return = Recip(current_network,
-                          pairs,
-                          alpha,
-                          together);
+namespace gergm {
+
+// Modularity of a weighted network for the given group memberships, matching
+// igraph::modularity() on a weighted graph without loops. For undirected
+// networks each dyad enters as max(w_ij, w_ji), as in
+// igraph::graph.adjacency(mode = "undirected").
+double weighted_modularity(const arma::mat& net,
+                           const arma::vec& memberships,
+                           bool undirected) {
+  int n = net.n_rows;
+  arma::vec out_strength = arma::zeros(n);
+  arma::vec in_strength = arma::zeros(n);
+  double total = 0;
+  for (int j = 0; j < n; ++j) {
+    for (int i = 0; i < n; ++i) {
+      if (i != j) {
+        double w = net(i, j);
+        if (undirected) {
+          w = std::max(net(i, j), net(j, i));
+        }
+        out_strength[i] += w;
+        in_strength[j] += w;
+        total += w;
+      }
     }
   }
-  if (base_statistic_index == 4) {
-    if (!use_all_rows) {
-      arma::mat pass_in = triples.rows(use_selected_rows);
-      to_return = TTriads(current_network,
-                          pass_in,
-                          alpha,
-                          together);
-    } else {
-      // the base case for normal statistics
-      to_return = TTriads(current_network,
-                          triples,
-                          alpha,
-                          together);
-    }
+  if (total <= 0) {
+    return NA_REAL;
   }
-  if (base_statistic_index == 5) {
-    if (!use_all_rows) {
-      arma::mat pass_in = pairs.rows(use_selected_rows);
-      to_return = EdgeDensity(current_network,
-                          pass_in,
-                          alpha,
-                          together);
-    } else {
-      // the base case for normal statistics
-      to_return = EdgeDensity(current_network,
-                              pairs,
-                              alpha,
-                              together);
+  double q = 0;
+  for (int j = 0; j < n; ++j) {
+    for (int i = 0; i < n; ++i) {
+      if (i != j && memberships[i] == memberships[j]) {
+        double w = net(i, j);
+        if (undirected) {
+          w = std::max(net(i, j), net(j, i));
+        }
+        q += w - out_strength[i] * in_strength[j] / total;
+      }
     }
   }
-  if (base_statistic_index == 6) {
-    arma::vec d = arma::diagvec(current_network);
-    if (!use_all_rows) {
-      // may want to update this in the future
-      to_return = arma::sum(d);
-    } else {
-      // the base case for normal statistics
-      to_return = arma::sum(d);
-    }
+  // the i == j terms of the null model still count
+  for (int i = 0; i < n; ++i) {
+    q -= out_strength[i] * in_strength[i] / total;
   }
-
-  return to_return;
+  return q / total;
 }
 
-
-// Function to set up h statistic calculation
-double get_individual_statistic_value(arma::mat current_network,
-                                      arma::vec statistics_to_use,
-                                      int index,
-                                      arma::Mat<double> triples,
-                                      arma::Mat<double> pairs,
-                                      double alpha,
-                                      int together,
-                                      arma::umat selected_rows_matrix,
-                                      arma::vec rows_to_use,
-                                      arma::vec non_base_statistic_indicator,
-                                      arma::Mat<double> random_triad_samples,
-                                      arma::Mat<double> random_dyad_samples,
-                                      bool use_triad_sampling) {
-
-    // some notes on particular arguments:
-    //
-    // use_selected_rows -- for statistics we wish to calculate on some subnetwork,
-    // this matrix will provide the row indices. The matrix will have one column
-    // for each statistic to be included in the model and will have a number of
-    // rows equal to the maximum number of indicies indicated for any particular
-    // statistic.
-    //
-    // rows_to_use -- tells us how many rows in each column shoul actually be used.
-    // this is meant to avoid having to pass in a list which would be horribly slow.
-    //
-    // statistics_to_use -- a vector for each statistic included in the model
-    // indicating which base statistic it corresponds to.
-    //
-    // index  -- the numeric index of which entry in statistics_to_use we are
-    // operating on
-
-    // get the current statistic index
-    int base_statistic_index = statistics_to_use[index];
-
-    // determine whether we are going to use all rows or not
-    bool use_all_rows = true;
-
-    // set the use_selected_rows vector even if we are not going to use them.
-    arma::uvec use_selected_rows = selected_rows_matrix.col(index);
-    int from = 0;
-    int to = rows_to_use[index];
-    //Rcpp::Rcout << "from " << from << std::endl;
-    //Rcpp::Rcout << "to " << to << std::endl;
-    use_selected_rows = use_selected_rows.subvec(from, to);
-    //Rcpp::Rcout << "use_selected_rows " << use_selected_rows << std::endl;
-
-    double to_return = 0;
-    // if we are not using a base statistic, set use_all_rows to false.
-    if (non_base_statistic_indicator[index] == 1) {
-      use_all_rows = false;
-      to_return = calculate_individual_statistic(current_network,
-                                                 base_statistic_index,
-                                                 triples,
-                                                 pairs,
-                                                 alpha,
-                                                 together,
-                                                 use_selected_rows,
-                                                 use_all_rows);
-    } else {
-      // if we are using a base statistic and are using triad down-sampling then
-      // set use selected rows to this.
-      if (use_triad_sampling) {
-        // Function that will calculate h statistics
-        to_return = calculate_individual_statistic(current_network,
-                                                   base_statistic_index,
-                                                   random_triad_samples,
-                                                   random_dyad_samples,
-                                                   alpha,
-                                                   together,
-                                                   use_selected_rows,
-                                                   use_all_rows);
-      } else {
-        // Function that will calculate h statistics
-        to_return = calculate_individual_statistic(current_network,
-                                                   base_statistic_index,
-                                                   triples,
-                                                   pairs,
-                                                   alpha,
-                                                   together,
-                                                   use_selected_rows,
-                                                   use_all_rows);
-      }
-    }
-
-    return to_return;
-  }
-
-
-struct Parallel_CalculateNetworkStatistics : public RcppParallel::Worker {
-  arma::mat current_network;
-  arma::vec statistics_to_use;
-  arma::Mat<double> triples;
-  arma::Mat<double> pairs;
-  arma::vec alphas;
-  int together;
-  arma::umat selected_rows_matrix;
-  arma::vec rows_to_use;
-  arma::vec non_base_statistic_indicator;
-  arma::Mat<double> random_triad_samples;
-  arma::Mat<double> random_dyad_samples;
-  bool use_triad_sampling;
-  arma::vec thetas;
-  RcppParallel::RVector<double> return_dist;
-
-  Parallel_CalculateNetworkStatistics(arma::mat current_network,
-                                      arma::vec statistics_to_use,
-                                      arma::Mat<double> triples,
-                                      arma::Mat<double> pairs,
-                                      arma::vec alphas,
-                                      int together,
-                                      arma::umat selected_rows_matrix,
-                                      arma::vec rows_to_use,
-                                      arma::vec non_base_statistic_indicator,
-                                      arma::Mat<double> random_triad_samples,
-                                      arma::Mat<double> random_dyad_samples,
-                                      bool use_triad_sampling,
-                                      arma::vec thetas,
-                                      Rcpp::NumericVector return_dist)
-    : current_network(current_network),
-      statistics_to_use(statistics_to_use),
-      triples(triples),
-      pairs(pairs),
-      alphas(alphas),
-      together(together),
-      selected_rows_matrix(selected_rows_matrix),
-      rows_to_use(rows_to_use),
-      non_base_statistic_indicator(non_base_statistic_indicator),
-      random_triad_samples(random_triad_samples),
-      random_dyad_samples(random_dyad_samples),
-      use_triad_sampling(use_triad_sampling),
-      thetas(thetas),
-      return_dist(return_dist) {}
+// Calculates the statistics of every slice of a cube of networks, split
+// across threads by slice. Everything is written straight into the output
+// matrices, so slices do not interact.
+struct Parallel_Network_Cube_Statistics : public RcppParallel::Worker {
+
+  const GergmModel& model;
+  const arma::cube& networks;
+  arma::vec memberships;
+  bool calculate_statistics;
+  bool calculate_modularity;
+  bool undirected;
+  RcppParallel::RMatrix<double> statistics;
+  RcppParallel::RMatrix<double> out_degrees;
+  RcppParallel::RMatrix<double> in_degrees;
+  RcppParallel::RVector<double> densities;
+  RcppParallel::RVector<double> modularities;
+
+  Parallel_Network_Cube_Statistics(const GergmModel& model,
+                                   const arma::cube& networks,
+                                   arma::vec memberships,
+                                   bool calculate_statistics,
+                                   bool calculate_modularity,
+                                   bool undirected,
+                                   Rcpp::NumericMatrix statistics,
+                                   Rcpp::NumericMatrix out_degrees,
+                                   Rcpp::NumericMatrix in_degrees,
+                                   Rcpp::NumericVector densities,
+                                   Rcpp::NumericVector modularities)
+    : model(model),
+      networks(networks),
+      memberships(memberships),
+      calculate_statistics(calculate_statistics),
+      calculate_modularity(calculate_modularity),
+      undirected(undirected),
+      statistics(statistics),
+      out_degrees(out_degrees),
+      in_degrees(in_degrees),
+      densities(densities),
+      modularities(modularities) {}
 
   void operator()(std::size_t begin, std::size_t end) {
-    for (std::size_t i = begin; i < end; i++) {
-      return_dist[i] = thetas[i] * get_individual_statistic_value(
-        current_network,
-        statistics_to_use,
-        i,
-        triples,
-        pairs,
-        alphas[i],
-        together,
-        selected_rows_matrix,
-        rows_to_use,
-        non_base_statistic_indicator,
-        random_triad_samples,
-        random_dyad_samples,
-        use_triad_sampling);
-    }
-  }
-};
-
-double parallel_CalculateNetworkStatistics(
-    arma::mat current_network,
-    arma::vec statistics_to_use,
-    arma::Mat<double> triples,
-    arma::Mat<double> pairs,
-    arma::vec alphas,
-    int together,
-    arma::umat selected_rows_matrix,
-    arma::vec rows_to_use,
-    arma::vec non_base_statistic_indicator,
-    arma::Mat<double> random_triad_samples,
-    arma::Mat<double> random_dyad_samples,
-    bool use_triad_sampling,
-    arma::vec thetas) {
-
-  int number_of_stats = statistics_to_use.n_elem;
-  Rcpp::NumericVector output_vec(number_of_stats);
-
-  Parallel_CalculateNetworkStatistics Parallel_CalculateNetworkStatistics(
-      current_network,
-      statistics_to_use,
-      triples,
-      pairs,
-      alphas,
-      together,
-      selected_rows_matrix,
-      rows_to_use,
-      non_base_statistic_indicator,
-      random_triad_samples,
-      random_dyad_samples,
-      use_triad_sampling,
-      thetas,
-      output_vec);
-
-  RcppParallel::parallelFor(0,
-                            number_of_stats,
-                            Parallel_CalculateNetworkStatistics);
-
-  double return_val = 0;
-  for (int i = 0; i < number_of_stats; i++) {
-    return_val += output_vec[i];
-  }
-
-  return return_val;
-}
-
-// Function that will calculate h statistics
-double CalculateNetworkStatistics(arma::mat current_network,
-                                  arma::vec statistics_to_use,
-                                  arma::vec thetas,
-                                  arma::Mat<double> triples,
-                                  arma::Mat<double> pairs,
-                                  arma::vec alphas,
-                                  int together,
-                                  bool parallel,
-                                  arma::umat selected_rows_matrix,
-                                  arma::vec rows_to_use,
-                                  arma::vec non_base_statistic_indicator,
-                                  arma::Mat<double> random_triad_samples,
-                                  arma::Mat<double> random_dyad_samples,
-                                  bool use_triad_sampling) {
-
-  // this is the number of statistics we will be operating on in sampling
-  int number_of_thetas = statistics_to_use.n_elem;
-
-  double to_return = 0;
-  if (parallel) {
-    to_return = gergm::parallel_CalculateNetworkStatistics(
-      current_network,
-      statistics_to_use,
-      triples,
-      pairs,
-      alphas,
-      together,
-      selected_rows_matrix,
-      rows_to_use,
-      non_base_statistic_indicator,
-      random_triad_samples,
-      random_dyad_samples,
-      use_triad_sampling,
-      thetas);
-  } else {
-    for (int i = 0; i < number_of_thetas; ++i) {
-      to_return += thetas[i] * get_individual_statistic_value(
-          current_network,
-          statistics_to_use,
-          i,
-          triples,
-          pairs,
-          alphas[i],
-          together,
-          selected_rows_matrix,
-          rows_to_use,
-          non_base_statistic_indicator,
-          random_triad_samples,
-          random_dyad_samples,
-          use_triad_sampling);
-    }
-  }
-  return to_return;
-};
-
-  // Function that will calculate and save all of the h statistics for a network
-  arma::vec save_network_statistics(arma::mat current_network,
-                                    arma::vec statistics_to_use,
-                                    arma::vec base_statistics_to_save,
-                                    arma::vec base_statistic_alphas,
-                                    arma::Mat<double> triples,
-                                    arma::Mat<double> pairs,
-                                    arma::vec alphas,
-                                    int together,
-                                    arma::umat save_statistics_selected_rows_matrix,
-                                    arma::vec rows_to_use,
-                                    int num_non_base_statistics,
-                                    arma::vec non_base_statistic_indicator) {
-
-    // determine which statistics are non-base statistics, then append these on to
-    // the end of the vector of all base statistics that we are going to calculate
-    // and return for this
-    int num_base_statistics_to_save = base_statistics_to_save.n_elem;
-    int statistics_to_save = num_non_base_statistics + num_base_statistics_to_save;
-    //combine everything appropriately so we can calculate on the extended set of
-    //statistics.
-    arma::vec statistic_values = arma::zeros(statistics_to_save);
-
-    // take all of the base_statistics_to_save values, then add on the non-base
-    // statistics at the end from the statistics_to_use vector we use in the
-    // normal MH updates.
-    arma::vec combined_statistics_to_use = arma::zeros(statistics_to_save);
-    arma::vec combined_alphas = arma::zeros(statistics_to_save);
-    arma::vec combined_rows_to_use = arma::zeros(statistics_to_save);
-    arma::vec combined_non_base_statistic_indicator = arma::zeros(statistics_to_save);
-
-    // loop through and populate with base statistic values
-    for (int i = 0; i < num_base_statistics_to_save; ++i) {
-      combined_statistics_to_use[i] = base_statistics_to_save[i];
-      combined_alphas[i] = base_statistic_alphas[i];
-    }
-    int counter = num_base_statistics_to_save;
-    for (int i = 0; i < non_base_statistic_indicator.n_elem; ++i) {
-      if (non_base_statistic_indicator[i] == 1) {
-        combined_statistics_to_use[counter] = statistics_to_use[i];
-        combined_alphas[counter] = alphas[i];
-        combined_rows_to_use[counter] = rows_to_use[i];
-        combined_non_base_statistic_indicator[counter] = 1;
-        counter += 1;
-      }
-    }
-
-    // figure out the number of rows to use
-    arma::Mat<double> proxy_random_triad_samples(2,statistics_to_save);
-    arma::Mat<double> proxy_random_dyad_samples(2,statistics_to_save);
-
-    // loop through and calculate the statistics we are going to save and store
-    // them in a vector.
-    for (int i = 0; i < statistics_to_save; ++i) {
-      statistic_values[i] = get_individual_statistic_value(
-        current_network,
-        combined_statistics_to_use,
-        i,
-        triples,
-        pairs,
-        combined_alphas[i],
-        together,
-        save_statistics_selected_rows_matrix,
-        combined_rows_to_use,
-        combined_non_base_statistic_indicator,
-        proxy_random_triad_samples,
-        proxy_random_dyad_samples,
-        false);
-    }
-
-
-    return statistic_values;
-  };
-
-  // Function that will calculate h statistics
-  double integrand(arma::mat current_network,
-                   arma::vec statistics_to_use,
-                   arma::vec thetas,
-                   arma::Mat<double> triples,
-                   arma::Mat<double> pairs,
-                   arma::umat save_statistics_selected_rows_matrix,
-                   arma::vec rows_to_use,
-                   arma::vec base_statistics_to_save,
-                   arma::vec base_statistic_alphas,
-                   int num_non_base_statistics,
-                   arma::vec non_base_statistic_indicator,
-                   arma::vec alphas,
-                   int together,
-                   int sender,
-                   int recipient,
-                   double edge_value) {
-
-    if (edge_value != -1) {
-      // assign the current edge value in the current spot
-      current_network(sender,recipient) = edge_value;
-    }
-
-    // calculate theta times the current statistics.
-    arma::vec save_stats = gergm::save_network_statistics(
-      current_network,
-      statistics_to_use,
-      base_statistics_to_save,
-      base_statistic_alphas,
-      triples,
-      pairs,
-      alphas,
-      together,
-      save_statistics_selected_rows_matrix,
-      rows_to_use,
-      num_non_base_statistics,
-      non_base_statistic_indicator);
-
-    // now multiply thetas by the statistics
-    int num_theta = thetas.n_elem;
-    double to_return = 0;
-    for (int i = 0; i < num_theta; ++i) {
-      to_return += thetas[i] * save_stats[i];
-    }
-    return to_return;
-  };
-
-  // Function that will calculate h statistics and multiply by theta for the
-  // distribution estimator
-  double distribution_integrand(arma::mat current_network,
-                   arma::vec statistics_to_use,
-                   arma::vec thetas,
-                   arma::Mat<double> triples,
-                   arma::Mat<double> pairs,
-                   arma::umat save_statistics_selected_rows_matrix,
-                   arma::vec rows_to_use,
-                   arma::vec base_statistics_to_save,
-                   arma::vec base_statistic_alphas,
-                   int num_non_base_statistics,
-                   arma::vec non_base_statistic_indicator,
-                   arma::vec alphas,
-                   int together,
-                   int row,
-                   int col1,
-                   int col2,
-                   double edge_value,
-                   double edge_value2) {
-
-    // note that for now, I am not removing col2. Edge_value2 is now the current
-    // true edge value
-    if (edge_value != -1) {
-      // assign the current edge value in the current spot
-      current_network(row,col1) = edge_value;
-      current_network(row,col2) = edge_value2;
-      // int num_nodes = current_network.n_cols;
-      // for (int i = 0; i < num_nodes; ++i) {
-      //   if (i != col1) {
-      //     double cur = current_network(row,i);
-      //     //deal with care of a point mass
-      //     if (edge_value2 == 1) {
-      //       current_network(row,i) = double(1/double(num_nodes - 1)) * (1 - edge_value);
-      //     } else {
-      //       current_network(row,i) = (cur / double(1 - edge_value2)) * (1 - edge_value);
-      //     }
-      //   }
-      // }
-    }
-
-    // calculate theta times the current statistics.
-    arma::vec save_stats = gergm::save_network_statistics(
-      current_network,
-      statistics_to_use,
-      base_statistics_to_save,
-      base_statistic_alphas,
-      triples,
-      pairs,
-      alphas,
-      together,
-      save_statistics_selected_rows_matrix,
-      rows_to_use,
-      num_non_base_statistics,
-      non_base_statistic_indicator);
-
-    // now multiply thetas by the statistics
-    int num_theta = thetas.n_elem;
-    double to_return = 0;
-    for (int i = 0; i < num_theta; ++i) {
-      to_return += thetas[i] * save_stats[i];
-    }
-    return to_return;
-  };
-
-
-  // create a RcppParallel::Worker struct that we can use to fill in the
-  // entries in our token topic distribution in parallel
-  struct Parallel_Integrand : public RcppParallel::Worker {
-
-    // Instantiate all of our input variables which will then be initialized
-    // via the Function initializer below. This is how the struct makes sure
-    // that everything has the right type
-    arma::mat current_network;
-    arma::vec statistics_to_use;
-    arma::vec thetas;
-    arma::Mat<double> triples;
-    arma::Mat<double> pairs;
-    arma::umat save_statistics_selected_rows_matrix;
-    arma::vec rows_to_use;
-    arma::vec base_statistics_to_save;
-    arma::vec base_statistic_alphas;
-    int num_non_base_statistics;
-    arma::vec non_base_statistic_indicator;
-    arma::vec alphas;
-    int together;
-    int sender;
-    int recipient;
-    arma::vec integration_interval;
-
-    // We need to initialize the output vector to an RcppParallel::RVector
-    // vector (which is compatible with an Rcpp::NumericVector but not an
-    // arma::vec). This is what will be implicitly returned
-    RcppParallel::RVector<double> return_dist;
-
-    // Function initializer
-    Parallel_Integrand(arma::mat current_network,
-                       arma::vec statistics_to_use,
-                       arma::vec thetas,
-                       arma::Mat<double> triples,
-                       arma::Mat<double> pairs,
-                       arma::umat save_statistics_selected_rows_matrix,
-                       arma::vec rows_to_use,
-                       arma::vec base_statistics_to_save,
-                       arma::vec base_statistic_alphas,
-                       int num_non_base_statistics,
-                       arma::vec non_base_statistic_indicator,
-                       arma::vec alphas,
-                       int together,
-                       int sender,
-                       int recipient,
-                       arma::vec integration_interval,
-                       Rcpp::NumericVector return_dist)
-      : current_network(current_network),
-        statistics_to_use(statistics_to_use),
-        thetas(thetas),
-        triples(triples),
-        pairs(pairs),
-        save_statistics_selected_rows_matrix(save_statistics_selected_rows_matrix),
-        rows_to_use(rows_to_use),
-        base_statistics_to_save(base_statistics_to_save),
-        base_statistic_alphas(base_statistic_alphas),
-        num_non_base_statistics(num_non_base_statistics),
-        non_base_statistic_indicator(non_base_statistic_indicator),
-        alphas(alphas),
-        together(together),
-        sender(sender),
-        recipient(recipient),
-        integration_interval(integration_interval),
-        return_dist(return_dist) {}
-
-    // function call operator that works for the specified range (begin/end)
-    void operator()(std::size_t begin, std::size_t end) {
-      for (std::size_t i = begin; i < end; i++) {
-        double integ = gergm::integrand(current_network,
-                                        statistics_to_use,
-                                        thetas,
-                                        triples,
-                                        pairs,
-                                        save_statistics_selected_rows_matrix,
-                                        rows_to_use,
-                                        base_statistics_to_save,
-                                        base_statistic_alphas,
-                                        num_non_base_statistics,
-                                        non_base_statistic_indicator,
-                                        alphas,
-                                        together,
-                                        sender,
-                                        recipient,
-                                        integration_interval[i]);
-        return_dist[i] = integ;
-      }
-    }
-  };
-
-  // do the same thing but for distributions
-  // create a RcppParallel::Worker struct that we can use to fill in the
-  // entries in our token topic distribution in parallel
-  struct Distribution_Parallel_Integrand : public RcppParallel::Worker {
-
-    // Instantiate all of our input variables which will then be initialized
-    // via the Function initializer below. This is how the struct makes sure
-    // that everything has the right type
-    arma::mat current_network;
-    arma::vec statistics_to_use;
-    arma::vec thetas;
-    arma::Mat<double> triples;
-    arma::Mat<double> pairs;
-    arma::umat save_statistics_selected_rows_matrix;
-    arma::vec rows_to_use;
-    arma::vec base_statistics_to_save;
-    arma::vec base_statistic_alphas;
-    int num_non_base_statistics;
-    arma::vec non_base_statistic_indicator;
-    arma::vec alphas;
-    int together;
-    int row;
-    int col1;
-    int col2;
-    arma::vec integration_interval;
-
-    // We need to initialize the output vector to an RcppParallel::RVector
-    // vector (which is compatible with an Rcpp::NumericVector but not an
-    // arma::vec). This is what will be implicitly returned
-    RcppParallel::RVector<double> return_dist;
-
-    // Function initializer
-    Distribution_Parallel_Integrand(arma::mat current_network,
-                       arma::vec statistics_to_use,
-                       arma::vec thetas,
-                       arma::Mat<double> triples,
-                       arma::Mat<double> pairs,
-                       arma::umat save_statistics_selected_rows_matrix,
-                       arma::vec rows_to_use,
-                       arma::vec base_statistics_to_save,
-                       arma::vec base_statistic_alphas,
-                       int num_non_base_statistics,
-                       arma::vec non_base_statistic_indicator,
-                       arma::vec alphas,
-                       int together,
-                       int row,
-                       int col1,
-                       int col2,
-                       arma::vec integration_interval,
-                       Rcpp::NumericVector return_dist)
-      : current_network(current_network),
-        statistics_to_use(statistics_to_use),
-        thetas(thetas),
-        triples(triples),
-        pairs(pairs),
-        save_statistics_selected_rows_matrix(save_statistics_selected_rows_matrix),
-        rows_to_use(rows_to_use),
-        base_statistics_to_save(base_statistics_to_save),
-        base_statistic_alphas(base_statistic_alphas),
-        num_non_base_statistics(num_non_base_statistics),
-        non_base_statistic_indicator(non_base_statistic_indicator),
-        alphas(alphas),
-        together(together),
-        row(row),
-        col1(col1),
-        col2(col2),
-        integration_interval(integration_interval),
-        return_dist(return_dist) {}
-
-    // function call operator that works for the specified range (begin/end)
-    void operator()(std::size_t begin, std::size_t end) {
-      for (std::size_t i = begin; i < end; i++) {
-        //get the current values
-        // double edge1 = integration_interval[i];
-        // double edge2 = current_network(row,col1);
-
-        // for the pairwise version
-        double edge1 = current_network(row,col1);
-        double edge2 = current_network(row,col2);
-        // sum them
-        double cur_sum = edge1 + edge2;
-        //divy them up to the two new edge values to try
-        edge1 = integration_interval[i] * cur_sum;
-        edge2 = (1 - integration_interval[i]) * cur_sum;
-
-        double integ = distribution_integrand(current_network,
-                                               statistics_to_use,
-                                               thetas,
-                                               triples,
-                                               pairs,
-                                               save_statistics_selected_rows_matrix,
-                                               rows_to_use,
-                                               base_statistics_to_save,
-                                               base_statistic_alphas,
-                                               num_non_base_statistics,
-                                               non_base_statistic_indicator,
-                                               alphas,
-                                               together,
-                                               row,
-                                               col1,
-                                               col2,
-                                               edge1,
-                                               edge2);
-        return_dist[i] = integ;
-      }
-    }
-  };
-
-
-  arma::vec parallel_integration(
-      arma::mat current_network,
-      arma::vec statistics_to_use,
-      arma::vec thetas,
-      arma::Mat<double> triples,
-      arma::Mat<double> pairs,
-      arma::umat save_statistics_selected_rows_matrix,
-      arma::vec rows_to_use,
-      arma::vec base_statistics_to_save,
-      arma::vec base_statistic_alphas,
-      int num_non_base_statistics,
-      arma::vec non_base_statistic_indicator,
-      arma::vec alphas,
-      int together,
-      int sender,
-      int recipient,
-      arma::vec integration_interval) {
-
-    int innterval_size = integration_interval.n_elem;
-    // the vector that will be operated on by RcppParallel::parallelFor.
-    // This vector must be an Rcpp::NumericVector or the parallelization
-    // will not work. THis makes everything slower, but I have not found an
-    // alternative
-    Rcpp::NumericVector output_vec(innterval_size);
-    // Once we have the token topic distribution back from the parallel for
-    // function, we will put it in to an arma::vec of the same length.
-    arma::vec return_vec = arma::zeros(innterval_size);
-
-    // create the RcppParallel::Worker function which will iterate over the
-    // distribution
-    Parallel_Integrand Parallel_Integrand(
-        current_network,
-        statistics_to_use,
-        thetas,
-        triples,
-        pairs,
-        save_statistics_selected_rows_matrix,
-        rows_to_use,
-        base_statistics_to_save,
-        base_statistic_alphas,
-        num_non_base_statistics,
-        non_base_statistic_indicator,
-        alphas,
-        together,
-        sender,
-        recipient,
-        integration_interval,
-        output_vec);
-
-    // Call our Parallel_Token_Topic_Distribution with parallelFor
-    RcppParallel::parallelFor(0,
-                              innterval_size,
-                              Parallel_Integrand);
-
-    // Take the NumericVector output and put it in the arma::vec to actually
-    // return
-    for (int i = 0; i < innterval_size; i++) {
-      // write to output vector
-      return_vec[i] = output_vec[i];
-    }
-
-    return return_vec;
-  };
-
-  // do the same thing for distributions
-  arma::vec distribution_parallel_integration(
-      arma::mat current_network,
-      arma::vec statistics_to_use,
-      arma::vec thetas,
-      arma::Mat<double> triples,
-      arma::Mat<double> pairs,
-      arma::umat save_statistics_selected_rows_matrix,
-      arma::vec rows_to_use,
-      arma::vec base_statistics_to_save,
-      arma::vec base_statistic_alphas,
-      int num_non_base_statistics,
-      arma::vec non_base_statistic_indicator,
-      arma::vec alphas,
-      int together,
-      int row,
-      int col1,
-      int col2,
-      arma::vec integration_interval) {
-
-    int innterval_size = integration_interval.n_elem;
-    // the vector that will be operated on by RcppParallel::parallelFor.
-    // This vector must be an Rcpp::NumericVector or the parallelization
-    // will not work. THis makes everything slower, but I have not found an
-    // alternative
-    Rcpp::NumericVector output_vec(innterval_size);
-    // Once we have the token topic distribution back from the parallel for
-    // function, we will put it in to an arma::vec of the same length.
-    arma::vec return_vec = arma::zeros(innterval_size);
-
-    // create the RcppParallel::Worker function which will iterate over the
-    // distribution
-    Distribution_Parallel_Integrand Distribution_Parallel_Integrand(
-        current_network,
-        statistics_to_use,
-        thetas,
-        triples,
-        pairs,
-        save_statistics_selected_rows_matrix,
-        rows_to_use,
-        base_statistics_to_save,
-        base_statistic_alphas,
-        num_non_base_statistics,
-        non_base_statistic_indicator,
-        alphas,
-        together,
-        row,
-        col1,
-        col2,
-        integration_interval,
-        output_vec);
-
-    // Call our Parallel_Token_Topic_Distribution with parallelFor
-    RcppParallel::parallelFor(0,
-                              innterval_size,
-                              Distribution_Parallel_Integrand);
-
-    // Take the NumericVector output and put it in the arma::vec to actually
-    // return
-    for (int i = 0; i < innterval_size; i++) {
-      // write to output vector
-      return_vec[i] = output_vec[i];
-    }
-
-    return return_vec;
-  };
-
-  double log_sum_exp_integrator (arma::mat current_network,
-                                 arma::vec statistics_to_use,
-                                 arma::vec thetas,
-                                 arma::Mat<double> triples,
-                                 arma::Mat<double> pairs,
-                                 arma::umat save_statistics_selected_rows_matrix,
-                                 arma::vec rows_to_use,
-                                 arma::vec base_statistics_to_save,
-                                 arma::vec base_statistic_alphas,
-                                 int num_non_base_statistics,
-                                 arma::vec non_base_statistic_indicator,
-                                 arma::vec alphas,
-                                 int together,
-                                 int sender,
-                                 int recipient,
-                                 arma::vec integration_interval,
-                                 bool parallel) {
-
-    int num_evaluations = integration_interval.n_elem;
-    arma::vec integral_evaluations = arma::zeros(num_evaluations);
-
-    if (parallel) {
-      integral_evaluations = parallel_integration(
-        current_network,
-        statistics_to_use,
-        thetas,
-        triples,
-        pairs,
-        save_statistics_selected_rows_matrix,
-        rows_to_use,
-        base_statistics_to_save,
-        base_statistic_alphas,
-        num_non_base_statistics,
-        non_base_statistic_indicator,
-        alphas,
-        together,
-        sender,
-        recipient,
-        integration_interval);
-    } else {
-      for (int i = 0; i < num_evaluations; ++i) {
-        integral_evaluations[i] = integrand(current_network,
-                                            statistics_to_use,
-                                            thetas,
-                                            triples,
-                                            pairs,
-                                            save_statistics_selected_rows_matrix,
-                                            rows_to_use,
-                                            base_statistics_to_save,
-                                            base_statistic_alphas,
-                                            num_non_base_statistics,
-                                            non_base_statistic_indicator,
-                                            alphas,
-                                            together,
-                                            sender,
-                                            recipient,
-                                            integration_interval[i]);
-      }
-    }
-
-    //Rcpp::Rcout << "integral_evaluations " << integral_evaluations << std::endl;
-
-    // find the max on the interval
-    double max_val = arma::max(integral_evaluations);
-
-    // now calculate log sum exp
-    double sum_term = 0;
-    for (int i = 0; i < num_evaluations; ++i) {
-      sum_term += exp(integral_evaluations[i] - max_val);
-    }
-
-    // we are taking the average
-    sum_term = sum_term/double(num_evaluations);
-
-    sum_term = max_val + log(sum_term);
-
-    return sum_term;
-
-  };
-
-  // now do the same thing for the distribution estimator
-  double distribution_log_sum_exp_integrator (arma::mat current_network,
-                                 arma::vec statistics_to_use,
-                                 arma::vec thetas,
-                                 arma::Mat<double> triples,
-                                 arma::Mat<double> pairs,
-                                 arma::umat save_statistics_selected_rows_matrix,
-                                 arma::vec rows_to_use,
-                                 arma::vec base_statistics_to_save,
-                                 arma::vec base_statistic_alphas,
-                                 int num_non_base_statistics,
-                                 arma::vec non_base_statistic_indicator,
-                                 arma::vec alphas,
-                                 int together,
-                                 int row,
-                                 int col1,
-                                 int col2,
-                                 arma::vec integration_interval,
-                                 bool parallel) {
-
-    int num_evaluations = integration_interval.n_elem;
-    arma::vec integral_evaluations = arma::zeros(num_evaluations);
-
-    if (parallel) {
-      integral_evaluations = distribution_parallel_integration(
-        current_network,
-        statistics_to_use,
-        thetas,
-        triples,
-        pairs,
-        save_statistics_selected_rows_matrix,
-        rows_to_use,
-        base_statistics_to_save,
-        base_statistic_alphas,
-        num_non_base_statistics,
-        non_base_statistic_indicator,
-        alphas,
-        together,
-        row,
-        col1,
-        col2,
-        integration_interval);
-    } else {
-      for (int i = 0; i < num_evaluations; ++i) {
-        //determine hte edge values to pass in
-        //get the current values
-        // double edge1 = integration_interval[i];
-        // double edge2 = current_network(row,col1);
-
-
-        double edge1 = current_network(row,col1);
-        double edge2 = current_network(row,col2);
-        // sum them
-        double cur_sum = edge1 + edge2;
-        //divy them up to the two new edge values to try
-        edge1 = integration_interval[i] * cur_sum;
-        edge2 = (1 - integration_interval[i]) * cur_sum;
-
-        integral_evaluations[i] = distribution_integrand(current_network,
-                                            statistics_to_use,
-                                            thetas,
-                                            triples,
-                                            pairs,
-                                            save_statistics_selected_rows_matrix,
-                                            rows_to_use,
-                                            base_statistics_to_save,
-                                            base_statistic_alphas,
-                                            num_non_base_statistics,
-                                            non_base_statistic_indicator,
-                                            alphas,
-                                            together,
-                                            row,
-                                            col1,
-                                            col2,
-                                            edge1,
-                                            edge2);
-      }
-    }
-
-    //Rcpp::Rcout << "integral_evaluations " << integral_evaluations << std::endl;
-
-    // find the max on the interval
-    double max_val = arma::max(integral_evaluations);
-
-    // now calculate log sum exp
-    double sum_term = 0;
-    for (int i = 0; i < num_evaluations; ++i) {
-      sum_term += exp(integral_evaluations[i] - max_val);
-    }
-
-    // we are taking the average
-    sum_term = sum_term/double(num_evaluations);
-
-    sum_term = max_val + log(sum_term);
-
-    return sum_term;
-
-  };
-
-  arma::vec rdirichlet(arma::vec alpha_m) {
-    // this example is drawn from:
-    // https://en.wikipedia.org/wiki/Dirichlet_distribution#Random_number_generation
-
-    int distribution_size = alpha_m.n_elem;
-    arma::vec distribution = arma::zeros(distribution_size);
-
-    // loop through the distribution and draw Gamma variables
-    for (int i = 0; i < distribution_size; ++i) {
-      double cur = R::rgamma(alpha_m[i],1.0);
-      distribution[i] = cur;
-    }
-
-    double gamma_sum = arma::sum(distribution);
-
-    for (int i = 0; i < distribution_size; ++i) {
-      double temp = distribution[i];
-      distribution[i] = temp/gamma_sum;
-    }
-
-    return distribution;
-  }
-
-  arma::vec uniform_dirichlet_draw(arma::vec current_edge_values,
-                                   double variance) {
-    int len = current_edge_values.n_elem;
-    arma::vec alpha_m = arma::ones(len);
-    // get a uniform dirichlet draw
-    arma::vec uniform_dir = gergm::rdirichlet(alpha_m);
-
-    // get a random uniform draw
-    double draw = R::runif(0,1);
-
-    arma::vec proposal = arma::zeros(len);
-    if (draw < variance) {
-      // if it is less than the variance, then our proposal is just the uniform
-      // dirichlet (unmixed).
-      proposal = uniform_dir;
-    } else {
-      // we mix the old position with the new one
-      proposal = variance * uniform_dir + (1 - variance) * current_edge_values;
-    }
-
-    return(proposal);
-  }
-
-  bool point_in_simplex(arma::vec current_edge_values,
-                        arma::vec new_edge_values,
-                        double variance) {
-
-    int len = current_edge_values.n_elem;
-    //loop over and check to see if there are any
-    bool in_simplex = true;
-    for (int i = 0; i < len; ++i) {
-      double cur = (new_edge_values[i] - (1 - variance) * current_edge_values[i])/variance;
-      if (cur < 0) {
-        in_simplex = false;
-        break;
-      }
-    }
-    return(in_simplex);
-  }
-
-
-} //end of gergm namespace
-
-using std::log;
-
-// [[Rcpp::export]]
-List Extended_Metropolis_Hastings_Sampler (int number_of_iterations,
-                                  double shape_parameter,
-                                  int number_of_nodes,
-                                  arma::vec statistics_to_use,
-                                  arma::mat initial_network,
-                                  int take_sample_every,
-                                  arma::vec thetas,
-                                  arma::Mat<double> triples,
-                                  arma::Mat<double> pairs,
-                                  arma::vec alphas,
-                                  int together,
-                                  int seed,
-                                  int number_of_samples_to_store,
-                                  int using_correlation_network,
-                                  int undirect_network,
-                                  bool parallel,
-                                  arma::umat use_selected_rows,
-                                  arma::umat save_statistics_selected_rows_matrix,
-                                  arma::vec rows_to_use,
-                                  arma::vec base_statistics_to_save,
-                                  arma::vec base_statistic_alphas,
-                                  int num_non_base_statistics,
-                                  arma::vec non_base_statistic_indicator,
-                                  double p_ratio_multaplicative_factor,
-                                  Rcpp::List random_triad_sample_list,
-                                  Rcpp::List random_dyad_sample_list,
-                                  bool use_triad_sampling,
-                                  int num_unique_random_triad_samples,
-                                  bool include_diagonal) {
-
-  // Allocate variables and data structures
-  double variance = shape_parameter;
-  // the list we will put stuff in to return it to R
-  int list_length = 9;
-  List to_return(list_length);
-  // this is the number of statistics we will be saving (all selected base + non base)
-  int statistics_to_save = num_non_base_statistics +
-    base_statistics_to_save.n_elem;
-
-  int MH_Counter = 0;
-  int Storage_Counter = 0;
-  bool network_did_not_change = false;
-  double previous_h_function_value = 0;
-  arma::vec Accept_or_Reject = arma::zeros (number_of_iterations);
-  arma::vec Log_Prob_Accept = arma::zeros (number_of_iterations);
-  arma::vec P_Ratios = arma::zeros (number_of_iterations);
-  arma::vec Q_Ratios = arma::zeros (number_of_iterations);
-  arma::vec Proposed_Density = arma::zeros (number_of_iterations);
-  arma::vec Current_Density = arma::zeros (number_of_iterations);
-  arma::cube Network_Samples = arma::zeros (number_of_nodes, number_of_nodes,
-                                            number_of_samples_to_store);
-  arma::vec Mean_Edge_Weights = arma::zeros (number_of_samples_to_store);
-  arma::mat Save_H_Statistics = arma::zeros (number_of_samples_to_store,
-                                             statistics_to_save);
-  arma::mat current_edge_weights = initial_network;
-  arma::mat corr_current_edge_weights = arma::zeros (number_of_nodes, number_of_nodes);
-
-  // values for stochastic MH
-  arma::Mat<double> random_triad_samples(2,2);
-  arma::Mat<double> random_dyad_samples(2,2);
-  int update_triad_samples_every = 10;
-  int triad_sample_update_counter = 0;
-  int random_triad_sample_counter = 0;
-  if (use_triad_sampling) {
-    arma::Mat<double> temp = random_triad_sample_list[random_triad_sample_counter];
-    random_triad_samples = temp;
-    arma::Mat<double> temp2 = random_dyad_sample_list[random_triad_sample_counter];
-    random_dyad_samples = temp2;
-    random_triad_sample_counter += 1;
-  }
-
-  // deal with the case where we have a correlation network.
-  if (using_correlation_network == 1) {
-    current_edge_weights.diag() = arma::ones(number_of_nodes);
-    undirect_network = 1;
-  }
-
-
-  // Set RNG and define uniform distribution
-  boost::mt19937 generator(seed);
-  boost::uniform_01<double> uniform_distribution;
-  // Outer loop over the number of samples
-  for (int n = 0; n < number_of_iterations; ++n) {
-    //Rcpp::Rcout << "Iteration: " << n << std::endl;
-    double log_prob_accept = 0;
-    arma::mat proposed_edge_weights = current_edge_weights;
-
-    // deal with the case where we have an undirected network.
-    if(undirect_network == 1){
-      // Run loop to sample new edge weights
-      for (int i = 0; i < number_of_nodes; ++i) {
-        for (int j = 0; j <= i; ++j) {
-          if (include_diagonal) {
-            double log_probability_of_current_under_new = 0;
-            double log_probability_of_new_under_current = 0;
-            //draw a new edge value centered at the old edge value
-            double current_edge_value = current_edge_weights(i,j);
-            //draw from a truncated normal
-            gergm::normal_distribution<double> proposal(current_edge_value,variance);
-            int in_zero_one = 0;
-            //NumericVector new_edge_value = 0.5;
-            double new_edge_value = 0.5;
-            while(in_zero_one == 0){
-              new_edge_value = proposal(generator);
-              if((new_edge_value > 0) & (new_edge_value < 1)){
-                in_zero_one = 1;
-              }
-            }
-            // calculate the probability of the new edge under current beta dist
-            double lower_bound = R::pnorm(0,current_edge_value,variance, 1, 0);
-            double upper_bound = R::pnorm(1,current_edge_value,variance, 1, 0);
-            double raw_prob = R::dnorm(new_edge_value,current_edge_value,variance,0);
-            double prob_new_edge_under_old = (raw_prob/(upper_bound - lower_bound));
-            // calculate the probability of the current edge under new beta dist
-            lower_bound = R::pnorm(0,new_edge_value,variance, 1, 0);
-            upper_bound = R::pnorm(1,new_edge_value,variance, 1, 0);
-            raw_prob = R::dnorm(current_edge_value,new_edge_value,variance,0);
-            double prob_old_edge_under_new = (raw_prob/(upper_bound - lower_bound));
-            //save everything
-            proposed_edge_weights(i,j) = new_edge_value;
-            proposed_edge_weights(j,i) = new_edge_value;
-            log_probability_of_new_under_current = log(prob_new_edge_under_old);
-            log_probability_of_current_under_new = log(prob_old_edge_under_new);
-
-            // Calculate acceptance probability
-            log_prob_accept += (log_probability_of_current_under_new
-                                  - log_probability_of_new_under_current);
-          } else {
-            if (i != j) {
-              double log_probability_of_current_under_new = 0;
-              double log_probability_of_new_under_current = 0;
-              //draw a new edge value centered at the old edge value
-              double current_edge_value = current_edge_weights(i,j);
-              //draw from a truncated normal
-              gergm::normal_distribution<double> proposal(current_edge_value,variance);
-              int in_zero_one = 0;
-              //NumericVector new_edge_value = 0.5;
-              double new_edge_value = 0.5;
-              while(in_zero_one == 0){
-                new_edge_value = proposal(generator);
-                if((new_edge_value > 0) & (new_edge_value < 1)){
-                  in_zero_one = 1;
-                }
-              }
-              // calculate the probability of the new edge under current beta dist
-              double lower_bound = R::pnorm(0,current_edge_value,variance, 1, 0);
-              double upper_bound = R::pnorm(1,current_edge_value,variance, 1, 0);
-              double raw_prob = R::dnorm(new_edge_value,current_edge_value,variance,0);
-              double prob_new_edge_under_old = (raw_prob/(upper_bound - lower_bound));
-              // calculate the probability of the current edge under new beta dist
-              lower_bound = R::pnorm(0,new_edge_value,variance, 1, 0);
-              upper_bound = R::pnorm(1,new_edge_value,variance, 1, 0);
-              raw_prob = R::dnorm(current_edge_value,new_edge_value,variance,0);
-              double prob_old_edge_under_new = (raw_prob/(upper_bound - lower_bound));
-              //save everything
-              proposed_edge_weights(i,j) = new_edge_value;
-              proposed_edge_weights(j,i) = new_edge_value;
-              log_probability_of_new_under_current = log(prob_new_edge_under_old);
-              log_probability_of_current_under_new = log(prob_old_edge_under_new);
-
-              // Calculate acceptance probability
-              log_prob_accept += (log_probability_of_current_under_new
-                                    - log_probability_of_new_under_current);
-
-            }
-          }
-        }
-      }
-
-    }else{
-      // int counter =  0;
-      // Run loop to sample new edge weights
-      for (int i = 0; i < number_of_nodes; ++i) {
-        for (int j = 0; j < number_of_nodes; ++j) {
-          if (include_diagonal) {
-            double log_probability_of_current_under_new = 0;
-            double log_probability_of_new_under_current = 0;
-            //draw a new edge value centered at the old edge value
-            double current_edge_value = current_edge_weights(i,j);
-            //draw from a truncated normal
-            gergm::normal_distribution<double> proposal(current_edge_value,variance);
-            int in_zero_one = 0;
-            //NumericVector new_edge_value = 0.5;
-            double new_edge_value = 0.5;
-            while(in_zero_one == 0){
-              new_edge_value = proposal(generator);
-              if((new_edge_value > 0) & (new_edge_value < 1)){
-                in_zero_one = 1;
-              }
-            }
-
-            // calculate the probability of the new edge under current beta dist
-            double lower_bound = R::pnorm(0,current_edge_value,variance, 1, 0);
-            double upper_bound = R::pnorm(1,current_edge_value,variance, 1, 0);
-            double raw_prob = R::dnorm(new_edge_value,current_edge_value,variance,0);
-            double prob_new_edge_under_old = (raw_prob/(upper_bound - lower_bound));
-
-            // calculate the probability of the current edge under new beta dist
-            lower_bound = R::pnorm(0,new_edge_value,variance, 1, 0);
-            upper_bound = R::pnorm(1,new_edge_value,variance, 1, 0);
-            raw_prob = R::dnorm(current_edge_value,new_edge_value,variance,0);
-            double prob_old_edge_under_new = (raw_prob/(upper_bound - lower_bound));
-
-            //save everything
-            proposed_edge_weights(i,j) = new_edge_value;
-            log_probability_of_new_under_current = log(prob_new_edge_under_old);
-            log_probability_of_current_under_new = log(prob_old_edge_under_new);
-
-            // Calculate acceptance probability
-            log_prob_accept += (log_probability_of_current_under_new
-                                  - log_probability_of_new_under_current);
-          } else {
-            if (i != j) {
-              double log_probability_of_current_under_new = 0;
-              double log_probability_of_new_under_current = 0;
-              //draw a new edge value centered at the old edge value
-              double current_edge_value = current_edge_weights(i,j);
-              //draw from a truncated normal
-              gergm::normal_distribution<double> proposal(current_edge_value,variance);
-              int in_zero_one = 0;
-              //NumericVector new_edge_value = 0.5;
-              double new_edge_value = 0.5;
-              while(in_zero_one == 0){
-                new_edge_value = proposal(generator);
-                if((new_edge_value > 0) & (new_edge_value < 1)){
-                  in_zero_one = 1;
-                }
-              }
-
-              // calculate the probability of the new edge under current beta dist
-              double lower_bound = R::pnorm(0,current_edge_value,variance, 1, 0);
-              double upper_bound = R::pnorm(1,current_edge_value,variance, 1, 0);
-              double raw_prob = R::dnorm(new_edge_value,current_edge_value,variance,0);
-              double prob_new_edge_under_old = (raw_prob/(upper_bound - lower_bound));
-
-              // calculate the probability of the current edge under new beta dist
-              lower_bound = R::pnorm(0,new_edge_value,variance, 1, 0);
-              upper_bound = R::pnorm(1,new_edge_value,variance, 1, 0);
-              raw_prob = R::dnorm(current_edge_value,new_edge_value,variance,0);
-              double prob_old_edge_under_new = (raw_prob/(upper_bound - lower_bound));
-
-              //save everything
-              proposed_edge_weights(i,j) = new_edge_value;
-              log_probability_of_new_under_current = log(prob_new_edge_under_old);
-              log_probability_of_current_under_new = log(prob_old_edge_under_new);
-
-              // Calculate acceptance probability
-              log_prob_accept += (log_probability_of_current_under_new
-                                    - log_probability_of_new_under_current);
-            }
-          }
-        }
-      }
-    } //end of condition for whether we are using a correlation network
-
-    double proposed_addition = 0;
-    double current_addition = 0;
-
-    // if we are using random triad sampling, then extract the appropriate
-    // triples and pairs matrices
-    if (update_triad_samples_every == triad_sample_update_counter) {
-      if (use_triad_sampling) {
-        arma::Mat<double> temp = random_triad_sample_list[random_triad_sample_counter];
-        random_triad_samples = temp;
-        arma::Mat<double> temp2 = random_dyad_sample_list[random_triad_sample_counter];
-        random_dyad_samples = temp2;
-      }
-      triad_sample_update_counter = 0;
-      // increment the random sample counter
-      random_triad_sample_counter += 1;
-      // if it is equal to the number of different samples we are working with,
-      // then reset it
-      if (num_unique_random_triad_samples == random_triad_sample_counter) {
-        random_triad_sample_counter = 0;
-      }
-    }
-    triad_sample_update_counter += 1;
-
-    if(using_correlation_network == 1){
-      arma::mat corr_proposed_edge_weights = gergm::bounded_to_correlations(proposed_edge_weights);
-      arma::mat corr_current_edge_weights = gergm::bounded_to_correlations(current_edge_weights);
-      proposed_addition = gergm::CalculateNetworkStatistics(
-        corr_proposed_edge_weights,
-        statistics_to_use,
-        thetas,
-        triples,
-        pairs,
-        alphas,
-        together,
-        parallel,
-        use_selected_rows,
-        rows_to_use,
-        non_base_statistic_indicator,
-        random_triad_samples,
-        random_dyad_samples,
-        use_triad_sampling);
-
-      current_addition = gergm::CalculateNetworkStatistics(
-        corr_current_edge_weights,
-        statistics_to_use,
-        thetas,
-        triples,
-        pairs,
-        alphas,
-        together,
-        parallel,
-        use_selected_rows,
-        rows_to_use,
-        non_base_statistic_indicator,
-        random_triad_samples,
-        random_dyad_samples,
-        use_triad_sampling);
-
-    }else{
-      proposed_addition = gergm::CalculateNetworkStatistics(
-        proposed_edge_weights,
-        statistics_to_use,
-        thetas,
-        triples,
-        pairs,
-        alphas,
-        together,
-        parallel,
-        use_selected_rows,
-        rows_to_use,
-        non_base_statistic_indicator,
-        random_triad_samples,
-        random_dyad_samples,
-        use_triad_sampling);
-      // only calculate the h function if we updated the network last round
-      // otherwise use the cached value.
-      if (network_did_not_change) {
-        current_addition = previous_h_function_value;
-      } else {
-        current_addition = gergm::CalculateNetworkStatistics(
-          current_edge_weights,
-          statistics_to_use,
-          thetas,
-          triples,
-          pairs,
-          alphas,
-          together,
-          parallel,
-          use_selected_rows,
-          rows_to_use,
-          non_base_statistic_indicator,
-          random_triad_samples,
-          random_dyad_samples,
-          use_triad_sampling);
-        previous_h_function_value = current_addition ;
-      }
-    }
-
-    // store some additional diagnostics h value is the last entry
-    P_Ratios[n] = p_ratio_multaplicative_factor * (proposed_addition -
-      current_addition);
-    Q_Ratios[n] = log_prob_accept;
-
-    double total_edges = double(number_of_nodes * (number_of_nodes - 1));
-    if (include_diagonal) {
-      total_edges = double(number_of_nodes * number_of_nodes);
-    }
-    double temp1 = arma::accu(proposed_edge_weights);
-    Proposed_Density[n] = temp1/total_edges;
-    double temp2 = arma::accu(current_edge_weights);
-    Current_Density[n] = temp2/total_edges;
-
-    // now we add in a p-ratio multaplicative factor incase we are randomly
-    // downsampling
-    log_prob_accept += p_ratio_multaplicative_factor * (proposed_addition -
-      current_addition);
-
-    if(using_correlation_network == 1){
-      // now add in the bit about Jacobians
-      double numerator = log(gergm::jacobian(2*proposed_edge_weights-1));
-      double denominator = log(gergm::jacobian(2*current_edge_weights-1));
-      log_prob_accept += numerator - denominator;
-    }
-
-    double rand_num = uniform_distribution(generator);
-    double lud = 0;
-    lud = log(rand_num);
-
-    double accept_proportion = 0;
-    // Accept or reject the new proposed positions
-    if (log_prob_accept < lud) {
-      accept_proportion +=0;
-      network_did_not_change = true;
-    } else {
-      accept_proportion +=1;
-      network_did_not_change = false;
-      for (int i = 0; i < number_of_nodes; ++i) {
-        for (int j = 0; j < number_of_nodes; ++j) {
-          if (include_diagonal) {
-            double temp = proposed_edge_weights(i, j);
-            current_edge_weights(i, j) = temp;
-          } else {
-            if (i != j) {
-              double temp = proposed_edge_weights(i, j);
-              current_edge_weights(i, j) = temp;
-            }
-          }
-        }
-      }
-    }
-
-    Log_Prob_Accept[n] = log_prob_accept;
-    Accept_or_Reject[n] = accept_proportion;
-    Storage_Counter += 1;
-
-    // Save network statistics
-    if (Storage_Counter == take_sample_every) {
-      //Rcpp::Rcout << "Iteration: " << n << std::endl;
-      if(using_correlation_network == 1){
-        arma::mat corr_current_edge_weights = gergm::bounded_to_correlations(current_edge_weights);
-        arma::vec save_stats = gergm::save_network_statistics(
-          corr_current_edge_weights,
-          statistics_to_use,
-          base_statistics_to_save,
-          base_statistic_alphas,
-          triples,
-          pairs,
-          alphas,
-          together,
-          save_statistics_selected_rows_matrix,
-          rows_to_use,
-          num_non_base_statistics,
-          non_base_statistic_indicator);
-        for (int m = 0; m < statistics_to_save; ++m) {
-          Save_H_Statistics(MH_Counter, m) = save_stats[m];
-        }
-      }else{
-        arma::vec save_stats = gergm::save_network_statistics(
-          current_edge_weights,
-          statistics_to_use,
-          base_statistics_to_save,
-          base_statistic_alphas,
-          triples,
-          pairs,
-          alphas,
-          together,
-          save_statistics_selected_rows_matrix,
-          rows_to_use,
-          num_non_base_statistics,
-          non_base_statistic_indicator);
-        for (int m = 0; m < statistics_to_save; ++m) {
-          Save_H_Statistics(MH_Counter, m) = save_stats[m];
+    int n = networks.n_rows;
+    for (std::size_t l = begin; l < end; l++) {
+      // a view of the slice, no copy
+      const arma::mat net(const_cast<double*>(networks.slice_memptr(l)), n, n,
+                          false, true);
+      if (calculate_statistics) {
+        arma::vec h = model.save_network_statistics(net);
+        for (arma::uword m = 0; m < h.n_elem; ++m) {
+          statistics(l, m) = h[m];
         }
       }
-
-
-      double mew = 0;
-      if(using_correlation_network == 1){
-        corr_current_edge_weights = gergm::bounded_to_correlations(current_edge_weights);
+      // degrees and density leave out the diagonal
+      double total = 0;
+      for (int i = 0; i < n; ++i) {
+        out_degrees(i, l) = 0;
+        in_degrees(i, l) = 0;
       }
-
-      for (int i = 0; i < number_of_nodes; ++i) {
-        for (int j = 0; j < number_of_nodes; ++j) {
-          if (include_diagonal) {
-            if(using_correlation_network == 1){
-              //we use this trick to break the referencing
-              double temp = corr_current_edge_weights(i, j);
-              Network_Samples(i, j, MH_Counter) = temp;
-              mew += temp;
-            }else{
-              //we use this trick to break the referencing
-              double temp = current_edge_weights(i, j);
-              Network_Samples(i, j, MH_Counter) = temp;
-              mew += temp;
-            }
-          } else {
-            if (i != j) {
-              if(using_correlation_network == 1){
-                //we use this trick to break the referencing
-                double temp = corr_current_edge_weights(i, j);
-                Network_Samples(i, j, MH_Counter) = temp;
-                mew += temp;
-              }else{
-                //we use this trick to break the referencing
-                double temp = current_edge_weights(i, j);
-                Network_Samples(i, j, MH_Counter) = temp;
-                mew += temp;
-              }
-            }
+      for (int j = 0; j < n; ++j) {
+        for (int i = 0; i < n; ++i) {
+          if (i != j) {
+            out_degrees(i, l) += net(i, j);
+            in_degrees(j, l) += net(i, j);
+            total += net(i, j);
           }
         }
       }
-
-      if (include_diagonal) {
-        mew = mew / double(number_of_nodes * number_of_nodes);
+      densities[l] = total / double(n * (n - 1));
+      if (calculate_modularity) {
+        modularities[l] = weighted_modularity(net, memberships, undirected);
       } else {
-        mew = mew / double(number_of_nodes * (number_of_nodes - 1));
+        modularities[l] = NA_REAL;
       }
-      Mean_Edge_Weights[MH_Counter] = mew;
-      Storage_Counter = 0;
-      MH_Counter += 1;
     }
   }
+};
 
-  // Save the data and then return
-  to_return[0] = Accept_or_Reject;
-  to_return[1] = Network_Samples;
-  to_return[2] = Save_H_Statistics;
-  to_return[3] = Mean_Edge_Weights;
-  to_return[4] = Log_Prob_Accept;
-  to_return[5] = P_Ratios;
-  to_return[6] = Q_Ratios;
-  to_return[7] = Proposed_Density;
-  to_return[8] = Current_Density;
+} // end of gergm namespace
+
+
+// Statistics for every network in a cube: the h statistics laid out as in
+// GERGM_Model_h_statistics (one row per network, if calculate_statistics),
+// out- and in-degrees (one column per network), densities and, if
+// calculate_modularity, modularity for the given memberships.
+// [[Rcpp::export]]
+List GERGM_Model_Network_Cube_Statistics (SEXP model,
+                                          arma::cube networks,
+                                          bool calculate_statistics,
+                                          arma::vec memberships,
+                                          bool calculate_modularity) {
+
+  Rcpp::XPtr<gergm::GergmModel> compiled_model(model);
+  int number_of_networks = networks.n_slices;
+  int number_of_nodes = networks.n_rows;
+  int statistics_to_save = 0;
+  if (calculate_statistics) {
+    statistics_to_save = compiled_model->combined_statistics_to_use.n_elem;
+  }
+
+  Rcpp::NumericMatrix Statistics(number_of_networks, statistics_to_save);
+  Rcpp::NumericMatrix Out_Degrees(number_of_nodes, number_of_networks);
+  Rcpp::NumericMatrix In_Degrees(number_of_nodes, number_of_networks);
+  Rcpp::NumericVector Densities(number_of_networks);
+  Rcpp::NumericVector Modularities(number_of_networks);
+
+  gergm::Parallel_Network_Cube_Statistics Parallel_Network_Cube_Statistics(
+    *compiled_model,
+    networks,
+    memberships,
+    calculate_statistics,
+    calculate_modularity,
+    compiled_model->undirect_network == 1,
+    Statistics,
+    Out_Degrees,
+    In_Degrees,
+    Densities,
+    Modularities);
+
+  RcppParallel::parallelFor(0,
+                            number_of_networks,
+                            Parallel_Network_Cube_Statistics);
+
+  List to_return(5);
+  to_return[0] = Statistics;
+  to_return[1] = Out_Degrees;
+  to_return[2] = In_Degrees;
+  to_return[3] = Densities;
+  to_return[4] = Modularities;
   return to_return;
 }
 
@@ -2477,10 +1001,8 @@ List Individual_Edge_Conditional_Prediction (
     int num_non_base_statistics,
     arma::vec non_base_statistic_indicator,
     double p_ratio_multaplicative_factor,
-    Rcpp::List random_triad_sample_list,
-    Rcpp::List random_dyad_sample_list,
+    double stochastic_MH_proportion,
     bool use_triad_sampling,
-    int num_unique_random_triad_samples,
     int i,
     int j) {
 
@@ -2495,7 +1017,7 @@ List Individual_Edge_Conditional_Prediction (
 
   int MH_Counter = 0;
   int Storage_Counter = 0;
-  bool network_did_not_change = false;
+  bool current_h_value_is_cached = false;
   double previous_h_function_value = 0;
   arma::vec Accept_or_Reject = arma::zeros (number_of_iterations);
   arma::vec Log_Prob_Accept = arma::zeros (number_of_iterations);
@@ -2510,143 +1032,85 @@ List Individual_Edge_Conditional_Prediction (
                                              statistics_to_save);
   arma::mat current_edge_weights = initial_network;
   arma::mat corr_current_edge_weights = arma::zeros (number_of_nodes, number_of_nodes);
+  double current_log_jacobian = 0;
 
   // values for stochastic MH
   arma::Mat<double> random_triad_samples(2,2);
   arma::Mat<double> random_dyad_samples(2,2);
   int update_triad_samples_every = 10;
   int triad_sample_update_counter = 0;
-  int random_triad_sample_counter = 0;
+  // the subsamples get their own stream so that the proposals are the same
+  // whether or not we are using stochastic MH.
+  std::seed_seq triad_sample_seed{seed, 1};
+  std::mt19937 triad_sample_generator(triad_sample_seed);
+  bool diagonal_triples = gergm::triples_include_diagonal(number_of_nodes,
+                                                         triples);
   if (use_triad_sampling) {
-    arma::Mat<double> temp = random_triad_sample_list[random_triad_sample_counter];
-    random_triad_samples = temp;
-    arma::Mat<double> temp2 = random_dyad_sample_list[random_triad_sample_counter];
-    random_dyad_samples = temp2;
-    random_triad_sample_counter += 1;
+    gergm::draw_random_triad_samples(number_of_nodes,
+                                     stochastic_MH_proportion,
+                                     diagonal_triples,
+                                     triad_sample_generator,
+                                     random_triad_samples,
+                                     random_dyad_samples);
   }
 
   // deal with the case where we have a correlation network.
   if(using_correlation_network == 1){
     current_edge_weights.diag() = arma::ones(number_of_nodes);
     undirect_network = 1;
+    // cache the correlation space network and its log Jacobian, these are
+    // only refreshed when a proposal is accepted.
+    corr_current_edge_weights = gergm::bounded_to_correlations(current_edge_weights);
+    current_log_jacobian = vine::log_jacobian(2*current_edge_weights-1);
   }
 
 
   // Set RNG and define uniform distribution
-  boost::mt19937 generator(seed);
-  boost::uniform_01<double> uniform_distribution;
+  std::mt19937 generator(seed);
+  gergm::random::uniform_01<double> uniform_distribution;
+  // the proposal is kept equal to the current network outside of the (i,j)
+  // and (j,i) entries, which are logged so they can be accepted or undone.
+  arma::mat proposed_edge_weights = current_edge_weights;
+  gergm::EdgeUndoLog proposal_log(2);
   // Outer loop over the number of samples
   for (int n = 0; n < number_of_iterations; ++n) {
     //Rcpp::Rcout << "Iteration: " << n << std::endl;
     double log_prob_accept = 0;
-    arma::mat proposed_edge_weights = current_edge_weights;
 
-    // deal with the case where we have an undirected network.
+    // only edge (i,j) is resampled
+    double new_edge_value = gergm::propose_edge_value(current_edge_weights(i,j),
+                                                      variance,
+                                                      generator,
+                                                      log_prob_accept);
+    proposal_log.set(proposed_edge_weights, i, j, new_edge_value);
     if(undirect_network == 1){
-      // Run loop to sample new edge weights
-
-      double log_probability_of_current_under_new = 0;
-      double log_probability_of_new_under_current = 0;
-      //draw a new edge value centered at the old edge value
-      double current_edge_value = current_edge_weights(i,j);
-      //draw from a truncated normal
-      gergm::normal_distribution<double> proposal(current_edge_value,variance);
-      int in_zero_one = 0;
-      //NumericVector new_edge_value = 0.5;
-      double new_edge_value = 0.5;
-      while(in_zero_one == 0){
-        new_edge_value = proposal(generator);
-        if((new_edge_value > 0) & (new_edge_value < 1)){
-          in_zero_one = 1;
-        }
-      }
-      // calculate the probability of the new edge under current beta dist
-      double lower_bound = R::pnorm(0,current_edge_value,variance, 1, 0);
-      double upper_bound = R::pnorm(1,current_edge_value,variance, 1, 0);
-      double raw_prob = R::dnorm(new_edge_value,current_edge_value,variance,0);
-      double prob_new_edge_under_old = (raw_prob/(upper_bound - lower_bound));
-      // calculate the probability of the current edge under new beta dist
-      lower_bound = R::pnorm(0,new_edge_value,variance, 1, 0);
-      upper_bound = R::pnorm(1,new_edge_value,variance, 1, 0);
-      raw_prob = R::dnorm(current_edge_value,new_edge_value,variance,0);
-      double prob_old_edge_under_new = (raw_prob/(upper_bound - lower_bound));
-      //save everything
-      proposed_edge_weights(i,j) = new_edge_value;
-      proposed_edge_weights(j,i) = new_edge_value;
-      log_probability_of_new_under_current = log(prob_new_edge_under_old);
-      log_probability_of_current_under_new = log(prob_old_edge_under_new);
-
-      // Calculate acceptance probability
-      log_prob_accept += (log_probability_of_current_under_new
-                            - log_probability_of_new_under_current);
-
-    }else{
-      // int counter =  0;
-      // Run loop to sample new edge weights
-      double log_probability_of_current_under_new = 0;
-      double log_probability_of_new_under_current = 0;
-      //draw a new edge value centered at the old edge value
-      double current_edge_value = current_edge_weights(i,j);
-      //draw from a truncated normal
-      gergm::normal_distribution<double> proposal(current_edge_value,variance);
-      int in_zero_one = 0;
-      //NumericVector new_edge_value = 0.5;
-      double new_edge_value = 0.5;
-      while(in_zero_one == 0){
-        new_edge_value = proposal(generator);
-        if((new_edge_value > 0) & (new_edge_value < 1)){
-          in_zero_one = 1;
-        }
-      }
-
-      // calculate the probability of the new edge under current beta dist
-      double lower_bound = R::pnorm(0,current_edge_value,variance, 1, 0);
-      double upper_bound = R::pnorm(1,current_edge_value,variance, 1, 0);
-      double raw_prob = R::dnorm(new_edge_value,current_edge_value,variance,0);
-      double prob_new_edge_under_old = (raw_prob/(upper_bound - lower_bound));
-
-      // calculate the probability of the current edge under new beta dist
-      lower_bound = R::pnorm(0,new_edge_value,variance, 1, 0);
-      upper_bound = R::pnorm(1,new_edge_value,variance, 1, 0);
-      raw_prob = R::dnorm(current_edge_value,new_edge_value,variance,0);
-      double prob_old_edge_under_new = (raw_prob/(upper_bound - lower_bound));
-
-      //save everything
-      proposed_edge_weights(i,j) = new_edge_value;
-      log_probability_of_new_under_current = log(prob_new_edge_under_old);
-      log_probability_of_current_under_new = log(prob_old_edge_under_new);
-
-      // Calculate acceptance probability
-      log_prob_accept += (log_probability_of_current_under_new
-                            - log_probability_of_new_under_current);
-    } //end of condition for whether we are using a correlation network
+      proposal_log.set(proposed_edge_weights, j, i, new_edge_value);
+    }
 
     double proposed_addition = 0;
     double current_addition = 0;
+    arma::mat corr_proposed_edge_weights;
+    double proposed_log_jacobian = 0;
 
-    // if we are using random triad sampling, then extract the appropriate
-    // triples and pairs matrices
+    // if we are using random triad sampling, then draw fresh triples and
+    // pairs to use
     if (update_triad_samples_every == triad_sample_update_counter) {
       if (use_triad_sampling) {
-        arma::Mat<double> temp = random_triad_sample_list[random_triad_sample_counter];
-        random_triad_samples = temp;
-        arma::Mat<double> temp2 = random_dyad_sample_list[random_triad_sample_counter];
-        random_dyad_samples = temp2;
+        gergm::draw_random_triad_samples(number_of_nodes,
+                                         stochastic_MH_proportion,
+                                         diagonal_triples,
+                                         triad_sample_generator,
+                                         random_triad_samples,
+                                         random_dyad_samples);
+        // the cached h value was calculated on the old subsample
+        current_h_value_is_cached = false;
       }
       triad_sample_update_counter = 0;
-      // increment the random sample counter
-      random_triad_sample_counter += 1;
-      // if it is equal to the number of different samples we are working with,
-      // then reset it
-      if (num_unique_random_triad_samples == random_triad_sample_counter) {
-        random_triad_sample_counter = 0;
-      }
     }
     triad_sample_update_counter += 1;
 
     if(using_correlation_network == 1){
-      arma::mat corr_proposed_edge_weights = gergm::bounded_to_correlations(proposed_edge_weights);
-      arma::mat corr_current_edge_weights = gergm::bounded_to_correlations(current_edge_weights);
+      corr_proposed_edge_weights = gergm::bounded_to_correlations(proposed_edge_weights);
       proposed_addition = gergm::CalculateNetworkStatistics(
         corr_proposed_edge_weights,
         statistics_to_use,
@@ -2661,24 +1125,29 @@ List Individual_Edge_Conditional_Prediction (
         non_base_statistic_indicator,
         random_triad_samples,
         random_dyad_samples,
-        use_triad_sampling);
-
-      current_addition = gergm::CalculateNetworkStatistics(
-        corr_current_edge_weights,
-        statistics_to_use,
-        thetas,
-        triples,
-        pairs,
-        alphas,
-        together,
-        parallel,
-        use_selected_rows,
-        rows_to_use,
-        non_base_statistic_indicator,
-        random_triad_samples,
-        random_dyad_samples,
-        use_triad_sampling);
-
+        use_triad_sampling,
+        false);
+      if (current_h_value_is_cached) {
+        current_addition = previous_h_function_value;
+      } else {
+        current_addition = gergm::CalculateNetworkStatistics(
+          corr_current_edge_weights,
+          statistics_to_use,
+          thetas,
+          triples,
+          pairs,
+          alphas,
+          together,
+          parallel,
+          use_selected_rows,
+          rows_to_use,
+          non_base_statistic_indicator,
+          random_triad_samples,
+          random_dyad_samples,
+          use_triad_sampling,
+          false);
+        previous_h_function_value = current_addition ;
+      }
     }else{
       proposed_addition = gergm::CalculateNetworkStatistics(
         proposed_edge_weights,
@@ -2694,10 +1163,11 @@ List Individual_Edge_Conditional_Prediction (
         non_base_statistic_indicator,
         random_triad_samples,
         random_dyad_samples,
-        use_triad_sampling);
+        use_triad_sampling,
+        false);
       // only calculate the h function if we updated the network last round
       // otherwise use the cached value.
-      if (network_did_not_change) {
+      if (current_h_value_is_cached) {
         current_addition = previous_h_function_value;
       } else {
         current_addition = gergm::CalculateNetworkStatistics(
@@ -2714,7 +1184,8 @@ List Individual_Edge_Conditional_Prediction (
           non_base_statistic_indicator,
           random_triad_samples,
           random_dyad_samples,
-          use_triad_sampling);
+          use_triad_sampling,
+          false);
         previous_h_function_value = current_addition ;
       }
     }
@@ -2736,10 +1207,13 @@ List Individual_Edge_Conditional_Prediction (
       current_addition);
 
     if(using_correlation_network == 1){
-      // now add in the bit about Jacobians
-      double numerator = log(gergm::jacobian(2*proposed_edge_weights-1));
-      double denominator = log(gergm::jacobian(2*current_edge_weights-1));
-      log_prob_accept += numerator - denominator;
+      // now add in the bit about Jacobians, only the (i,j) partial correlation
+      // changes so we can just update the cached value.
+      proposed_log_jacobian = current_log_jacobian + vine::log_jacobian_delta(
+        number_of_nodes, i, j,
+        2*current_edge_weights(i,j) - 1,
+        2*proposed_edge_weights(i,j) - 1);
+      log_prob_accept += proposed_log_jacobian - current_log_jacobian;
     }
 
     double rand_num = uniform_distribution(generator);
@@ -2750,19 +1224,21 @@ List Individual_Edge_Conditional_Prediction (
     // Accept or reject the new proposed positions
     if (log_prob_accept < lud) {
       accept_proportion +=0;
-      network_did_not_change = true;
+      current_h_value_is_cached = true;
+      proposal_log.undo(proposed_edge_weights);
     } else {
       accept_proportion +=1;
-      network_did_not_change = false;
-      for (int i = 0; i < number_of_nodes; ++i) {
-        for (int j = 0; j < number_of_nodes; ++j) {
-          if (i != j) {
-            double temp = proposed_edge_weights(i, j);
-            current_edge_weights(i, j) = temp;
-          }
-        }
+      // the proposed network becomes the current one, so carry its h value
+      // (and correlation space quantities) over rather than recomputing them.
+      current_h_value_is_cached = true;
+      previous_h_function_value = proposed_addition;
+      if(using_correlation_network == 1){
+        corr_current_edge_weights.swap(corr_proposed_edge_weights);
+        current_log_jacobian = proposed_log_jacobian;
       }
+      proposal_log.apply(proposed_edge_weights, current_edge_weights);
     }
+    proposal_log.clear();
 
     Log_Prob_Accept[n] = log_prob_accept;
     Accept_or_Reject[n] = accept_proportion;
@@ -2772,7 +1248,6 @@ List Individual_Edge_Conditional_Prediction (
     if (Storage_Counter == take_sample_every) {
       //Rcpp::Rcout << "Iteration: " << n << std::endl;
       if(using_correlation_network == 1){
-        arma::mat corr_current_edge_weights = gergm::bounded_to_correlations(current_edge_weights);
         arma::vec save_stats = gergm::save_network_statistics(
           corr_current_edge_weights,
           statistics_to_use,
@@ -2810,10 +1285,6 @@ List Individual_Edge_Conditional_Prediction (
 
 
       double mew = 0;
-      if(using_correlation_network == 1){
-        corr_current_edge_weights = gergm::bounded_to_correlations(current_edge_weights);
-      }
-
       for (int i = 0; i < number_of_nodes; ++i) {
         for (int j = 0; j < number_of_nodes; ++j) {
           if (i != j) {
@@ -2853,6 +1324,393 @@ List Individual_Edge_Conditional_Prediction (
 }
 
 
+namespace gergm {
+
+// Coefficient of w_{i,j} in the (un-exponentiated) sum behind a base
+// statistic, holding every other edge fixed. Each term that contains w_{i,j}
+// is linear in it, so moving w_{i,j} from a to b changes the sum by
+// (b - a) * coefficient when together == 1, and the statistic by
+// (b^alpha - a^alpha) * coefficient when together == 0 (in which case the
+// other edges enter raised to alpha). The third node k ranges over the
+// number_of_set_nodes entries of nodes, which is every node for a base
+// statistic and the node subset for a non-base statistic (the caller checks
+// that i and j are themselves in the subset), so this is O(subset size).
+double edge_change_coefficient(const arma::mat& net,
+                               int i,
+                               int j,
+                               const arma::uword* nodes,
+                               int number_of_set_nodes,
+                               int base_statistic_index,
+                               double alpha,
+                               int together) {
+  if (i == j) {
+    return 0;
+  }
+  double power = 1;
+  if (together == 0) {
+    power = alpha;
+  }
+  double coefficient = 0;
+  switch (base_statistic_index) {
+  case 0:
+    for (int m = 0; m < number_of_set_nodes; ++m) {
+      int k = nodes[m];
+      if (k != i && k != j) {
+        coefficient += pow(net(i, k), power);
+      }
+    }
+    break;
+  case 1:
+    for (int m = 0; m < number_of_set_nodes; ++m) {
+      int k = nodes[m];
+      if (k != i && k != j) {
+        coefficient += pow(net(k, j), power);
+      }
+    }
+    break;
+  case 2:
+    for (int m = 0; m < number_of_set_nodes; ++m) {
+      int k = nodes[m];
+      if (k != i && k != j) {
+        coefficient += pow(net(j, k), power) * pow(net(k, i), power);
+      }
+    }
+    break;
+  case 3:
+    coefficient = pow(net(j, i), power);
+    break;
+  case 4:
+    for (int m = 0; m < number_of_set_nodes; ++m) {
+      int k = nodes[m];
+      if (k != i && k != j) {
+        coefficient += pow(net(j, k), power) * pow(net(i, k), power) +
+          pow(net(k, j), power) * pow(net(k, i), power) +
+          pow(net(k, j), power) * pow(net(i, k), power);
+      }
+    }
+    break;
+  case 5:
+    coefficient = 1;
+    break;
+  }
+  return coefficient;
+}
+
+// Precompute the node set behind each statistic for edge_change_coefficient().
+// Column s of node_sets holds the node_set_sizes[s] nodes statistic s ranges
+// over and in_node_set(k, s) is 1 if node k is one of them. Base statistics
+// use every node. Node subsets are read off the nodes that appear in the
+// statistic's selected rows of triples (or pairs).
+void build_statistic_node_sets(int number_of_nodes,
+                               const arma::vec& statistics_to_use,
+                               const arma::Mat<double>& triples,
+                               const arma::Mat<double>& pairs,
+                               const arma::umat& use_selected_rows,
+                               const arma::vec& rows_to_use,
+                               const arma::vec& non_base_statistic_indicator,
+                               arma::umat& node_sets,
+                               arma::uvec& node_set_sizes,
+                               arma::umat& in_node_set) {
+  int number_of_thetas = statistics_to_use.n_elem;
+  node_sets = arma::zeros<arma::umat>(number_of_nodes, number_of_thetas);
+  node_set_sizes = arma::zeros<arma::uvec>(number_of_thetas);
+  in_node_set = arma::zeros<arma::umat>(number_of_nodes, number_of_thetas);
+  for (int s = 0; s < number_of_thetas; ++s) {
+    if (non_base_statistic_indicator[s] == 1) {
+      int stat = int(statistics_to_use[s]);
+      const arma::Mat<double>& rows = (stat == 3 || stat == 5) ? pairs : triples;
+      int number_of_rows = int(rows_to_use[s]) + 1;
+      for (int r = 0; r < number_of_rows; ++r) {
+        arma::uword row = use_selected_rows(r, s);
+        for (arma::uword c = 0; c < rows.n_cols; ++c) {
+          in_node_set(arma::uword(rows(row, c)), s) = 1;
+        }
+      }
+    } else {
+      in_node_set.col(s).ones();
+    }
+    for (int k = 0; k < number_of_nodes; ++k) {
+      if (in_node_set(k, s) == 1) {
+        node_sets(node_set_sizes[s], s) = k;
+        node_set_sizes[s] += 1;
+      }
+    }
+  }
+}
+
+// Runs one single edge MH chain per dyad, with the rest of the network held
+// fixed at its initial value. Since only w_{i,j} (and w_{j,i} for undirected
+// networks) moves, the change in each statistic is a function of the edge
+// value alone, so every MH step is O(number of statistics) after an O(n)
+// setup per dyad.
+struct Parallel_Edge_Conditional_Prediction : public RcppParallel::Worker {
+
+  arma::mat network;
+  arma::vec statistics_to_use;
+  arma::vec thetas;
+  arma::vec alphas;
+  arma::vec statistic_sums;
+  arma::umat node_sets;
+  arma::uvec node_set_sizes;
+  arma::umat in_node_set;
+  arma::umat dyads;
+  int number_of_nodes;
+  int number_of_iterations;
+  int take_sample_every;
+  int number_of_samples_to_store;
+  int together;
+  int undirect_network;
+  double variance;
+  int seed;
+  RcppParallel::RMatrix<double> edge_samples;
+  RcppParallel::RVector<double> accept_rates;
+
+  Parallel_Edge_Conditional_Prediction(arma::mat network,
+                                       arma::vec statistics_to_use,
+                                       arma::vec thetas,
+                                       arma::vec alphas,
+                                       arma::vec statistic_sums,
+                                       arma::umat node_sets,
+                                       arma::uvec node_set_sizes,
+                                       arma::umat in_node_set,
+                                       arma::umat dyads,
+                                       int number_of_nodes,
+                                       int number_of_iterations,
+                                       int take_sample_every,
+                                       int number_of_samples_to_store,
+                                       int together,
+                                       int undirect_network,
+                                       double variance,
+                                       int seed,
+                                       Rcpp::NumericMatrix edge_samples,
+                                       Rcpp::NumericVector accept_rates)
+    : network(network),
+      statistics_to_use(statistics_to_use),
+      thetas(thetas),
+      alphas(alphas),
+      statistic_sums(statistic_sums),
+      node_sets(node_sets),
+      node_set_sizes(node_set_sizes),
+      in_node_set(in_node_set),
+      dyads(dyads),
+      number_of_nodes(number_of_nodes),
+      number_of_iterations(number_of_iterations),
+      take_sample_every(take_sample_every),
+      number_of_samples_to_store(number_of_samples_to_store),
+      together(together),
+      undirect_network(undirect_network),
+      variance(variance),
+      seed(seed),
+      edge_samples(edge_samples),
+      accept_rates(accept_rates) {}
+
+  void operator()(std::size_t begin, std::size_t end) {
+    int number_of_thetas = statistics_to_use.n_elem;
+    arma::vec linear = arma::zeros(number_of_thetas);
+    arma::vec quadratic = arma::zeros(number_of_thetas);
+    arma::vec sums = arma::zeros(number_of_thetas);
+
+    for (std::size_t d = begin; d < end; d++) {
+      int i = dyads(d, 0);
+      int j = dyads(d, 1);
+
+      // each dyad gets its own stream, so results do not depend on how the
+      // dyads are split across threads.
+      std::seed_seq stream_seed{seed, int(d)};
+      std::mt19937 generator(stream_seed);
+      gergm::random::uniform_01<double> uniform_distribution;
+
+      for (int s = 0; s < number_of_thetas; ++s) {
+        int stat = int(statistics_to_use[s]);
+        sums[s] = statistic_sums[s];
+        quadratic[s] = 0;
+        if (stat == 6) {
+          // the diagonal statistic is just the sum of the diagonal
+          linear[s] = (i == j) ? 1 : 0;
+          continue;
+        }
+        // an edge outside of a statistic's node subset does not enter it
+        if (in_node_set(i, s) == 0 || in_node_set(j, s) == 0) {
+          linear[s] = 0;
+          continue;
+        }
+        const arma::uword* nodes = node_sets.colptr(s);
+        int number_of_set_nodes = node_set_sizes[s];
+        linear[s] = gergm::edge_change_coefficient(network, i, j, nodes,
+          number_of_set_nodes, stat, alphas[s], together);
+        if (undirect_network == 1) {
+          if (stat == 3) {
+            // w_ij * w_ji = x^2 when both move together
+            linear[s] = 0;
+            quadratic[s] = (i == j) ? 0 : 1;
+          } else {
+            linear[s] += gergm::edge_change_coefficient(network, j, i, nodes,
+              number_of_set_nodes, stat, alphas[s], together);
+          }
+        }
+      }
+
+      double current_edge_value = network(i, j);
+      double accepted = 0;
+      int Storage_Counter = 0;
+      int Sample_Counter = 0;
+      for (int n = 0; n < number_of_iterations; ++n) {
+        //draw a new edge value centered at the old edge value
+        double log_prob_accept = 0;
+        double new_edge_value = gergm::propose_edge_value(current_edge_value,
+                                                          variance,
+                                                          generator,
+                                                          log_prob_accept);
+
+        // change in theta' h
+        for (int s = 0; s < number_of_thetas; ++s) {
+          double change = 0;
+          if (int(statistics_to_use[s]) == 6) {
+            change = linear[s] * (new_edge_value - current_edge_value);
+          } else if (together == 1) {
+            double new_sum = sums[s] +
+              linear[s] * (new_edge_value - current_edge_value) +
+              quadratic[s] * (new_edge_value * new_edge_value -
+              current_edge_value * current_edge_value);
+            change = pow(new_sum, alphas[s]) - pow(sums[s], alphas[s]);
+          } else {
+            change = linear[s] * (pow(new_edge_value, alphas[s]) -
+              pow(current_edge_value, alphas[s])) +
+              quadratic[s] * (pow(new_edge_value, 2 * alphas[s]) -
+              pow(current_edge_value, 2 * alphas[s]));
+          }
+          log_prob_accept += thetas[s] * change;
+        }
+
+        double lud = log(uniform_distribution(generator));
+        if (log_prob_accept >= lud) {
+          if (together == 1) {
+            for (int s = 0; s < number_of_thetas; ++s) {
+              sums[s] += linear[s] * (new_edge_value - current_edge_value) +
+                quadratic[s] * (new_edge_value * new_edge_value -
+                current_edge_value * current_edge_value);
+            }
+          }
+          current_edge_value = new_edge_value;
+          accepted += 1;
+        }
+
+        Storage_Counter += 1;
+        if (Storage_Counter == take_sample_every) {
+          if (Sample_Counter < number_of_samples_to_store) {
+            edge_samples(d, Sample_Counter) = current_edge_value;
+          }
+          Storage_Counter = 0;
+          Sample_Counter += 1;
+        }
+      }
+      accept_rates[d] = accepted / double(number_of_iterations);
+    }
+  }
+};
+
+} //end of gergm namespace
+
+// [[Rcpp::export]]
+List Batch_Edge_Conditional_Prediction (
+    int number_of_iterations,
+    double shape_parameter,
+    int number_of_nodes,
+    arma::vec statistics_to_use,
+    arma::mat initial_network,
+    int take_sample_every,
+    arma::vec thetas,
+    arma::Mat<double> triples,
+    arma::Mat<double> pairs,
+    arma::vec alphas,
+    int together,
+    int seed,
+    int number_of_samples_to_store,
+    int undirect_network,
+    arma::umat use_selected_rows,
+    arma::vec rows_to_use,
+    arma::vec non_base_statistic_indicator,
+    arma::umat dyads) {
+
+  // the list we will put stuff in to return it to R
+  int list_length = 2;
+  List to_return(list_length);
+  int number_of_dyads = dyads.n_rows;
+  int number_of_thetas = statistics_to_use.n_elem;
+
+  // the sums behind each statistic on the initial network, these are only
+  // needed when the weights are applied outside of the sum.
+  arma::vec statistic_sums = arma::zeros(number_of_thetas);
+  if (together == 1) {
+    arma::Mat<double> no_samples(2, 2);
+    for (int s = 0; s < number_of_thetas; ++s) {
+      statistic_sums[s] = gergm::get_individual_statistic_value(
+        initial_network,
+        statistics_to_use,
+        s,
+        triples,
+        pairs,
+        1,
+        1,
+        use_selected_rows,
+        rows_to_use,
+        non_base_statistic_indicator,
+        no_samples,
+        no_samples,
+        false,
+        false);
+    }
+  }
+
+  arma::umat node_sets;
+  arma::uvec node_set_sizes;
+  arma::umat in_node_set;
+  gergm::build_statistic_node_sets(number_of_nodes,
+                                   statistics_to_use,
+                                   triples,
+                                   pairs,
+                                   use_selected_rows,
+                                   rows_to_use,
+                                   non_base_statistic_indicator,
+                                   node_sets,
+                                   node_set_sizes,
+                                   in_node_set);
+
+  Rcpp::NumericMatrix Edge_Samples(number_of_dyads, number_of_samples_to_store);
+  Rcpp::NumericVector Accept_Rates(number_of_dyads);
+
+  gergm::Parallel_Edge_Conditional_Prediction Parallel_Edge_Conditional_Prediction(
+    initial_network,
+    statistics_to_use,
+    thetas,
+    alphas,
+    statistic_sums,
+    node_sets,
+    node_set_sizes,
+    in_node_set,
+    dyads,
+    number_of_nodes,
+    number_of_iterations,
+    take_sample_every,
+    number_of_samples_to_store,
+    together,
+    undirect_network,
+    shape_parameter,
+    seed,
+    Edge_Samples,
+    Accept_Rates);
+
+  RcppParallel::parallelFor(0,
+                            number_of_dyads,
+                            Parallel_Edge_Conditional_Prediction);
+
+  // Save the data and then return
+  to_return[0] = Edge_Samples;
+  to_return[1] = Accept_Rates;
+  return to_return;
+}
+
+
 
 
 // [[Rcpp::export]]
@@ -2878,16 +1736,16 @@ List Distribution_Metropolis_Hastings_Sampler (int number_of_iterations,
                                            int num_non_base_statistics,
                                            arma::vec non_base_statistic_indicator,
                                            double p_ratio_multaplicative_factor,
-                                           Rcpp::List random_triad_sample_list,
-                                           Rcpp::List random_dyad_sample_list,
+                                           double stochastic_MH_proportion,
                                            bool use_triad_sampling,
-                                           int num_unique_random_triad_samples,
                                            bool rowwise_distribution) {
 
   // Allocate variables and data structures
   // the list we will put stuff in to return it to R
-  int list_length = 9;
+  int list_length = 10;
   List to_return(list_length);
+  // only filled in when compiled with GERGM_PROFILE
+  gergm::SamplerProfile profile;
   // this is the number of statistics we will be saving (all selected base + non base)
   int statistics_to_save = num_non_base_statistics +
     base_statistics_to_save.n_elem;
@@ -2915,24 +1773,37 @@ List Distribution_Metropolis_Hastings_Sampler (int number_of_iterations,
   arma::Mat<double> random_dyad_samples(2,2);
   int update_triad_samples_every = 10;
   int triad_sample_update_counter = 0;
-  int random_triad_sample_counter = 0;
+  // the subsamples get their own stream so that the proposals are the same
+  // whether or not we are using stochastic MH.
+  std::seed_seq triad_sample_seed{seed, 1};
+  std::mt19937 triad_sample_generator(triad_sample_seed);
+  bool diagonal_triples = gergm::triples_include_diagonal(number_of_nodes,
+                                                         triples);
   if (use_triad_sampling) {
-    arma::Mat<double> temp = random_triad_sample_list[random_triad_sample_counter];
-    random_triad_samples = temp;
-    arma::Mat<double> temp2 = random_dyad_sample_list[random_triad_sample_counter];
-    random_dyad_samples = temp2;
-    random_triad_sample_counter += 1;
+    gergm::draw_random_triad_samples(number_of_nodes,
+                                     stochastic_MH_proportion,
+                                     diagonal_triples,
+                                     triad_sample_generator,
+                                     random_triad_samples,
+                                     random_dyad_samples);
   }
 
   // Set RNG and define uniform distribution
-  boost::mt19937 generator(seed);
-  boost::uniform_01<double> uniform_distribution;
+  std::mt19937 generator(seed);
+  gergm::random::uniform_01<double> uniform_distribution;
+  // the proposal buffer is reused across iterations, and swapped with the
+  // current network on accept
+  arma::mat proposed_edge_weights(number_of_nodes, number_of_nodes);
   // Outer loop over the number of samples
   for (int n = 0; n < number_of_iterations; ++n) {
     //Rcpp::Rcout << "Iteration: " << n << std::endl;
     double log_prob_accept = 0;
-    arma::mat proposed_edge_weights = current_edge_weights;
-    arma::mat current_edge_weights_for_updating = current_edge_weights;
+    GERGM_PROFILE_START(proposal);
+    // every pair is updated from the values already proposed for it, so the
+    // proposal starts from the current network
+    proposed_edge_weights = current_edge_weights;
+    GERGM_PROFILE_COUNT(profile, bytes_copied,
+                        sizeof(double) * proposed_edge_weights.n_elem);
 
 
     if (rowwise_distribution) {
@@ -2940,12 +1811,9 @@ List Distribution_Metropolis_Hastings_Sampler (int number_of_iterations,
       for (int i = 0; i < number_of_nodes; ++i) {
         // go from the first entry to the second to last
         for (int j = 0; j < (number_of_nodes - 1); ++j) {
-            double log_probability_of_current_under_new = 0;
-            double log_probability_of_new_under_current = 0;
-
             //get the current and j+1 edge valeus
-            double edge1 = current_edge_weights_for_updating(i,j);
-            double edge2 = current_edge_weights_for_updating(i,j+1);
+            double edge1 = proposed_edge_weights(i,j);
+            double edge2 = proposed_edge_weights(i,j+1);
 
             //now get their sum and make them sum to one
             double cur_edge_sum = edge1 + edge2;
@@ -2953,43 +1821,14 @@ List Distribution_Metropolis_Hastings_Sampler (int number_of_iterations,
             // now represent the normalized first edge value
             double current_edge_value = edge1 / cur_edge_sum;
             //draw from a truncated normal
-            gergm::normal_distribution<double> proposal(current_edge_value,variance);
-            int in_zero_one = 0;
-            //NumericVector new_edge_value = 0.5;
-            double new_edge_value = 0.5;
-            while(in_zero_one == 0){
-              new_edge_value = proposal(generator);
-              if((new_edge_value > 0) & (new_edge_value < 1)){
-                in_zero_one = 1;
-              }
-            }
-
-            // calculate the probability of the new edge under current beta dist
-            double lower_bound = R::pnorm(0,current_edge_value,variance, 1, 0);
-            double upper_bound = R::pnorm(1,current_edge_value,variance, 1, 0);
-            double raw_prob = R::dnorm(new_edge_value,current_edge_value,variance,0);
-            double prob_new_edge_under_old = (raw_prob/(upper_bound - lower_bound));
-
-            // calculate the probability of the current edge under new beta dist
-            lower_bound = R::pnorm(0,new_edge_value,variance, 1, 0);
-            upper_bound = R::pnorm(1,new_edge_value,variance, 1, 0);
-            raw_prob = R::dnorm(current_edge_value,new_edge_value,variance,0);
-            double prob_old_edge_under_new = (raw_prob/(upper_bound - lower_bound));
+            double new_edge_value = gergm::propose_edge_value(
+              current_edge_value, variance, generator, log_prob_accept,
+              profile);
 
             //save everything
             // here we just need to revert the edge values
             proposed_edge_weights(i,j) = cur_edge_sum * new_edge_value;
             proposed_edge_weights(i,j+1) = cur_edge_sum * (1 - new_edge_value);
-
-            //update the current edgeweights to be used for the next pair
-            current_edge_weights_for_updating(i,j) = cur_edge_sum * new_edge_value;
-            current_edge_weights_for_updating(i,j+1) = cur_edge_sum * (1 - new_edge_value);
-            log_probability_of_new_under_current = log(prob_new_edge_under_old);
-            log_probability_of_current_under_new = log(prob_old_edge_under_new);
-
-            // Calculate acceptance probability
-            log_prob_accept += (log_probability_of_current_under_new
-                                  - log_probability_of_new_under_current);
           }
         }
     } else {
@@ -3002,18 +1841,15 @@ List Distribution_Metropolis_Hastings_Sampler (int number_of_iterations,
           if ((j == (number_of_nodes - 1)) & (i == (number_of_nodes - 1))) {
             // do nothing
           } else {
-            double log_probability_of_current_under_new = 0;
-            double log_probability_of_new_under_current = 0;
-
             //get the current and j+1 edge values, unless we are at teh end of a
             //row, then we get the first one from the next row.
-            double edge1 = current_edge_weights_for_updating(i,j);
+            double edge1 = proposed_edge_weights(i,j);
             double edge2 = 0;
             if (j < (number_of_nodes - 1)) {
-              edge2 = current_edge_weights_for_updating(i,j+1);
+              edge2 = proposed_edge_weights(i,j+1);
             } else {
               // the first entry in the next row
-              edge2 = current_edge_weights_for_updating(i+1,0);
+              edge2 = proposed_edge_weights(i+1,0);
             }
 
 
@@ -3023,76 +1859,45 @@ List Distribution_Metropolis_Hastings_Sampler (int number_of_iterations,
             // now represent the normalized first edge value
             double current_edge_value = edge1 / cur_edge_sum;
             //draw from a truncated normal
-            gergm::normal_distribution<double> proposal(current_edge_value,variance);
-            int in_zero_one = 0;
-            //NumericVector new_edge_value = 0.5;
-            double new_edge_value = 0.5;
-            while(in_zero_one == 0){
-              new_edge_value = proposal(generator);
-              if((new_edge_value > 0) & (new_edge_value < 1)){
-                in_zero_one = 1;
-              }
-            }
-
-            // calculate the probability of the new edge under current beta dist
-            double lower_bound = R::pnorm(0,current_edge_value,variance, 1, 0);
-            double upper_bound = R::pnorm(1,current_edge_value,variance, 1, 0);
-            double raw_prob = R::dnorm(new_edge_value,current_edge_value,variance,0);
-            double prob_new_edge_under_old = (raw_prob/(upper_bound - lower_bound));
-
-            // calculate the probability of the current edge under new beta dist
-            lower_bound = R::pnorm(0,new_edge_value,variance, 1, 0);
-            upper_bound = R::pnorm(1,new_edge_value,variance, 1, 0);
-            raw_prob = R::dnorm(current_edge_value,new_edge_value,variance,0);
-            double prob_old_edge_under_new = (raw_prob/(upper_bound - lower_bound));
+            double new_edge_value = gergm::propose_edge_value(
+              current_edge_value, variance, generator, log_prob_accept,
+              profile);
 
             //save everything
             // here we just need to revert the edge values
             proposed_edge_weights(i,j) = cur_edge_sum * new_edge_value;
-            current_edge_weights_for_updating(i,j) = cur_edge_sum * new_edge_value;
             if (j < (number_of_nodes - 1)) {
               proposed_edge_weights(i,j+1) = cur_edge_sum * (1 - new_edge_value);
-              current_edge_weights_for_updating(i,j+1) = cur_edge_sum * (1 - new_edge_value);
             } else {
               // the first entry in the next row
               proposed_edge_weights(i+1,0) = cur_edge_sum * (1 - new_edge_value);
-              current_edge_weights_for_updating(i+1,0) = cur_edge_sum * (1 - new_edge_value);
             }
-
-            log_probability_of_new_under_current = log(prob_new_edge_under_old);
-            log_probability_of_current_under_new = log(prob_old_edge_under_new);
-
-            // Calculate acceptance probability
-            log_prob_accept += (log_probability_of_current_under_new
-                                  - log_probability_of_new_under_current);
           }
         }
       }
     } // end of joint distribtuion conditional
+    GERGM_PROFILE_STOP(profile, proposal);
 
     double proposed_addition = 0;
     double current_addition = 0;
 
-    // if we are using random triad sampling, then extract the appropriate
-    // triples and pairs matrices
+    // if we are using random triad sampling, then draw fresh triples and
+    // pairs to use
     if (update_triad_samples_every == triad_sample_update_counter) {
       if (use_triad_sampling) {
-        arma::Mat<double> temp = random_triad_sample_list[random_triad_sample_counter];
-        random_triad_samples = temp;
-        arma::Mat<double> temp2 = random_dyad_sample_list[random_triad_sample_counter];
-        random_dyad_samples = temp2;
+        gergm::draw_random_triad_samples(number_of_nodes,
+                                         stochastic_MH_proportion,
+                                         diagonal_triples,
+                                         triad_sample_generator,
+                                         random_triad_samples,
+                                         random_dyad_samples);
       }
       triad_sample_update_counter = 0;
-      // increment the random sample counter
-      random_triad_sample_counter += 1;
-      // if it is equal to the number of different samples we are working with,
-      // then reset it
-      if (num_unique_random_triad_samples == random_triad_sample_counter) {
-        random_triad_sample_counter = 0;
-      }
     }
     triad_sample_update_counter += 1;
 
+    GERGM_PROFILE_START(statistic);
+    GERGM_PROFILE_COUNT(profile, statistic_evaluations, 1);
     proposed_addition = gergm::CalculateNetworkStatistics(
       proposed_edge_weights,
       statistics_to_use,
@@ -3107,12 +1912,14 @@ List Distribution_Metropolis_Hastings_Sampler (int number_of_iterations,
       non_base_statistic_indicator,
       random_triad_samples,
       random_dyad_samples,
-      use_triad_sampling);
+      use_triad_sampling,
+      false);
     // only calculate the h function if we updated the network last round
     // otherwise use the cached value.
     if (network_did_not_change) {
       current_addition = previous_h_function_value;
     } else {
+      GERGM_PROFILE_COUNT(profile, statistic_evaluations, 1);
       current_addition = gergm::CalculateNetworkStatistics(
         current_edge_weights,
         statistics_to_use,
@@ -3127,9 +1934,11 @@ List Distribution_Metropolis_Hastings_Sampler (int number_of_iterations,
         non_base_statistic_indicator,
         random_triad_samples,
         random_dyad_samples,
-        use_triad_sampling);
+        use_triad_sampling,
+        false);
       previous_h_function_value = current_addition ;
     }
+    GERGM_PROFILE_STOP(profile, statistic);
 
 
     // store some additional diagnostics h value is the last entry
@@ -3148,6 +1957,7 @@ List Distribution_Metropolis_Hastings_Sampler (int number_of_iterations,
     log_prob_accept += p_ratio_multaplicative_factor * (proposed_addition -
       current_addition);
 
+    GERGM_PROFILE_START(accept);
     double rand_num = uniform_distribution(generator);
     double lud = 0;
     lud = log(rand_num);
@@ -3160,20 +1970,18 @@ List Distribution_Metropolis_Hastings_Sampler (int number_of_iterations,
     } else {
       accept_proportion +=1;
       network_did_not_change = false;
-      for (int i = 0; i < number_of_nodes; ++i) {
-        for (int j = 0; j < number_of_nodes; ++j) {
-          double temp = proposed_edge_weights(i, j);
-          current_edge_weights(i, j) = temp;
-        }
-      }
+      current_edge_weights.swap(proposed_edge_weights);
     }
 
+    GERGM_PROFILE_STOP(profile, accept);
+
     Log_Prob_Accept[n] = log_prob_accept;
     Accept_or_Reject[n] = accept_proportion;
     Storage_Counter += 1;
 
     // Save network statistics
     if (Storage_Counter == take_sample_every) {
+      GERGM_PROFILE_START(storage);
 
       arma::vec save_stats = gergm::save_network_statistics(
         current_edge_weights,
@@ -3205,6 +2013,9 @@ List Distribution_Metropolis_Hastings_Sampler (int number_of_iterations,
 
       mew = mew / double(number_of_nodes * number_of_nodes);
       Mean_Edge_Weights[MH_Counter] = mew;
+      GERGM_PROFILE_STOP(profile, storage);
+      GERGM_PROFILE_COUNT(profile, bytes_copied,
+                          sizeof(double) * current_edge_weights.n_elem);
       Storage_Counter = 0;
       MH_Counter += 1;
     }
@@ -3220,6 +2031,8 @@ List Distribution_Metropolis_Hastings_Sampler (int number_of_iterations,
   to_return[6] = Q_Ratios;
   to_return[7] = Proposed_Density;
   to_return[8] = Current_Density;
+  // phase timings and counters, NULL unless compiled with GERGM_PROFILE
+  to_return[9] = GERGM_PROFILE_RESULT(profile, statistics_to_use);
   return to_return;
 }
 
@@ -3324,8 +2137,10 @@ List Edge_Group_MH_Sampler (int number_of_iterations,
   // Allocate variables and data structures
   double variance = shape_parameter;
   // the list we will put stuff in to return it to R
-  int list_length = 9;
+  int list_length = 10;
   List to_return(list_length);
+  // only filled in when compiled with GERGM_PROFILE
+  gergm::SamplerProfile profile;
   // this is the number of statistics we will be saving (all selected base + non base)
   int statistics_to_save = num_non_base_statistics +
     base_statistics_to_save.n_elem;
@@ -3359,13 +2174,17 @@ List Edge_Group_MH_Sampler (int number_of_iterations,
 
 
   // Set RNG and define uniform distribution
-  boost::mt19937 generator(seed);
-  boost::uniform_01<double> uniform_distribution;
+  std::mt19937 generator(seed);
+  gergm::random::uniform_01<double> uniform_distribution;
+  // the proposal is kept equal to the current network outside of the edges
+  // in the group, which are logged so they can be accepted or undone.
+  arma::mat proposed_edge_weights = current_edge_weights;
+  gergm::EdgeUndoLog proposal_log(2 * sample_edges_at_a_time);
   // Outer loop over the number of samples
   for (int n = 0; n < number_of_iterations; ++n) {
     //Rcpp::Rcout << "Iteration: " << n << std::endl;
     double log_prob_accept = 0;
-    arma::mat proposed_edge_weights = current_edge_weights;
+    GERGM_PROFILE_START(proposal);
 
     // loop over number of edges to sample
     for (int i = 0; i < sample_edges_at_a_time; ++i) {
@@ -3394,55 +2213,30 @@ List Edge_Group_MH_Sampler (int number_of_iterations,
       }
 
       // now do normal stuff:
-      double log_probability_of_current_under_new = 0;
-      double log_probability_of_new_under_current = 0;
       //draw a new edge value centered at the old edge value
-      double current_edge_value = current_edge_weights(row_ind,col_ind);
-      //draw from a truncated normal
-      gergm::normal_distribution<double> proposal(current_edge_value,variance);
-      int in_zero_one = 0;
-      //NumericVector new_edge_value = 0.5;
-      double new_edge_value = 0.5;
-      while(in_zero_one == 0){
-        new_edge_value = proposal(generator);
-        if((new_edge_value > 0) & (new_edge_value < 1)){
-          in_zero_one = 1;
-        }
-      }
-      // calculate the probability of the new edge under current beta dist
-      double lower_bound = R::pnorm(0,current_edge_value,variance, 1, 0);
-      double upper_bound = R::pnorm(1,current_edge_value,variance, 1, 0);
-      double raw_prob = R::dnorm(new_edge_value,current_edge_value,variance,0);
-      double prob_new_edge_under_old = (raw_prob/(upper_bound - lower_bound));
-      // calculate the probability of the current edge under new beta dist
-      lower_bound = R::pnorm(0,new_edge_value,variance, 1, 0);
-      upper_bound = R::pnorm(1,new_edge_value,variance, 1, 0);
-      raw_prob = R::dnorm(current_edge_value,new_edge_value,variance,0);
-      double prob_old_edge_under_new = (raw_prob/(upper_bound - lower_bound));
+      double new_edge_value = gergm::propose_edge_value(
+        current_edge_weights(row_ind,col_ind), variance, generator,
+        log_prob_accept, profile);
       //save everything
+      proposal_log.set(proposed_edge_weights, row_ind, col_ind,
+                       new_edge_value);
       if (undirect_network == 1) {
-        proposed_edge_weights(row_ind,col_ind) = new_edge_value;
-        proposed_edge_weights(col_ind,row_ind) = new_edge_value;
-      } else {
-        proposed_edge_weights(row_ind,col_ind) = new_edge_value;
+        proposal_log.set(proposed_edge_weights, col_ind, row_ind,
+                         new_edge_value);
       }
 
-      log_probability_of_new_under_current = log(prob_new_edge_under_old);
-      log_probability_of_current_under_new = log(prob_old_edge_under_new);
-
-      // Calculate acceptance probability
-      log_prob_accept += (log_probability_of_current_under_new
-                            - log_probability_of_new_under_current);
-
       //now increment col ind only;
       col_ind += 1;
 
     }
 
+    GERGM_PROFILE_STOP(profile, proposal);
+
     double proposed_addition = 0;
     double current_addition = 0;
 
-
+    GERGM_PROFILE_START(statistic);
+    GERGM_PROFILE_COUNT(profile, statistic_evaluations, 1);
     proposed_addition = gergm::CalculateNetworkStatistics(
       proposed_edge_weights,
       statistics_to_use,
@@ -3457,12 +2251,14 @@ List Edge_Group_MH_Sampler (int number_of_iterations,
       non_base_statistic_indicator,
       random_triad_samples,
       random_dyad_samples,
-      use_triad_sampling);
+      use_triad_sampling,
+      false);
     // only calculate the h function if we updated the network last round
     // otherwise use the cached value.
     if (network_did_not_change) {
       current_addition = previous_h_function_value;
     } else {
+      GERGM_PROFILE_COUNT(profile, statistic_evaluations, 1);
       current_addition = gergm::CalculateNetworkStatistics(
         current_edge_weights,
         statistics_to_use,
@@ -3477,9 +2273,11 @@ List Edge_Group_MH_Sampler (int number_of_iterations,
         non_base_statistic_indicator,
         random_triad_samples,
         random_dyad_samples,
-        use_triad_sampling);
+        use_triad_sampling,
+        false);
       previous_h_function_value = current_addition ;
     }
+    GERGM_PROFILE_STOP(profile, statistic);
 
 
     // store some additional diagnostics h value is the last entry
@@ -3501,6 +2299,7 @@ List Edge_Group_MH_Sampler (int number_of_iterations,
     log_prob_accept += p_ratio_multaplicative_factor * (proposed_addition -
       current_addition);
 
+    GERGM_PROFILE_START(accept);
     double rand_num = uniform_distribution(generator);
     double lud = 0;
     lud = log(rand_num);
@@ -3510,23 +2309,23 @@ List Edge_Group_MH_Sampler (int number_of_iterations,
     if (log_prob_accept < lud) {
       accept_proportion +=0;
       network_did_not_change = true;
+      proposal_log.undo(proposed_edge_weights);
     } else {
       accept_proportion +=1;
       network_did_not_change = false;
-      for (int i = 0; i < number_of_nodes; ++i) {
-        for (int j = 0; j < number_of_nodes; ++j) {
-          if (include_diagonal) {
-            double temp = proposed_edge_weights(i, j);
-            current_edge_weights(i, j) = temp;
-          } else {
-            if (i != j) {
-              double temp = proposed_edge_weights(i, j);
-              current_edge_weights(i, j) = temp;
-            }
-          }
-        }
+      // a group that wraps around the network also proposes (0,0), which is
+      // only kept if we model the diagonal
+      proposal_log.apply(proposed_edge_weights, current_edge_weights,
+                         include_diagonal);
+      if (!include_diagonal) {
+        proposal_log.apply(current_edge_weights, proposed_edge_weights);
       }
     }
+    GERGM_PROFILE_COUNT(profile, bytes_copied,
+                        sizeof(double) * proposal_log.size());
+    proposal_log.clear();
+
+    GERGM_PROFILE_STOP(profile, accept);
 
     Log_Prob_Accept[n] = log_prob_accept;
     Accept_or_Reject[n] = accept_proportion;
@@ -3534,6 +2333,7 @@ List Edge_Group_MH_Sampler (int number_of_iterations,
 
     // Save network statistics
     if (Storage_Counter == take_sample_every) {
+      GERGM_PROFILE_START(storage);
       //Rcpp::Rcout << "Iteration: " << n << std::endl;
 
       arma::vec save_stats = gergm::save_network_statistics(
@@ -3581,6 +2381,9 @@ List Edge_Group_MH_Sampler (int number_of_iterations,
         mew = mew / double(number_of_nodes * (number_of_nodes - 1));
       }
       Mean_Edge_Weights[MH_Counter] = mew;
+      GERGM_PROFILE_STOP(profile, storage);
+      GERGM_PROFILE_COUNT(profile, bytes_copied,
+                          sizeof(double) * current_edge_weights.n_elem);
       Storage_Counter = 0;
       MH_Counter += 1;
     }
@@ -3596,6 +2399,8 @@ List Edge_Group_MH_Sampler (int number_of_iterations,
   to_return[6] = Q_Ratios;
   to_return[7] = Proposed_Density;
   to_return[8] = Current_Density;
+  // phase timings and counters, NULL unless compiled with GERGM_PROFILE
+  to_return[9] = GERGM_PROFILE_RESULT(profile, statistics_to_use);
   return to_return;
 }
 
@@ -0,0 +1,48 @@
+// [[Rcpp::depends(RcppArmadillo)]]
+// [[Rcpp::depends(RcppParallel)]]
+
+#include "gergm_r.h"
+
+using namespace Rcpp;
+
+// The sampler itself is gibbs::run_gibbs_sampler() in the core library
+// (inst/include/gergm/gibbs.h).
+
+// [[Rcpp::export]]
+List Gibbs_Network_Sampler (int number_of_iterations,
+                            int number_of_nodes,
+                            arma::vec statistics_to_use,
+                            arma::mat initial_network,
+                            int take_sample_every,
+                            arma::vec thetas,
+                            arma::vec alphas,
+                            int together,
+                            int seed,
+                            int number_of_samples_to_store,
+                            int undirect_network) {
+
+  // the list we will put stuff in to return it to R
+  int list_length = 3;
+  List to_return(list_length);
+
+  gibbs::GibbsOutput output;
+  gibbs::run_gibbs_sampler(number_of_iterations,
+                           number_of_nodes,
+                           statistics_to_use,
+                           initial_network,
+                           take_sample_every,
+                           thetas,
+                           alphas,
+                           together,
+                           seed,
+                           number_of_samples_to_store,
+                           undirect_network,
+                           output);
+
+  // Save the data and then return
+  to_return[0] = output.Network_Samples;
+  to_return[1] = output.Mean_Edge_Weights;
+  // phase timings and counters, NULL unless compiled with GERGM_PROFILE
+  to_return[2] = GERGM_PROFILE_RESULT(output.profile, statistics_to_use);
+  return to_return;
+}
@@ -16,6 +16,7 @@
 #include <boost/random/detail/config.hpp>
 #include <boost/random/detail/operators.hpp>
 #include <boost/random/uniform_01.hpp>
+#include <gergm/vine_transform.h>
 
 
 using namespace Rcpp;
@@ -217,30 +218,10 @@ using std::pow;
 using std::exp;
 using std::sqrt;
 
-// add in the functions I wrote for correlation networks
+// add in the functions I wrote for correlation networks. The transform itself
+// lives in vine_transform.h so that it is shared with Corr_to_Part.
 arma::mat partials_to_correlations(arma::mat partial_correlations){
-  int nrow = partial_correlations.n_rows;
-  arma::mat correlations = arma::ones(nrow,nrow);
-  correlations.diag(1) = partial_correlations.diag(1);
-  correlations.diag(-1) = partial_correlations.diag(-1);
-
-  for (int k = 2; k < (nrow); ++k) {
-    for (int i = 1; i < (nrow - k + 1); ++i) {
-      arma::mat R2 = correlations.submat(i,i,(i + k -2),(i + k -2));
-      arma::mat R2_ones = arma::ones(R2.n_cols,R2.n_cols);
-      arma::rowvec r1 = correlations(i-1,arma::span(i,(i + k -2)));
-      arma::rowvec r3 =  correlations((i + k -1),arma::span(i,(i + k- 2)));
-      arma::mat R2_solved = arma::inv(R2);
-
-      arma::mat temp1 = 1 - r1 * R2_solved * r1.t();
-      arma::mat temp2 =  1 - r3 * R2_solved * r3.t();
-      arma::mat D =  sqrt(temp1 * temp2);
-      arma::mat temp3 = r1 * R2_solved * r3.t() + partial_correlations(i -1, i + k-1)*D;
-      correlations((i-1), (i + k-1)) = temp3(0,0);
-      correlations((i + k-1), (i-1)) = correlations(i-1, i + k-1);
-    }
-  }
-  return correlations;
+  return vine::partials_to_correlations(partial_correlations);
 }
 
 
@@ -255,29 +236,9 @@ arma::mat bounded_to_correlations(arma::mat bounded_network){
 }
 
 
-double jacobian(arma::mat partial_correlations){
-  int nrow = partial_correlations.n_rows;
-  arma::vec corrs_1 = partial_correlations.diag(1);
-  arma::vec temp = pow(corrs_1,2);
-  arma::vec temp2 = pow((1 - temp),(nrow -2));
-  double prod_1 =  arma::prod(temp2);
-  double prod_2 = 1;
-
-  for (int k = 2; k < (nrow -1); ++k) {
-    for (int i = 0; i < (nrow - k); ++i) {
-      double temp3 = pow(partial_correlations(i,(i + k)),2);
-      prod_2 = prod_2 * pow((1 - temp3),(nrow - 1 - k));
-    }
-  }
-
-  double temp4 = pow(prod_1,(nrow - 2));
-  double result = pow(temp4*prod_2,0.5);
-  return result;
-}
-
 // Function to calculate the number of out 2-stars
-double Out2Star(arma::mat net,
-                arma::mat triples,
+double Out2Star(const arma::mat& net,
+                const arma::mat& triples,
                 double alpha,
                 int together) {
 
@@ -312,8 +273,8 @@ double Out2Star(arma::mat net,
 };
 
 // Function to calculate the number of in 2-stars
-double In2Star(arma::mat net,
-               arma::mat triples,
+double In2Star(const arma::mat& net,
+               const arma::mat& triples,
                double alpha,
                int together) {
 
@@ -348,8 +309,8 @@ double In2Star(arma::mat net,
 };
 
 // Function to calculate the number of transitive triads
-double TTriads(arma::mat net,
-               arma::mat triples,
+double TTriads(const arma::mat& net,
+               const arma::mat& triples,
                double alpha,
                int together) {
 
@@ -405,8 +366,8 @@ double TTriads(arma::mat net,
 };
 
 // Function to calculate the number of closed triads
-double CTriads(arma::mat net,
-               arma::mat triples,
+double CTriads(const arma::mat& net,
+               const arma::mat& triples,
                double alpha,
                int together){
 
@@ -438,8 +399,8 @@ double CTriads(arma::mat net,
 };
 
 // Function to calculate the number of reciprocated edges
-double Recip(arma::mat net,
-             arma::mat pairs,
+double Recip(const arma::mat& net,
+             const arma::mat& pairs,
              double alpha,
              int together) {
 
@@ -465,8 +426,8 @@ double Recip(arma::mat net,
 };
 
 // Function to calculate the density of the network
-double EdgeDensity(arma::mat net,
-                   arma::mat pairs,
+double EdgeDensity(const arma::mat& net,
+                   const arma::mat& pairs,
                    double alpha,
                    int together) {
 
@@ -492,21 +453,21 @@ double EdgeDensity(arma::mat net,
 
 
 struct Parallel_CalculateNetworkStatistics : public RcppParallel::Worker {
-  arma::mat current_network;
-  arma::vec statistics_to_use;
-  arma::vec thetas;
-  arma::mat triples;
-  arma::mat pairs;
-  arma::vec alphas;
+  const arma::mat& current_network;
+  const arma::vec& statistics_to_use;
+  const arma::vec& thetas;
+  const arma::mat& triples;
+  const arma::mat& pairs;
+  const arma::vec& alphas;
   int together;
   RcppParallel::RVector<double> return_dist;
 
-  Parallel_CalculateNetworkStatistics(arma::mat current_network,
-                                      arma::vec statistics_to_use,
-                                      arma::vec thetas,
-                                      arma::mat triples,
-                                      arma::mat pairs,
-                                      arma::vec alphas,
+  Parallel_CalculateNetworkStatistics(const arma::mat& current_network,
+                                      const arma::vec& statistics_to_use,
+                                      const arma::vec& thetas,
+                                      const arma::mat& triples,
+                                      const arma::mat& pairs,
+                                      const arma::vec& alphas,
                                       int together,
                                       Rcpp::NumericVector return_dist)
     : current_network(current_network),
@@ -549,12 +510,12 @@ struct Parallel_CalculateNetworkStatistics : public RcppParallel::Worker {
 };
 
 double parallel_CalculateNetworkStatistics(
-    arma::mat current_network,
-    arma::vec statistics_to_use,
-    arma::vec thetas,
-    arma::mat triples,
-    arma::mat pairs,
-    arma::vec alphas,
+    const arma::mat& current_network,
+    const arma::vec& statistics_to_use,
+    const arma::vec& thetas,
+    const arma::mat& triples,
+    const arma::mat& pairs,
+    const arma::vec& alphas,
     int together) {
 
   int number_of_stats = statistics_to_use.n_elem;
@@ -584,12 +545,12 @@ double parallel_CalculateNetworkStatistics(
 
 
 // Function that will calculate h statistics
-double CalculateNetworkStatistics(arma::mat current_network,
-                                  arma::vec statistics_to_use,
-                                  arma::vec thetas,
-                                  arma::mat triples,
-                                  arma::mat pairs,
-                                  arma::vec alphas,
+double CalculateNetworkStatistics(const arma::mat& current_network,
+                                  const arma::vec& statistics_to_use,
+                                  const arma::vec& thetas,
+                                  const arma::mat& triples,
+                                  const arma::mat& pairs,
+                                  const arma::vec& alphas,
                                   int together,
                                   bool parallel) {
 
@@ -633,10 +594,10 @@ double CalculateNetworkStatistics(arma::mat current_network,
 };
 
 // Function that will calculate and save all of the h statistics for a network
-arma::vec save_network_statistics(arma::mat current_network,
-                                  arma::mat triples,
-                                  arma::mat pairs,
-                                  arma::vec alphas,
+arma::vec save_network_statistics(const arma::mat& current_network,
+                                  const arma::mat& triples,
+                                  const arma::mat& pairs,
+                                  const arma::vec& alphas,
                                   int together) {
 
   arma::vec to_return = arma::zeros(6);
@@ -651,12 +612,12 @@ arma::vec save_network_statistics(arma::mat current_network,
 
 
 // Function that will calculate h statistics
-arma::vec h_function_and_statistics(arma::mat current_network,
-                                    arma::vec statistics_to_use,
-                                    arma::vec thetas,
-                                    arma::mat triples,
-                                    arma::mat pairs,
-                                    arma::vec alphas,
+arma::vec h_function_and_statistics(const arma::mat& current_network,
+                                    const arma::vec& statistics_to_use,
+                                    const arma::vec& thetas,
+                                    const arma::mat& triples,
+                                    const arma::mat& pairs,
+                                    const arma::vec& alphas,
                                     int together) {
 
   arma::vec to_return = arma::zeros(7);
@@ -720,7 +681,7 @@ List Metropolis_Hastings_Sampler (int number_of_iterations,
   int number_of_thetas = statistics_to_use.n_elem;
   int MH_Counter = 0;
   int Storage_Counter = 0;
-  bool network_did_not_change = false;
+  bool current_h_value_is_cached = false;
   double previous_h_function_value = 0;
   arma::vec Accept_or_Reject = arma::zeros (number_of_iterations);
   arma::vec Log_Prob_Accept = arma::zeros (number_of_iterations);
@@ -735,11 +696,16 @@ List Metropolis_Hastings_Sampler (int number_of_iterations,
       number_of_thetas);
   arma::mat current_edge_weights = initial_network;
   arma::mat corr_current_edge_weights = arma::zeros (number_of_nodes, number_of_nodes);
+  double current_log_jacobian = 0;
 
   // deal with the case where we have a correlation network.
   if(using_correlation_network == 1){
     current_edge_weights.diag() = arma::ones(number_of_nodes);
     undirect_network = 1;
+    // cache the correlation space network and its log Jacobian, these are
+    // only refreshed when a proposal is accepted.
+    corr_current_edge_weights = mjd::bounded_to_correlations(current_edge_weights);
+    current_log_jacobian = vine::log_jacobian(2*current_edge_weights-1);
   }
 
 
@@ -867,23 +833,29 @@ List Metropolis_Hastings_Sampler (int number_of_iterations,
 
     double proposed_addition = 0;
     double current_addition = 0;
+    arma::mat corr_proposed_edge_weights;
+    double proposed_log_jacobian = 0;
 
     if(using_correlation_network == 1){
-      arma::mat corr_proposed_edge_weights = mjd::bounded_to_correlations(proposed_edge_weights);
-      arma::mat corr_current_edge_weights = mjd::bounded_to_correlations(current_edge_weights);
+      corr_proposed_edge_weights = mjd::bounded_to_correlations(proposed_edge_weights);
       proposed_addition = mjd::CalculateNetworkStatistics(
         corr_proposed_edge_weights, statistics_to_use, thetas, triples, pairs,
         alphas, together, parallel);
-      current_addition = mjd::CalculateNetworkStatistics(
-        corr_current_edge_weights, statistics_to_use, thetas, triples, pairs,
-        alphas, together, parallel);
+      if (current_h_value_is_cached) {
+        current_addition = previous_h_function_value;
+      } else {
+        current_addition = mjd::CalculateNetworkStatistics(
+          corr_current_edge_weights, statistics_to_use, thetas, triples, pairs,
+          alphas, together, parallel);
+        previous_h_function_value = current_addition ;
+      }
     }else{
       proposed_addition = mjd::CalculateNetworkStatistics(
         proposed_edge_weights, statistics_to_use, thetas, triples, pairs,
         alphas, together, parallel);
       // only calculate the h function if we updated the network last round
       // otherwise use the cached value.
-      if (network_did_not_change) {
+      if (current_h_value_is_cached) {
         current_addition = previous_h_function_value;
       } else {
         current_addition = mjd::CalculateNetworkStatistics(
@@ -907,9 +879,8 @@ List Metropolis_Hastings_Sampler (int number_of_iterations,
 
     if(using_correlation_network == 1){
       // now add in the bit about Jacobians
-      double numerator = log(mjd::jacobian(2*proposed_edge_weights-1));
-      double denominator = log(mjd::jacobian(2*current_edge_weights-1));
-      log_prob_accept += numerator - denominator;
+      proposed_log_jacobian = vine::log_jacobian(2*proposed_edge_weights-1);
+      log_prob_accept += proposed_log_jacobian - current_log_jacobian;
     }
 
     double rand_num = uniform_distribution(generator);
@@ -920,10 +891,17 @@ List Metropolis_Hastings_Sampler (int number_of_iterations,
     // Accept or reject the new proposed positions
     if (log_prob_accept < lud) {
       accept_proportion +=0;
-      network_did_not_change = true;
+      current_h_value_is_cached = true;
     } else {
       accept_proportion +=1;
-      network_did_not_change = false;
+      // the proposed network becomes the current one, so carry its h value
+      // (and correlation space quantities) over rather than recomputing them.
+      current_h_value_is_cached = true;
+      previous_h_function_value = proposed_addition;
+      if(using_correlation_network == 1){
+        corr_current_edge_weights = corr_proposed_edge_weights;
+        current_log_jacobian = proposed_log_jacobian;
+      }
       for (int i = 0; i < number_of_nodes; ++i) {
           for (int j = 0; j < number_of_nodes; ++j) {
               if (i != j) {
@@ -942,7 +920,6 @@ List Metropolis_Hastings_Sampler (int number_of_iterations,
     if (Storage_Counter == take_sample_every) {
 
       if(using_correlation_network == 1){
-        arma::mat corr_current_edge_weights = mjd::bounded_to_correlations(current_edge_weights);
         arma::vec save_stats = mjd::save_network_statistics(corr_current_edge_weights,
                                                             triples, pairs, alphas, together);
         for (int m = 0; m < 6; ++m) {
@@ -959,10 +936,6 @@ List Metropolis_Hastings_Sampler (int number_of_iterations,
 
 
       double mew = 0;
-      if(using_correlation_network == 1){
-        corr_current_edge_weights = mjd::bounded_to_correlations(current_edge_weights);
-      }
-
       for (int i = 0; i < number_of_nodes; ++i) {
         for (int j = 0; j < number_of_nodes; ++j) {
           if (i != j) {
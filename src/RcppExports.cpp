@@ -19,9 +19,46 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// Part_to_Corr
+arma::mat Part_to_Corr(arma::mat partials);
+RcppExport SEXP _GERGM_Part_to_Corr(SEXP partialsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< arma::mat >::type partials(partialsSEXP);
+    rcpp_result_gen = Rcpp::wrap(Part_to_Corr(partials));
+    return rcpp_result_gen;
+END_RCPP
+}
+// Log_Jacobian
+double Log_Jacobian(arma::mat partials);
+RcppExport SEXP _GERGM_Log_Jacobian(SEXP partialsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< arma::mat >::type partials(partialsSEXP);
+    rcpp_result_gen = Rcpp::wrap(Log_Jacobian(partials));
+    return rcpp_result_gen;
+END_RCPP
+}
+// Log_Jacobian_Delta
+double Log_Jacobian_Delta(int d, int i, int j, double old_partial, double new_partial);
+RcppExport SEXP _GERGM_Log_Jacobian_Delta(SEXP dSEXP, SEXP iSEXP, SEXP jSEXP, SEXP old_partialSEXP, SEXP new_partialSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< int >::type d(dSEXP);
+    Rcpp::traits::input_parameter< int >::type i(iSEXP);
+    Rcpp::traits::input_parameter< int >::type j(jSEXP);
+    Rcpp::traits::input_parameter< double >::type old_partial(old_partialSEXP);
+    Rcpp::traits::input_parameter< double >::type new_partial(new_partialSEXP);
+    rcpp_result_gen = Rcpp::wrap(Log_Jacobian_Delta(d, i, j, old_partial, new_partial));
+    return rcpp_result_gen;
+END_RCPP
+}
 // Extended_Metropolis_Hastings_Sampler
-List Extended_Metropolis_Hastings_Sampler(int number_of_iterations, double shape_parameter, int number_of_nodes, arma::vec statistics_to_use, arma::mat initial_network, int take_sample_every, arma::vec thetas, arma::Mat<double> triples, arma::Mat<double> pairs, arma::vec alphas, int together, int seed, int number_of_samples_to_store, int using_correlation_network, int undirect_network, bool parallel, arma::umat use_selected_rows, arma::umat save_statistics_selected_rows_matrix, arma::vec rows_to_use, arma::vec base_statistics_to_save, arma::vec base_statistic_alphas, int num_non_base_statistics, arma::vec non_base_statistic_indicator, double p_ratio_multaplicative_factor, Rcpp::List random_triad_sample_list, Rcpp::List random_dyad_sample_list, bool use_triad_sampling, int num_unique_random_triad_samples, bool include_diagonal);
-RcppExport SEXP _GERGM_Extended_Metropolis_Hastings_Sampler(SEXP number_of_iterationsSEXP, SEXP shape_parameterSEXP, SEXP number_of_nodesSEXP, SEXP statistics_to_useSEXP, SEXP initial_networkSEXP, SEXP take_sample_everySEXP, SEXP thetasSEXP, SEXP triplesSEXP, SEXP pairsSEXP, SEXP alphasSEXP, SEXP togetherSEXP, SEXP seedSEXP, SEXP number_of_samples_to_storeSEXP, SEXP using_correlation_networkSEXP, SEXP undirect_networkSEXP, SEXP parallelSEXP, SEXP use_selected_rowsSEXP, SEXP save_statistics_selected_rows_matrixSEXP, SEXP rows_to_useSEXP, SEXP base_statistics_to_saveSEXP, SEXP base_statistic_alphasSEXP, SEXP num_non_base_statisticsSEXP, SEXP non_base_statistic_indicatorSEXP, SEXP p_ratio_multaplicative_factorSEXP, SEXP random_triad_sample_listSEXP, SEXP random_dyad_sample_listSEXP, SEXP use_triad_samplingSEXP, SEXP num_unique_random_triad_samplesSEXP, SEXP include_diagonalSEXP) {
+List Extended_Metropolis_Hastings_Sampler(int number_of_iterations, double shape_parameter, int number_of_nodes, arma::vec statistics_to_use, arma::mat initial_network, int take_sample_every, arma::vec thetas, arma::Mat<double> triples, arma::Mat<double> pairs, arma::vec alphas, int together, int seed, int number_of_samples_to_store, int using_correlation_network, int undirect_network, bool parallel, arma::umat use_selected_rows, arma::umat save_statistics_selected_rows_matrix, arma::vec rows_to_use, arma::vec base_statistics_to_save, arma::vec base_statistic_alphas, int num_non_base_statistics, arma::vec non_base_statistic_indicator, double p_ratio_multaplicative_factor, double stochastic_MH_proportion, bool use_triad_sampling, bool use_weighted_triad_sampling, bool include_diagonal);
+RcppExport SEXP _GERGM_Extended_Metropolis_Hastings_Sampler(SEXP number_of_iterationsSEXP, SEXP shape_parameterSEXP, SEXP number_of_nodesSEXP, SEXP statistics_to_useSEXP, SEXP initial_networkSEXP, SEXP take_sample_everySEXP, SEXP thetasSEXP, SEXP triplesSEXP, SEXP pairsSEXP, SEXP alphasSEXP, SEXP togetherSEXP, SEXP seedSEXP, SEXP number_of_samples_to_storeSEXP, SEXP using_correlation_networkSEXP, SEXP undirect_networkSEXP, SEXP parallelSEXP, SEXP use_selected_rowsSEXP, SEXP save_statistics_selected_rows_matrixSEXP, SEXP rows_to_useSEXP, SEXP base_statistics_to_saveSEXP, SEXP base_statistic_alphasSEXP, SEXP num_non_base_statisticsSEXP, SEXP non_base_statistic_indicatorSEXP, SEXP p_ratio_multaplicative_factorSEXP, SEXP stochastic_MH_proportionSEXP, SEXP use_triad_samplingSEXP, SEXP use_weighted_triad_samplingSEXP, SEXP include_diagonalSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -49,12 +86,230 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< int >::type num_non_base_statistics(num_non_base_statisticsSEXP);
     Rcpp::traits::input_parameter< arma::vec >::type non_base_statistic_indicator(non_base_statistic_indicatorSEXP);
     Rcpp::traits::input_parameter< double >::type p_ratio_multaplicative_factor(p_ratio_multaplicative_factorSEXP);
-    Rcpp::traits::input_parameter< Rcpp::List >::type random_triad_sample_list(random_triad_sample_listSEXP);
-    Rcpp::traits::input_parameter< Rcpp::List >::type random_dyad_sample_list(random_dyad_sample_listSEXP);
+    Rcpp::traits::input_parameter< double >::type stochastic_MH_proportion(stochastic_MH_proportionSEXP);
+    Rcpp::traits::input_parameter< bool >::type use_triad_sampling(use_triad_samplingSEXP);
+    Rcpp::traits::input_parameter< bool >::type use_weighted_triad_sampling(use_weighted_triad_samplingSEXP);
+    Rcpp::traits::input_parameter< bool >::type include_diagonal(include_diagonalSEXP);
+    rcpp_result_gen = Rcpp::wrap(Extended_Metropolis_Hastings_Sampler(number_of_iterations, shape_parameter, number_of_nodes, statistics_to_use, initial_network, take_sample_every, thetas, triples, pairs, alphas, together, seed, number_of_samples_to_store, using_correlation_network, undirect_network, parallel, use_selected_rows, save_statistics_selected_rows_matrix, rows_to_use, base_statistics_to_save, base_statistic_alphas, num_non_base_statistics, non_base_statistic_indicator, p_ratio_multaplicative_factor, stochastic_MH_proportion, use_triad_sampling, use_weighted_triad_sampling, include_diagonal));
+    return rcpp_result_gen;
+END_RCPP
+}
+// Create_GERGM_Model
+SEXP Create_GERGM_Model(int number_of_nodes, arma::vec statistics_to_use, arma::Mat<double> triples, arma::Mat<double> pairs, arma::vec alphas, int together, int using_correlation_network, int undirect_network, arma::umat use_selected_rows, arma::umat save_statistics_selected_rows_matrix, arma::vec rows_to_use, arma::vec base_statistics_to_save, arma::vec base_statistic_alphas, int num_non_base_statistics, arma::vec non_base_statistic_indicator, double p_ratio_multaplicative_factor, double stochastic_MH_proportion, bool use_triad_sampling, bool use_weighted_triad_sampling, bool include_diagonal);
+RcppExport SEXP _GERGM_Create_GERGM_Model(SEXP number_of_nodesSEXP, SEXP statistics_to_useSEXP, SEXP triplesSEXP, SEXP pairsSEXP, SEXP alphasSEXP, SEXP togetherSEXP, SEXP using_correlation_networkSEXP, SEXP undirect_networkSEXP, SEXP use_selected_rowsSEXP, SEXP save_statistics_selected_rows_matrixSEXP, SEXP rows_to_useSEXP, SEXP base_statistics_to_saveSEXP, SEXP base_statistic_alphasSEXP, SEXP num_non_base_statisticsSEXP, SEXP non_base_statistic_indicatorSEXP, SEXP p_ratio_multaplicative_factorSEXP, SEXP stochastic_MH_proportionSEXP, SEXP use_triad_samplingSEXP, SEXP use_weighted_triad_samplingSEXP, SEXP include_diagonalSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< int >::type number_of_nodes(number_of_nodesSEXP);
+    Rcpp::traits::input_parameter< arma::vec >::type statistics_to_use(statistics_to_useSEXP);
+    Rcpp::traits::input_parameter< arma::Mat<double> >::type triples(triplesSEXP);
+    Rcpp::traits::input_parameter< arma::Mat<double> >::type pairs(pairsSEXP);
+    Rcpp::traits::input_parameter< arma::vec >::type alphas(alphasSEXP);
+    Rcpp::traits::input_parameter< int >::type together(togetherSEXP);
+    Rcpp::traits::input_parameter< int >::type using_correlation_network(using_correlation_networkSEXP);
+    Rcpp::traits::input_parameter< int >::type undirect_network(undirect_networkSEXP);
+    Rcpp::traits::input_parameter< arma::umat >::type use_selected_rows(use_selected_rowsSEXP);
+    Rcpp::traits::input_parameter< arma::umat >::type save_statistics_selected_rows_matrix(save_statistics_selected_rows_matrixSEXP);
+    Rcpp::traits::input_parameter< arma::vec >::type rows_to_use(rows_to_useSEXP);
+    Rcpp::traits::input_parameter< arma::vec >::type base_statistics_to_save(base_statistics_to_saveSEXP);
+    Rcpp::traits::input_parameter< arma::vec >::type base_statistic_alphas(base_statistic_alphasSEXP);
+    Rcpp::traits::input_parameter< int >::type num_non_base_statistics(num_non_base_statisticsSEXP);
+    Rcpp::traits::input_parameter< arma::vec >::type non_base_statistic_indicator(non_base_statistic_indicatorSEXP);
+    Rcpp::traits::input_parameter< double >::type p_ratio_multaplicative_factor(p_ratio_multaplicative_factorSEXP);
+    Rcpp::traits::input_parameter< double >::type stochastic_MH_proportion(stochastic_MH_proportionSEXP);
     Rcpp::traits::input_parameter< bool >::type use_triad_sampling(use_triad_samplingSEXP);
-    Rcpp::traits::input_parameter< int >::type num_unique_random_triad_samples(num_unique_random_triad_samplesSEXP);
+    Rcpp::traits::input_parameter< bool >::type use_weighted_triad_sampling(use_weighted_triad_samplingSEXP);
     Rcpp::traits::input_parameter< bool >::type include_diagonal(include_diagonalSEXP);
-    rcpp_result_gen = Rcpp::wrap(Extended_Metropolis_Hastings_Sampler(number_of_iterations, shape_parameter, number_of_nodes, statistics_to_use, initial_network, take_sample_every, thetas, triples, pairs, alphas, together, seed, number_of_samples_to_store, using_correlation_network, undirect_network, parallel, use_selected_rows, save_statistics_selected_rows_matrix, rows_to_use, base_statistics_to_save, base_statistic_alphas, num_non_base_statistics, non_base_statistic_indicator, p_ratio_multaplicative_factor, random_triad_sample_list, random_dyad_sample_list, use_triad_sampling, num_unique_random_triad_samples, include_diagonal));
+    rcpp_result_gen = Rcpp::wrap(Create_GERGM_Model(number_of_nodes, statistics_to_use, triples, pairs, alphas, together, using_correlation_network, undirect_network, use_selected_rows, save_statistics_selected_rows_matrix, rows_to_use, base_statistics_to_save, base_statistic_alphas, num_non_base_statistics, non_base_statistic_indicator, p_ratio_multaplicative_factor, stochastic_MH_proportion, use_triad_sampling, use_weighted_triad_sampling, include_diagonal));
+    return rcpp_result_gen;
+END_RCPP
+}
+// GERGM_Model_Is_Valid
+bool GERGM_Model_Is_Valid(SEXP model);
+RcppExport SEXP _GERGM_GERGM_Model_Is_Valid(SEXP modelSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type model(modelSEXP);
+    rcpp_result_gen = Rcpp::wrap(GERGM_Model_Is_Valid(model));
+    return rcpp_result_gen;
+END_RCPP
+}
+// GERGM_Model_MH_Sampler
+List GERGM_Model_MH_Sampler(SEXP model, int number_of_iterations, double shape_parameter, arma::mat initial_network, int take_sample_every, arma::vec thetas, int seed, int number_of_samples_to_store, bool parallel, int network_storage, std::string sample_file, Rcpp::CharacterVector statistic_names, int first_sample);
+RcppExport SEXP _GERGM_GERGM_Model_MH_Sampler(SEXP modelSEXP, SEXP number_of_iterationsSEXP, SEXP shape_parameterSEXP, SEXP initial_networkSEXP, SEXP take_sample_everySEXP, SEXP thetasSEXP, SEXP seedSEXP, SEXP number_of_samples_to_storeSEXP, SEXP parallelSEXP, SEXP network_storageSEXP, SEXP sample_fileSEXP, SEXP statistic_namesSEXP, SEXP first_sampleSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type model(modelSEXP);
+    Rcpp::traits::input_parameter< int >::type number_of_iterations(number_of_iterationsSEXP);
+    Rcpp::traits::input_parameter< double >::type shape_parameter(shape_parameterSEXP);
+    Rcpp::traits::input_parameter< arma::mat >::type initial_network(initial_networkSEXP);
+    Rcpp::traits::input_parameter< int >::type take_sample_every(take_sample_everySEXP);
+    Rcpp::traits::input_parameter< arma::vec >::type thetas(thetasSEXP);
+    Rcpp::traits::input_parameter< int >::type seed(seedSEXP);
+    Rcpp::traits::input_parameter< int >::type number_of_samples_to_store(number_of_samples_to_storeSEXP);
+    Rcpp::traits::input_parameter< bool >::type parallel(parallelSEXP);
+    Rcpp::traits::input_parameter< int >::type network_storage(network_storageSEXP);
+    Rcpp::traits::input_parameter< std::string >::type sample_file(sample_fileSEXP);
+    Rcpp::traits::input_parameter< Rcpp::CharacterVector >::type statistic_names(statistic_namesSEXP);
+    Rcpp::traits::input_parameter< int >::type first_sample(first_sampleSEXP);
+    rcpp_result_gen = Rcpp::wrap(GERGM_Model_MH_Sampler(model, number_of_iterations, shape_parameter, initial_network, take_sample_every, thetas, seed, number_of_samples_to_store, parallel, network_storage, sample_file, statistic_names, first_sample));
+    return rcpp_result_gen;
+END_RCPP
+}
+// Start_GERGM_Model_MH_Sampler
+SEXP Start_GERGM_Model_MH_Sampler(SEXP model, int number_of_iterations, double shape_parameter, arma::mat initial_network, int take_sample_every, arma::vec thetas, int seed, int number_of_samples_to_store, bool parallel, int network_storage);
+RcppExport SEXP _GERGM_Start_GERGM_Model_MH_Sampler(SEXP modelSEXP, SEXP number_of_iterationsSEXP, SEXP shape_parameterSEXP, SEXP initial_networkSEXP, SEXP take_sample_everySEXP, SEXP thetasSEXP, SEXP seedSEXP, SEXP number_of_samples_to_storeSEXP, SEXP parallelSEXP, SEXP network_storageSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type model(modelSEXP);
+    Rcpp::traits::input_parameter< int >::type number_of_iterations(number_of_iterationsSEXP);
+    Rcpp::traits::input_parameter< double >::type shape_parameter(shape_parameterSEXP);
+    Rcpp::traits::input_parameter< arma::mat >::type initial_network(initial_networkSEXP);
+    Rcpp::traits::input_parameter< int >::type take_sample_every(take_sample_everySEXP);
+    Rcpp::traits::input_parameter< arma::vec >::type thetas(thetasSEXP);
+    Rcpp::traits::input_parameter< int >::type seed(seedSEXP);
+    Rcpp::traits::input_parameter< int >::type number_of_samples_to_store(number_of_samples_to_storeSEXP);
+    Rcpp::traits::input_parameter< bool >::type parallel(parallelSEXP);
+    Rcpp::traits::input_parameter< int >::type network_storage(network_storageSEXP);
+    rcpp_result_gen = Rcpp::wrap(Start_GERGM_Model_MH_Sampler(model, number_of_iterations, shape_parameter, initial_network, take_sample_every, thetas, seed, number_of_samples_to_store, parallel, network_storage));
+    return rcpp_result_gen;
+END_RCPP
+}
+// MH_Sampler_Progress
+List MH_Sampler_Progress(SEXP run);
+RcppExport SEXP _GERGM_MH_Sampler_Progress(SEXP runSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type run(runSEXP);
+    rcpp_result_gen = Rcpp::wrap(MH_Sampler_Progress(run));
+    return rcpp_result_gen;
+END_RCPP
+}
+// MH_Sampler_Partial_Output
+List MH_Sampler_Partial_Output(SEXP run);
+RcppExport SEXP _GERGM_MH_Sampler_Partial_Output(SEXP runSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type run(runSEXP);
+    rcpp_result_gen = Rcpp::wrap(MH_Sampler_Partial_Output(run));
+    return rcpp_result_gen;
+END_RCPP
+}
+// Cancel_MH_Sampler
+void Cancel_MH_Sampler(SEXP run);
+RcppExport SEXP _GERGM_Cancel_MH_Sampler(SEXP runSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type run(runSEXP);
+    Cancel_MH_Sampler(run);
+    return R_NilValue;
+END_RCPP
+}
+// MH_Sampler_Result
+List MH_Sampler_Result(SEXP run);
+RcppExport SEXP _GERGM_MH_Sampler_Result(SEXP runSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type run(runSEXP);
+    rcpp_result_gen = Rcpp::wrap(MH_Sampler_Result(run));
+    return rcpp_result_gen;
+END_RCPP
+}
+// GERGM_Model_Multi_Theta_MH_Sampler
+List GERGM_Model_Multi_Theta_MH_Sampler(SEXP model, arma::mat thetas, arma::vec chain_lengths, arma::mat initial_network, int burnin_iterations, int warm_start_burnin_iterations, int number_of_iterations, double shape_parameter, int take_sample_every, int seed, bool parallel);
+RcppExport SEXP _GERGM_GERGM_Model_Multi_Theta_MH_Sampler(SEXP modelSEXP, SEXP thetasSEXP, SEXP chain_lengthsSEXP, SEXP initial_networkSEXP, SEXP burnin_iterationsSEXP, SEXP warm_start_burnin_iterationsSEXP, SEXP number_of_iterationsSEXP, SEXP shape_parameterSEXP, SEXP take_sample_everySEXP, SEXP seedSEXP, SEXP parallelSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type model(modelSEXP);
+    Rcpp::traits::input_parameter< arma::mat >::type thetas(thetasSEXP);
+    Rcpp::traits::input_parameter< arma::vec >::type chain_lengths(chain_lengthsSEXP);
+    Rcpp::traits::input_parameter< arma::mat >::type initial_network(initial_networkSEXP);
+    Rcpp::traits::input_parameter< int >::type burnin_iterations(burnin_iterationsSEXP);
+    Rcpp::traits::input_parameter< int >::type warm_start_burnin_iterations(warm_start_burnin_iterationsSEXP);
+    Rcpp::traits::input_parameter< int >::type number_of_iterations(number_of_iterationsSEXP);
+    Rcpp::traits::input_parameter< double >::type shape_parameter(shape_parameterSEXP);
+    Rcpp::traits::input_parameter< int >::type take_sample_every(take_sample_everySEXP);
+    Rcpp::traits::input_parameter< int >::type seed(seedSEXP);
+    Rcpp::traits::input_parameter< bool >::type parallel(parallelSEXP);
+    rcpp_result_gen = Rcpp::wrap(GERGM_Model_Multi_Theta_MH_Sampler(model, thetas, chain_lengths, initial_network, burnin_iterations, warm_start_burnin_iterations, number_of_iterations, shape_parameter, take_sample_every, seed, parallel));
+    return rcpp_result_gen;
+END_RCPP
+}
+// GERGM_Model_h_statistics
+arma::vec GERGM_Model_h_statistics(SEXP model, arma::mat current_edge_weights);
+RcppExport SEXP _GERGM_GERGM_Model_h_statistics(SEXP modelSEXP, SEXP current_edge_weightsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type model(modelSEXP);
+    Rcpp::traits::input_parameter< arma::mat >::type current_edge_weights(current_edge_weightsSEXP);
+    rcpp_result_gen = Rcpp::wrap(GERGM_Model_h_statistics(model, current_edge_weights));
+    return rcpp_result_gen;
+END_RCPP
+}
+// GERGM_Model_MPLE_Objective
+double GERGM_Model_MPLE_Objective(SEXP model, arma::vec thetas, arma::mat network, arma::vec integration_interval, bool parallel, bool distribution_estimator);
+RcppExport SEXP _GERGM_GERGM_Model_MPLE_Objective(SEXP modelSEXP, SEXP thetasSEXP, SEXP networkSEXP, SEXP integration_intervalSEXP, SEXP parallelSEXP, SEXP distribution_estimatorSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type model(modelSEXP);
+    Rcpp::traits::input_parameter< arma::vec >::type thetas(thetasSEXP);
+    Rcpp::traits::input_parameter< arma::mat >::type network(networkSEXP);
+    Rcpp::traits::input_parameter< arma::vec >::type integration_interval(integration_intervalSEXP);
+    Rcpp::traits::input_parameter< bool >::type parallel(parallelSEXP);
+    Rcpp::traits::input_parameter< bool >::type distribution_estimator(distribution_estimatorSEXP);
+    rcpp_result_gen = Rcpp::wrap(GERGM_Model_MPLE_Objective(model, thetas, network, integration_interval, parallel, distribution_estimator));
+    return rcpp_result_gen;
+END_RCPP
+}
+// GERGM_Model_Stochastic_h_Values
+arma::vec GERGM_Model_Stochastic_h_Values(SEXP model, arma::mat network, arma::vec thetas, int number_of_draws, int seed);
+RcppExport SEXP _GERGM_GERGM_Model_Stochastic_h_Values(SEXP modelSEXP, SEXP networkSEXP, SEXP thetasSEXP, SEXP number_of_drawsSEXP, SEXP seedSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type model(modelSEXP);
+    Rcpp::traits::input_parameter< arma::mat >::type network(networkSEXP);
+    Rcpp::traits::input_parameter< arma::vec >::type thetas(thetasSEXP);
+    Rcpp::traits::input_parameter< int >::type number_of_draws(number_of_drawsSEXP);
+    Rcpp::traits::input_parameter< int >::type seed(seedSEXP);
+    rcpp_result_gen = Rcpp::wrap(GERGM_Model_Stochastic_h_Values(model, network, thetas, number_of_draws, seed));
+    return rcpp_result_gen;
+END_RCPP
+}
+// alias_table_counts
+arma::vec alias_table_counts(arma::vec probabilities, int number_of_draws, int seed);
+RcppExport SEXP _GERGM_alias_table_counts(SEXP probabilitiesSEXP, SEXP number_of_drawsSEXP, SEXP seedSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< arma::vec >::type probabilities(probabilitiesSEXP);
+    Rcpp::traits::input_parameter< int >::type number_of_draws(number_of_drawsSEXP);
+    Rcpp::traits::input_parameter< int >::type seed(seedSEXP);
+    rcpp_result_gen = Rcpp::wrap(alias_table_counts(probabilities, number_of_draws, seed));
+    return rcpp_result_gen;
+END_RCPP
+}
+// GERGM_Model_Network_Cube_Statistics
+List GERGM_Model_Network_Cube_Statistics(SEXP model, arma::cube networks, bool calculate_statistics, arma::vec memberships, bool calculate_modularity);
+RcppExport SEXP _GERGM_GERGM_Model_Network_Cube_Statistics(SEXP modelSEXP, SEXP networksSEXP, SEXP calculate_statisticsSEXP, SEXP membershipsSEXP, SEXP calculate_modularitySEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type model(modelSEXP);
+    Rcpp::traits::input_parameter< arma::cube >::type networks(networksSEXP);
+    Rcpp::traits::input_parameter< bool >::type calculate_statistics(calculate_statisticsSEXP);
+    Rcpp::traits::input_parameter< arma::vec >::type memberships(membershipsSEXP);
+    Rcpp::traits::input_parameter< bool >::type calculate_modularity(calculate_modularitySEXP);
+    rcpp_result_gen = Rcpp::wrap(GERGM_Model_Network_Cube_Statistics(model, networks, calculate_statistics, memberships, calculate_modularity));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -162,8 +417,8 @@ BEGIN_RCPP
 END_RCPP
 }
 // Individual_Edge_Conditional_Prediction
-List Individual_Edge_Conditional_Prediction(int number_of_iterations, double shape_parameter, int number_of_nodes, arma::vec statistics_to_use, arma::mat initial_network, int take_sample_every, arma::vec thetas, arma::Mat<double> triples, arma::Mat<double> pairs, arma::vec alphas, int together, int seed, int number_of_samples_to_store, int using_correlation_network, int undirect_network, bool parallel, arma::umat use_selected_rows, arma::umat save_statistics_selected_rows_matrix, arma::vec rows_to_use, arma::vec base_statistics_to_save, arma::vec base_statistic_alphas, int num_non_base_statistics, arma::vec non_base_statistic_indicator, double p_ratio_multaplicative_factor, Rcpp::List random_triad_sample_list, Rcpp::List random_dyad_sample_list, bool use_triad_sampling, int num_unique_random_triad_samples, int i, int j);
-RcppExport SEXP _GERGM_Individual_Edge_Conditional_Prediction(SEXP number_of_iterationsSEXP, SEXP shape_parameterSEXP, SEXP number_of_nodesSEXP, SEXP statistics_to_useSEXP, SEXP initial_networkSEXP, SEXP take_sample_everySEXP, SEXP thetasSEXP, SEXP triplesSEXP, SEXP pairsSEXP, SEXP alphasSEXP, SEXP togetherSEXP, SEXP seedSEXP, SEXP number_of_samples_to_storeSEXP, SEXP using_correlation_networkSEXP, SEXP undirect_networkSEXP, SEXP parallelSEXP, SEXP use_selected_rowsSEXP, SEXP save_statistics_selected_rows_matrixSEXP, SEXP rows_to_useSEXP, SEXP base_statistics_to_saveSEXP, SEXP base_statistic_alphasSEXP, SEXP num_non_base_statisticsSEXP, SEXP non_base_statistic_indicatorSEXP, SEXP p_ratio_multaplicative_factorSEXP, SEXP random_triad_sample_listSEXP, SEXP random_dyad_sample_listSEXP, SEXP use_triad_samplingSEXP, SEXP num_unique_random_triad_samplesSEXP, SEXP iSEXP, SEXP jSEXP) {
+List Individual_Edge_Conditional_Prediction(int number_of_iterations, double shape_parameter, int number_of_nodes, arma::vec statistics_to_use, arma::mat initial_network, int take_sample_every, arma::vec thetas, arma::Mat<double> triples, arma::Mat<double> pairs, arma::vec alphas, int together, int seed, int number_of_samples_to_store, int using_correlation_network, int undirect_network, bool parallel, arma::umat use_selected_rows, arma::umat save_statistics_selected_rows_matrix, arma::vec rows_to_use, arma::vec base_statistics_to_save, arma::vec base_statistic_alphas, int num_non_base_statistics, arma::vec non_base_statistic_indicator, double p_ratio_multaplicative_factor, double stochastic_MH_proportion, bool use_triad_sampling, int i, int j);
+RcppExport SEXP _GERGM_Individual_Edge_Conditional_Prediction(SEXP number_of_iterationsSEXP, SEXP shape_parameterSEXP, SEXP number_of_nodesSEXP, SEXP statistics_to_useSEXP, SEXP initial_networkSEXP, SEXP take_sample_everySEXP, SEXP thetasSEXP, SEXP triplesSEXP, SEXP pairsSEXP, SEXP alphasSEXP, SEXP togetherSEXP, SEXP seedSEXP, SEXP number_of_samples_to_storeSEXP, SEXP using_correlation_networkSEXP, SEXP undirect_networkSEXP, SEXP parallelSEXP, SEXP use_selected_rowsSEXP, SEXP save_statistics_selected_rows_matrixSEXP, SEXP rows_to_useSEXP, SEXP base_statistics_to_saveSEXP, SEXP base_statistic_alphasSEXP, SEXP num_non_base_statisticsSEXP, SEXP non_base_statistic_indicatorSEXP, SEXP p_ratio_multaplicative_factorSEXP, SEXP stochastic_MH_proportionSEXP, SEXP use_triad_samplingSEXP, SEXP iSEXP, SEXP jSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -191,19 +446,45 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< int >::type num_non_base_statistics(num_non_base_statisticsSEXP);
     Rcpp::traits::input_parameter< arma::vec >::type non_base_statistic_indicator(non_base_statistic_indicatorSEXP);
     Rcpp::traits::input_parameter< double >::type p_ratio_multaplicative_factor(p_ratio_multaplicative_factorSEXP);
-    Rcpp::traits::input_parameter< Rcpp::List >::type random_triad_sample_list(random_triad_sample_listSEXP);
-    Rcpp::traits::input_parameter< Rcpp::List >::type random_dyad_sample_list(random_dyad_sample_listSEXP);
+    Rcpp::traits::input_parameter< double >::type stochastic_MH_proportion(stochastic_MH_proportionSEXP);
     Rcpp::traits::input_parameter< bool >::type use_triad_sampling(use_triad_samplingSEXP);
-    Rcpp::traits::input_parameter< int >::type num_unique_random_triad_samples(num_unique_random_triad_samplesSEXP);
     Rcpp::traits::input_parameter< int >::type i(iSEXP);
     Rcpp::traits::input_parameter< int >::type j(jSEXP);
-    rcpp_result_gen = Rcpp::wrap(Individual_Edge_Conditional_Prediction(number_of_iterations, shape_parameter, number_of_nodes, statistics_to_use, initial_network, take_sample_every, thetas, triples, pairs, alphas, together, seed, number_of_samples_to_store, using_correlation_network, undirect_network, parallel, use_selected_rows, save_statistics_selected_rows_matrix, rows_to_use, base_statistics_to_save, base_statistic_alphas, num_non_base_statistics, non_base_statistic_indicator, p_ratio_multaplicative_factor, random_triad_sample_list, random_dyad_sample_list, use_triad_sampling, num_unique_random_triad_samples, i, j));
+    rcpp_result_gen = Rcpp::wrap(Individual_Edge_Conditional_Prediction(number_of_iterations, shape_parameter, number_of_nodes, statistics_to_use, initial_network, take_sample_every, thetas, triples, pairs, alphas, together, seed, number_of_samples_to_store, using_correlation_network, undirect_network, parallel, use_selected_rows, save_statistics_selected_rows_matrix, rows_to_use, base_statistics_to_save, base_statistic_alphas, num_non_base_statistics, non_base_statistic_indicator, p_ratio_multaplicative_factor, stochastic_MH_proportion, use_triad_sampling, i, j));
+    return rcpp_result_gen;
+END_RCPP
+}
+// Batch_Edge_Conditional_Prediction
+List Batch_Edge_Conditional_Prediction(int number_of_iterations, double shape_parameter, int number_of_nodes, arma::vec statistics_to_use, arma::mat initial_network, int take_sample_every, arma::vec thetas, arma::Mat<double> triples, arma::Mat<double> pairs, arma::vec alphas, int together, int seed, int number_of_samples_to_store, int undirect_network, arma::umat use_selected_rows, arma::vec rows_to_use, arma::vec non_base_statistic_indicator, arma::umat dyads);
+RcppExport SEXP _GERGM_Batch_Edge_Conditional_Prediction(SEXP number_of_iterationsSEXP, SEXP shape_parameterSEXP, SEXP number_of_nodesSEXP, SEXP statistics_to_useSEXP, SEXP initial_networkSEXP, SEXP take_sample_everySEXP, SEXP thetasSEXP, SEXP triplesSEXP, SEXP pairsSEXP, SEXP alphasSEXP, SEXP togetherSEXP, SEXP seedSEXP, SEXP number_of_samples_to_storeSEXP, SEXP undirect_networkSEXP, SEXP use_selected_rowsSEXP, SEXP rows_to_useSEXP, SEXP non_base_statistic_indicatorSEXP, SEXP dyadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< int >::type number_of_iterations(number_of_iterationsSEXP);
+    Rcpp::traits::input_parameter< double >::type shape_parameter(shape_parameterSEXP);
+    Rcpp::traits::input_parameter< int >::type number_of_nodes(number_of_nodesSEXP);
+    Rcpp::traits::input_parameter< arma::vec >::type statistics_to_use(statistics_to_useSEXP);
+    Rcpp::traits::input_parameter< arma::mat >::type initial_network(initial_networkSEXP);
+    Rcpp::traits::input_parameter< int >::type take_sample_every(take_sample_everySEXP);
+    Rcpp::traits::input_parameter< arma::vec >::type thetas(thetasSEXP);
+    Rcpp::traits::input_parameter< arma::Mat<double> >::type triples(triplesSEXP);
+    Rcpp::traits::input_parameter< arma::Mat<double> >::type pairs(pairsSEXP);
+    Rcpp::traits::input_parameter< arma::vec >::type alphas(alphasSEXP);
+    Rcpp::traits::input_parameter< int >::type together(togetherSEXP);
+    Rcpp::traits::input_parameter< int >::type seed(seedSEXP);
+    Rcpp::traits::input_parameter< int >::type number_of_samples_to_store(number_of_samples_to_storeSEXP);
+    Rcpp::traits::input_parameter< int >::type undirect_network(undirect_networkSEXP);
+    Rcpp::traits::input_parameter< arma::umat >::type use_selected_rows(use_selected_rowsSEXP);
+    Rcpp::traits::input_parameter< arma::vec >::type rows_to_use(rows_to_useSEXP);
+    Rcpp::traits::input_parameter< arma::vec >::type non_base_statistic_indicator(non_base_statistic_indicatorSEXP);
+    Rcpp::traits::input_parameter< arma::umat >::type dyads(dyadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(Batch_Edge_Conditional_Prediction(number_of_iterations, shape_parameter, number_of_nodes, statistics_to_use, initial_network, take_sample_every, thetas, triples, pairs, alphas, together, seed, number_of_samples_to_store, undirect_network, use_selected_rows, rows_to_use, non_base_statistic_indicator, dyads));
     return rcpp_result_gen;
 END_RCPP
 }
 // Distribution_Metropolis_Hastings_Sampler
-List Distribution_Metropolis_Hastings_Sampler(int number_of_iterations, double variance, int number_of_nodes, arma::vec statistics_to_use, arma::mat initial_network, int take_sample_every, arma::vec thetas, arma::Mat<double> triples, arma::Mat<double> pairs, arma::vec alphas, int together, int seed, int number_of_samples_to_store, bool parallel, arma::umat use_selected_rows, arma::umat save_statistics_selected_rows_matrix, arma::vec rows_to_use, arma::vec base_statistics_to_save, arma::vec base_statistic_alphas, int num_non_base_statistics, arma::vec non_base_statistic_indicator, double p_ratio_multaplicative_factor, Rcpp::List random_triad_sample_list, Rcpp::List random_dyad_sample_list, bool use_triad_sampling, int num_unique_random_triad_samples, bool rowwise_distribution);
-RcppExport SEXP _GERGM_Distribution_Metropolis_Hastings_Sampler(SEXP number_of_iterationsSEXP, SEXP varianceSEXP, SEXP number_of_nodesSEXP, SEXP statistics_to_useSEXP, SEXP initial_networkSEXP, SEXP take_sample_everySEXP, SEXP thetasSEXP, SEXP triplesSEXP, SEXP pairsSEXP, SEXP alphasSEXP, SEXP togetherSEXP, SEXP seedSEXP, SEXP number_of_samples_to_storeSEXP, SEXP parallelSEXP, SEXP use_selected_rowsSEXP, SEXP save_statistics_selected_rows_matrixSEXP, SEXP rows_to_useSEXP, SEXP base_statistics_to_saveSEXP, SEXP base_statistic_alphasSEXP, SEXP num_non_base_statisticsSEXP, SEXP non_base_statistic_indicatorSEXP, SEXP p_ratio_multaplicative_factorSEXP, SEXP random_triad_sample_listSEXP, SEXP random_dyad_sample_listSEXP, SEXP use_triad_samplingSEXP, SEXP num_unique_random_triad_samplesSEXP, SEXP rowwise_distributionSEXP) {
+List Distribution_Metropolis_Hastings_Sampler(int number_of_iterations, double variance, int number_of_nodes, arma::vec statistics_to_use, arma::mat initial_network, int take_sample_every, arma::vec thetas, arma::Mat<double> triples, arma::Mat<double> pairs, arma::vec alphas, int together, int seed, int number_of_samples_to_store, bool parallel, arma::umat use_selected_rows, arma::umat save_statistics_selected_rows_matrix, arma::vec rows_to_use, arma::vec base_statistics_to_save, arma::vec base_statistic_alphas, int num_non_base_statistics, arma::vec non_base_statistic_indicator, double p_ratio_multaplicative_factor, double stochastic_MH_proportion, bool use_triad_sampling, bool rowwise_distribution);
+RcppExport SEXP _GERGM_Distribution_Metropolis_Hastings_Sampler(SEXP number_of_iterationsSEXP, SEXP varianceSEXP, SEXP number_of_nodesSEXP, SEXP statistics_to_useSEXP, SEXP initial_networkSEXP, SEXP take_sample_everySEXP, SEXP thetasSEXP, SEXP triplesSEXP, SEXP pairsSEXP, SEXP alphasSEXP, SEXP togetherSEXP, SEXP seedSEXP, SEXP number_of_samples_to_storeSEXP, SEXP parallelSEXP, SEXP use_selected_rowsSEXP, SEXP save_statistics_selected_rows_matrixSEXP, SEXP rows_to_useSEXP, SEXP base_statistics_to_saveSEXP, SEXP base_statistic_alphasSEXP, SEXP num_non_base_statisticsSEXP, SEXP non_base_statistic_indicatorSEXP, SEXP p_ratio_multaplicative_factorSEXP, SEXP stochastic_MH_proportionSEXP, SEXP use_triad_samplingSEXP, SEXP rowwise_distributionSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -229,12 +510,10 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< int >::type num_non_base_statistics(num_non_base_statisticsSEXP);
     Rcpp::traits::input_parameter< arma::vec >::type non_base_statistic_indicator(non_base_statistic_indicatorSEXP);
     Rcpp::traits::input_parameter< double >::type p_ratio_multaplicative_factor(p_ratio_multaplicative_factorSEXP);
-    Rcpp::traits::input_parameter< Rcpp::List >::type random_triad_sample_list(random_triad_sample_listSEXP);
-    Rcpp::traits::input_parameter< Rcpp::List >::type random_dyad_sample_list(random_dyad_sample_listSEXP);
+    Rcpp::traits::input_parameter< double >::type stochastic_MH_proportion(stochastic_MH_proportionSEXP);
     Rcpp::traits::input_parameter< bool >::type use_triad_sampling(use_triad_samplingSEXP);
-    Rcpp::traits::input_parameter< int >::type num_unique_random_triad_samples(num_unique_random_triad_samplesSEXP);
     Rcpp::traits::input_parameter< bool >::type rowwise_distribution(rowwise_distributionSEXP);
-    rcpp_result_gen = Rcpp::wrap(Distribution_Metropolis_Hastings_Sampler(number_of_iterations, variance, number_of_nodes, statistics_to_use, initial_network, take_sample_every, thetas, triples, pairs, alphas, together, seed, number_of_samples_to_store, parallel, use_selected_rows, save_statistics_selected_rows_matrix, rows_to_use, base_statistics_to_save, base_statistic_alphas, num_non_base_statistics, non_base_statistic_indicator, p_ratio_multaplicative_factor, random_triad_sample_list, random_dyad_sample_list, use_triad_sampling, num_unique_random_triad_samples, rowwise_distribution));
+    rcpp_result_gen = Rcpp::wrap(Distribution_Metropolis_Hastings_Sampler(number_of_iterations, variance, number_of_nodes, statistics_to_use, initial_network, take_sample_every, thetas, triples, pairs, alphas, together, seed, number_of_samples_to_store, parallel, use_selected_rows, save_statistics_selected_rows_matrix, rows_to_use, base_statistics_to_save, base_statistic_alphas, num_non_base_statistics, non_base_statistic_indicator, p_ratio_multaplicative_factor, stochastic_MH_proportion, use_triad_sampling, rowwise_distribution));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -298,6 +577,120 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// Network_Distance_Matrix
+arma::mat Network_Distance_Matrix(arma::cube first, arma::cube second, int norm_type, bool same_set);
+RcppExport SEXP _GERGM_Network_Distance_Matrix(SEXP firstSEXP, SEXP secondSEXP, SEXP norm_typeSEXP, SEXP same_setSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< arma::cube >::type first(firstSEXP);
+    Rcpp::traits::input_parameter< arma::cube >::type second(secondSEXP);
+    Rcpp::traits::input_parameter< int >::type norm_type(norm_typeSEXP);
+    Rcpp::traits::input_parameter< bool >::type same_set(same_setSEXP);
+    rcpp_result_gen = Rcpp::wrap(Network_Distance_Matrix(first, second, norm_type, same_set));
+    return rcpp_result_gen;
+END_RCPP
+}
+// GERGM_Model_HMC_Sampler
+List GERGM_Model_HMC_Sampler(SEXP model, int number_of_iterations, double step_size, int leapfrog_steps, int adapt_iterations, double target_acceptance, arma::mat initial_network, int take_sample_every, arma::vec thetas, int seed, int number_of_samples_to_store, int network_storage, std::string sample_file, Rcpp::CharacterVector statistic_names, int first_sample);
+RcppExport SEXP _GERGM_GERGM_Model_HMC_Sampler(SEXP modelSEXP, SEXP number_of_iterationsSEXP, SEXP step_sizeSEXP, SEXP leapfrog_stepsSEXP, SEXP adapt_iterationsSEXP, SEXP target_acceptanceSEXP, SEXP initial_networkSEXP, SEXP take_sample_everySEXP, SEXP thetasSEXP, SEXP seedSEXP, SEXP number_of_samples_to_storeSEXP, SEXP network_storageSEXP, SEXP sample_fileSEXP, SEXP statistic_namesSEXP, SEXP first_sampleSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type model(modelSEXP);
+    Rcpp::traits::input_parameter< int >::type number_of_iterations(number_of_iterationsSEXP);
+    Rcpp::traits::input_parameter< double >::type step_size(step_sizeSEXP);
+    Rcpp::traits::input_parameter< int >::type leapfrog_steps(leapfrog_stepsSEXP);
+    Rcpp::traits::input_parameter< int >::type adapt_iterations(adapt_iterationsSEXP);
+    Rcpp::traits::input_parameter< double >::type target_acceptance(target_acceptanceSEXP);
+    Rcpp::traits::input_parameter< arma::mat >::type initial_network(initial_networkSEXP);
+    Rcpp::traits::input_parameter< int >::type take_sample_every(take_sample_everySEXP);
+    Rcpp::traits::input_parameter< arma::vec >::type thetas(thetasSEXP);
+    Rcpp::traits::input_parameter< int >::type seed(seedSEXP);
+    Rcpp::traits::input_parameter< int >::type number_of_samples_to_store(number_of_samples_to_storeSEXP);
+    Rcpp::traits::input_parameter< int >::type network_storage(network_storageSEXP);
+    Rcpp::traits::input_parameter< std::string >::type sample_file(sample_fileSEXP);
+    Rcpp::traits::input_parameter< Rcpp::CharacterVector >::type statistic_names(statistic_namesSEXP);
+    Rcpp::traits::input_parameter< int >::type first_sample(first_sampleSEXP);
+    rcpp_result_gen = Rcpp::wrap(GERGM_Model_HMC_Sampler(model, number_of_iterations, step_size, leapfrog_steps, adapt_iterations, target_acceptance, initial_network, take_sample_every, thetas, seed, number_of_samples_to_store, network_storage, sample_file, statistic_names, first_sample));
+    return rcpp_result_gen;
+END_RCPP
+}
+// H_Function_Logit_Gradient
+List H_Function_Logit_Gradient(SEXP model, arma::mat network, arma::vec thetas);
+RcppExport SEXP _GERGM_H_Function_Logit_Gradient(SEXP modelSEXP, SEXP networkSEXP, SEXP thetasSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type model(modelSEXP);
+    Rcpp::traits::input_parameter< arma::mat >::type network(networkSEXP);
+    Rcpp::traits::input_parameter< arma::vec >::type thetas(thetasSEXP);
+    rcpp_result_gen = Rcpp::wrap(H_Function_Logit_Gradient(model, network, thetas));
+    return rcpp_result_gen;
+END_RCPP
+}
+// Create_Importance_Sampling_Likelihood
+SEXP Create_Importance_Sampling_Likelihood(arma::mat simulated_statistics, arma::vec observed_statistics, arma::vec ltheta);
+RcppExport SEXP _GERGM_Create_Importance_Sampling_Likelihood(SEXP simulated_statisticsSEXP, SEXP observed_statisticsSEXP, SEXP lthetaSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< arma::mat >::type simulated_statistics(simulated_statisticsSEXP);
+    Rcpp::traits::input_parameter< arma::vec >::type observed_statistics(observed_statisticsSEXP);
+    Rcpp::traits::input_parameter< arma::vec >::type ltheta(lthetaSEXP);
+    rcpp_result_gen = Rcpp::wrap(Create_Importance_Sampling_Likelihood(simulated_statistics, observed_statistics, ltheta));
+    return rcpp_result_gen;
+END_RCPP
+}
+// Importance_Sampling_Log_Likelihood
+List Importance_Sampling_Log_Likelihood(SEXP likelihood, arma::vec theta, bool calculate_hessian);
+RcppExport SEXP _GERGM_Importance_Sampling_Log_Likelihood(SEXP likelihoodSEXP, SEXP thetaSEXP, SEXP calculate_hessianSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type likelihood(likelihoodSEXP);
+    Rcpp::traits::input_parameter< arma::vec >::type theta(thetaSEXP);
+    Rcpp::traits::input_parameter< bool >::type calculate_hessian(calculate_hessianSEXP);
+    rcpp_result_gen = Rcpp::wrap(Importance_Sampling_Log_Likelihood(likelihood, theta, calculate_hessian));
+    return rcpp_result_gen;
+END_RCPP
+}
+// Importance_Sampling_Newton
+List Importance_Sampling_Newton(SEXP likelihood, arma::vec theta, int max_iterations, double tolerance, bool verbose);
+RcppExport SEXP _GERGM_Importance_Sampling_Newton(SEXP likelihoodSEXP, SEXP thetaSEXP, SEXP max_iterationsSEXP, SEXP toleranceSEXP, SEXP verboseSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type likelihood(likelihoodSEXP);
+    Rcpp::traits::input_parameter< arma::vec >::type theta(thetaSEXP);
+    Rcpp::traits::input_parameter< int >::type max_iterations(max_iterationsSEXP);
+    Rcpp::traits::input_parameter< double >::type tolerance(toleranceSEXP);
+    Rcpp::traits::input_parameter< bool >::type verbose(verboseSEXP);
+    rcpp_result_gen = Rcpp::wrap(Importance_Sampling_Newton(likelihood, theta, max_iterations, tolerance, verbose));
+    return rcpp_result_gen;
+END_RCPP
+}
+// Gibbs_Network_Sampler
+List Gibbs_Network_Sampler(int number_of_iterations, int number_of_nodes, arma::vec statistics_to_use, arma::mat initial_network, int take_sample_every, arma::vec thetas, arma::vec alphas, int together, int seed, int number_of_samples_to_store, int undirect_network);
+RcppExport SEXP _GERGM_Gibbs_Network_Sampler(SEXP number_of_iterationsSEXP, SEXP number_of_nodesSEXP, SEXP statistics_to_useSEXP, SEXP initial_networkSEXP, SEXP take_sample_everySEXP, SEXP thetasSEXP, SEXP alphasSEXP, SEXP togetherSEXP, SEXP seedSEXP, SEXP number_of_samples_to_storeSEXP, SEXP undirect_networkSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< int >::type number_of_iterations(number_of_iterationsSEXP);
+    Rcpp::traits::input_parameter< int >::type number_of_nodes(number_of_nodesSEXP);
+    Rcpp::traits::input_parameter< arma::vec >::type statistics_to_use(statistics_to_useSEXP);
+    Rcpp::traits::input_parameter< arma::mat >::type initial_network(initial_networkSEXP);
+    Rcpp::traits::input_parameter< int >::type take_sample_every(take_sample_everySEXP);
+    Rcpp::traits::input_parameter< arma::vec >::type thetas(thetasSEXP);
+    Rcpp::traits::input_parameter< arma::vec >::type alphas(alphasSEXP);
+    Rcpp::traits::input_parameter< int >::type together(togetherSEXP);
+    Rcpp::traits::input_parameter< int >::type seed(seedSEXP);
+    Rcpp::traits::input_parameter< int >::type number_of_samples_to_store(number_of_samples_to_storeSEXP);
+    Rcpp::traits::input_parameter< int >::type undirect_network(undirect_networkSEXP);
+    rcpp_result_gen = Rcpp::wrap(Gibbs_Network_Sampler(number_of_iterations, number_of_nodes, statistics_to_use, initial_network, take_sample_every, thetas, alphas, together, seed, number_of_samples_to_store, undirect_network));
+    return rcpp_result_gen;
+END_RCPP
+}
 // Metropolis_Hastings_Sampler
 List Metropolis_Hastings_Sampler(int number_of_iterations, double shape_parameter, int number_of_nodes, arma::vec statistics_to_use, arma::mat initial_network, int take_sample_every, arma::vec thetas, arma::mat triples, arma::mat pairs, arma::vec alphas, int together, int seed, int number_of_samples_to_store, int using_correlation_network, int undirect_network, bool parallel);
 RcppExport SEXP _GERGM_Metropolis_Hastings_Sampler(SEXP number_of_iterationsSEXP, SEXP shape_parameterSEXP, SEXP number_of_nodesSEXP, SEXP statistics_to_useSEXP, SEXP initial_networkSEXP, SEXP take_sample_everySEXP, SEXP thetasSEXP, SEXP triplesSEXP, SEXP pairsSEXP, SEXP alphasSEXP, SEXP togetherSEXP, SEXP seedSEXP, SEXP number_of_samples_to_storeSEXP, SEXP using_correlation_networkSEXP, SEXP undirect_networkSEXP, SEXP parallelSEXP) {
@@ -324,6 +717,87 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// Decode_Network_Samples
+NumericVector Decode_Network_Samples(RawVector samples, arma::uvec sample_indices);
+RcppExport SEXP _GERGM_Decode_Network_Samples(SEXP samplesSEXP, SEXP sample_indicesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< RawVector >::type samples(samplesSEXP);
+    Rcpp::traits::input_parameter< arma::uvec >::type sample_indices(sample_indicesSEXP);
+    rcpp_result_gen = Rcpp::wrap(Decode_Network_Samples(samples, sample_indices));
+    return rcpp_result_gen;
+END_RCPP
+}
+// Select_Network_Samples
+RawVector Select_Network_Samples(RawVector samples, arma::uvec sample_indices);
+RcppExport SEXP _GERGM_Select_Network_Samples(SEXP samplesSEXP, SEXP sample_indicesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< RawVector >::type samples(samplesSEXP);
+    Rcpp::traits::input_parameter< arma::uvec >::type sample_indices(sample_indicesSEXP);
+    rcpp_result_gen = Rcpp::wrap(Select_Network_Samples(samples, sample_indices));
+    return rcpp_result_gen;
+END_RCPP
+}
+// Parallel_Sum
+double Parallel_Sum(arma::vec values, int chunk_size);
+RcppExport SEXP _GERGM_Parallel_Sum(SEXP valuesSEXP, SEXP chunk_sizeSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< arma::vec >::type values(valuesSEXP);
+    Rcpp::traits::input_parameter< int >::type chunk_size(chunk_sizeSEXP);
+    rcpp_result_gen = Rcpp::wrap(Parallel_Sum(values, chunk_size));
+    return rcpp_result_gen;
+END_RCPP
+}
+// Open_Sample_File
+SEXP Open_Sample_File(std::string path);
+RcppExport SEXP _GERGM_Open_Sample_File(SEXP pathSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type path(pathSEXP);
+    rcpp_result_gen = Rcpp::wrap(Open_Sample_File(path));
+    return rcpp_result_gen;
+END_RCPP
+}
+// Sample_File_Is_Open
+bool Sample_File_Is_Open(SEXP file);
+RcppExport SEXP _GERGM_Sample_File_Is_Open(SEXP fileSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type file(fileSEXP);
+    rcpp_result_gen = Rcpp::wrap(Sample_File_Is_Open(file));
+    return rcpp_result_gen;
+END_RCPP
+}
+// Sample_File_Info
+List Sample_File_Info(SEXP file);
+RcppExport SEXP _GERGM_Sample_File_Info(SEXP fileSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type file(fileSEXP);
+    rcpp_result_gen = Rcpp::wrap(Sample_File_Info(file));
+    return rcpp_result_gen;
+END_RCPP
+}
+// Sample_File_Networks
+NumericVector Sample_File_Networks(SEXP file, arma::uvec sample_indices);
+RcppExport SEXP _GERGM_Sample_File_Networks(SEXP fileSEXP, SEXP sample_indicesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type file(fileSEXP);
+    Rcpp::traits::input_parameter< arma::uvec >::type sample_indices(sample_indicesSEXP);
+    rcpp_result_gen = Rcpp::wrap(Sample_File_Networks(file, sample_indices));
+    return rcpp_result_gen;
+END_RCPP
+}
 // weighted_mple_objective
 double weighted_mple_objective(int number_of_nodes, arma::vec statistics_to_use, arma::mat current_network, arma::vec thetas, arma::mat triples, arma::mat pairs, arma::vec alphas, int together, arma::vec integration_interval, bool parallel);
 RcppExport SEXP _GERGM_weighted_mple_objective(SEXP number_of_nodesSEXP, SEXP statistics_to_useSEXP, SEXP current_networkSEXP, SEXP thetasSEXP, SEXP triplesSEXP, SEXP pairsSEXP, SEXP alphasSEXP, SEXP togetherSEXP, SEXP integration_intervalSEXP, SEXP parallelSEXP) {
@@ -347,18 +821,50 @@ END_RCPP
 
 static const R_CallMethodDef CallEntries[] = {
     {"_GERGM_Corr_to_Part", (DL_FUNC) &_GERGM_Corr_to_Part, 3},
-    {"_GERGM_Extended_Metropolis_Hastings_Sampler", (DL_FUNC) &_GERGM_Extended_Metropolis_Hastings_Sampler, 29},
+    {"_GERGM_Part_to_Corr", (DL_FUNC) &_GERGM_Part_to_Corr, 1},
+    {"_GERGM_Log_Jacobian", (DL_FUNC) &_GERGM_Log_Jacobian, 1},
+    {"_GERGM_Log_Jacobian_Delta", (DL_FUNC) &_GERGM_Log_Jacobian_Delta, 5},
+    {"_GERGM_Extended_Metropolis_Hastings_Sampler", (DL_FUNC) &_GERGM_Extended_Metropolis_Hastings_Sampler, 28},
+    {"_GERGM_Create_GERGM_Model", (DL_FUNC) &_GERGM_Create_GERGM_Model, 20},
+    {"_GERGM_GERGM_Model_Is_Valid", (DL_FUNC) &_GERGM_GERGM_Model_Is_Valid, 1},
+    {"_GERGM_GERGM_Model_MH_Sampler", (DL_FUNC) &_GERGM_GERGM_Model_MH_Sampler, 13},
+    {"_GERGM_Start_GERGM_Model_MH_Sampler", (DL_FUNC) &_GERGM_Start_GERGM_Model_MH_Sampler, 10},
+    {"_GERGM_MH_Sampler_Progress", (DL_FUNC) &_GERGM_MH_Sampler_Progress, 1},
+    {"_GERGM_MH_Sampler_Partial_Output", (DL_FUNC) &_GERGM_MH_Sampler_Partial_Output, 1},
+    {"_GERGM_Cancel_MH_Sampler", (DL_FUNC) &_GERGM_Cancel_MH_Sampler, 1},
+    {"_GERGM_MH_Sampler_Result", (DL_FUNC) &_GERGM_MH_Sampler_Result, 1},
+    {"_GERGM_GERGM_Model_Multi_Theta_MH_Sampler", (DL_FUNC) &_GERGM_GERGM_Model_Multi_Theta_MH_Sampler, 11},
+    {"_GERGM_GERGM_Model_h_statistics", (DL_FUNC) &_GERGM_GERGM_Model_h_statistics, 2},
+    {"_GERGM_GERGM_Model_MPLE_Objective", (DL_FUNC) &_GERGM_GERGM_Model_MPLE_Objective, 6},
+    {"_GERGM_GERGM_Model_Stochastic_h_Values", (DL_FUNC) &_GERGM_GERGM_Model_Stochastic_h_Values, 5},
+    {"_GERGM_alias_table_counts", (DL_FUNC) &_GERGM_alias_table_counts, 3},
+    {"_GERGM_GERGM_Model_Network_Cube_Statistics", (DL_FUNC) &_GERGM_GERGM_Model_Network_Cube_Statistics, 5},
     {"_GERGM_h_statistics", (DL_FUNC) &_GERGM_h_statistics, 12},
     {"_GERGM_extended_weighted_mple_objective", (DL_FUNC) &_GERGM_extended_weighted_mple_objective, 16},
     {"_GERGM_mple_distribution_objective", (DL_FUNC) &_GERGM_mple_distribution_objective, 16},
     {"_GERGM_get_indiviual_triad_values", (DL_FUNC) &_GERGM_get_indiviual_triad_values, 4},
     {"_GERGM_get_triad_weights", (DL_FUNC) &_GERGM_get_triad_weights, 5},
-    {"_GERGM_Individual_Edge_Conditional_Prediction", (DL_FUNC) &_GERGM_Individual_Edge_Conditional_Prediction, 30},
-    {"_GERGM_Distribution_Metropolis_Hastings_Sampler", (DL_FUNC) &_GERGM_Distribution_Metropolis_Hastings_Sampler, 27},
+    {"_GERGM_Individual_Edge_Conditional_Prediction", (DL_FUNC) &_GERGM_Individual_Edge_Conditional_Prediction, 28},
+    {"_GERGM_Batch_Edge_Conditional_Prediction", (DL_FUNC) &_GERGM_Batch_Edge_Conditional_Prediction, 18},
+    {"_GERGM_Distribution_Metropolis_Hastings_Sampler", (DL_FUNC) &_GERGM_Distribution_Metropolis_Hastings_Sampler, 25},
     {"_GERGM_log_space_multinomial_sampler", (DL_FUNC) &_GERGM_log_space_multinomial_sampler, 2},
     {"_GERGM_Edge_Group_MH_Sampler", (DL_FUNC) &_GERGM_Edge_Group_MH_Sampler, 26},
     {"_GERGM_frobenius_norm", (DL_FUNC) &_GERGM_frobenius_norm, 2},
+    {"_GERGM_Network_Distance_Matrix", (DL_FUNC) &_GERGM_Network_Distance_Matrix, 4},
+    {"_GERGM_GERGM_Model_HMC_Sampler", (DL_FUNC) &_GERGM_GERGM_Model_HMC_Sampler, 15},
+    {"_GERGM_H_Function_Logit_Gradient", (DL_FUNC) &_GERGM_H_Function_Logit_Gradient, 3},
+    {"_GERGM_Create_Importance_Sampling_Likelihood", (DL_FUNC) &_GERGM_Create_Importance_Sampling_Likelihood, 3},
+    {"_GERGM_Importance_Sampling_Log_Likelihood", (DL_FUNC) &_GERGM_Importance_Sampling_Log_Likelihood, 3},
+    {"_GERGM_Importance_Sampling_Newton", (DL_FUNC) &_GERGM_Importance_Sampling_Newton, 5},
+    {"_GERGM_Gibbs_Network_Sampler", (DL_FUNC) &_GERGM_Gibbs_Network_Sampler, 11},
     {"_GERGM_Metropolis_Hastings_Sampler", (DL_FUNC) &_GERGM_Metropolis_Hastings_Sampler, 16},
+    {"_GERGM_Decode_Network_Samples", (DL_FUNC) &_GERGM_Decode_Network_Samples, 2},
+    {"_GERGM_Select_Network_Samples", (DL_FUNC) &_GERGM_Select_Network_Samples, 2},
+    {"_GERGM_Parallel_Sum", (DL_FUNC) &_GERGM_Parallel_Sum, 2},
+    {"_GERGM_Open_Sample_File", (DL_FUNC) &_GERGM_Open_Sample_File, 1},
+    {"_GERGM_Sample_File_Is_Open", (DL_FUNC) &_GERGM_Sample_File_Is_Open, 1},
+    {"_GERGM_Sample_File_Info", (DL_FUNC) &_GERGM_Sample_File_Info, 1},
+    {"_GERGM_Sample_File_Networks", (DL_FUNC) &_GERGM_Sample_File_Networks, 2},
     {"_GERGM_weighted_mple_objective", (DL_FUNC) &_GERGM_weighted_mple_objective, 10},
     {NULL, NULL, 0}
 };
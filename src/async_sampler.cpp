@@ -0,0 +1,105 @@
+// [[Rcpp::depends(RcppArmadillo)]]
+// [[Rcpp::depends(RcppParallel)]]
+
+#include "gergm_r.h"
+
+// Metropolis Hastings runs in the background (see gergm/async_sampler.h).
+// Start_GERGM_Model_MH_Sampler takes the same arguments as
+// GERGM_Model_MH_Sampler and returns a handle straight away, which can be
+// polled for progress and the samples taken so far, cancelled, and waited on
+// for the same list GERGM_Model_MH_Sampler returns. Garbage collecting the
+// handle cancels the run.
+
+using namespace Rcpp;
+
+namespace gergm {
+
+inline AsyncMetropolisHastings& run_from_r(SEXP run) {
+  Rcpp::XPtr<AsyncMetropolisHastings> handle(run);
+  return *handle;
+}
+
+} // end of gergm namespace
+
+// [[Rcpp::export]]
+SEXP Start_GERGM_Model_MH_Sampler(SEXP model,
+                                  int number_of_iterations,
+                                  double shape_parameter,
+                                  arma::mat initial_network,
+                                  int take_sample_every,
+                                  arma::vec thetas,
+                                  int seed,
+                                  int number_of_samples_to_store,
+                                  bool parallel,
+                                  int network_storage = 0) {
+  gergm::check_network_storage(network_storage);
+  Rcpp::XPtr<gergm::GergmModel> compiled_model(model);
+  gergm::AsyncMetropolisHastings* run = new gergm::AsyncMetropolisHastings(
+    *compiled_model,
+    number_of_iterations,
+    shape_parameter,
+    initial_network,
+    take_sample_every,
+    thetas,
+    seed,
+    number_of_samples_to_store,
+    parallel,
+    network_storage);
+  // the handle keeps the model alive for as long as the run needs it
+  return Rcpp::XPtr<gergm::AsyncMetropolisHastings>(run, true, R_NilValue,
+                                                    model);
+}
+
+// remaining_seconds is NA until the first iteration is done.
+// [[Rcpp::export]]
+List MH_Sampler_Progress(SEXP run) {
+  gergm::AsyncMetropolisHastings& sampler = gergm::run_from_r(run);
+  bool finished = sampler.finished();
+  gergm::SamplerProgress progress = sampler.progress();
+  double remaining_seconds = progress.remaining_seconds;
+  if (remaining_seconds < 0) {
+    remaining_seconds = NA_REAL;
+  }
+  return List::create(
+    Named("iterations_done") = progress.iterations_done,
+    Named("number_of_iterations") = progress.number_of_iterations,
+    Named("samples_stored") = progress.samples_stored,
+    Named("acceptance_rate") = progress.acceptance_rate,
+    Named("elapsed_seconds") = progress.elapsed_seconds,
+    Named("remaining_seconds") = remaining_seconds,
+    Named("cancelled") = progress.cancel_requested,
+    Named("finished") = finished);
+}
+
+// The iterations and samples done so far, in the form GERGM_Model_MH_Sampler
+// returns them (without a profile).
+// [[Rcpp::export]]
+List MH_Sampler_Partial_Output(SEXP run) {
+  gergm::AsyncMetropolisHastings& sampler = gergm::run_from_r(run);
+  gergm::MetropolisHastingsOutput partial;
+  sampler.partial_output(partial);
+  List to_return = gergm::metropolis_hastings_output_to_r(
+    sampler.sampler_model(), partial);
+  to_return[9] = R_NilValue;
+  return to_return;
+}
+
+// The run stops after the iteration in progress, keeping what it has done.
+// [[Rcpp::export]]
+void Cancel_MH_Sampler(SEXP run) {
+  gergm::run_from_r(run).cancel();
+}
+
+// Waits for the run to finish. Interrupting the wait leaves the run going.
+// The result has a "cancelled" attribute, TRUE when it was cancelled before
+// finishing all of its iterations.
+// [[Rcpp::export]]
+List MH_Sampler_Result(SEXP run) {
+  gergm::AsyncMetropolisHastings& sampler = gergm::run_from_r(run);
+  gergm::wait_checking_interrupts(sampler);
+  const gergm::MetropolisHastingsOutput& output = sampler.result();
+  List to_return = gergm::metropolis_hastings_output_to_r(
+    sampler.sampler_model(), output);
+  to_return.attr("cancelled") = output.cancelled;
+  return to_return;
+}
@@ -1,5 +1,7 @@
 #include <RcppArmadillo.h>
+#include <RcppParallel.h>
 //[[Rcpp::depends(RcppArmadillo)]]
+//[[Rcpp::depends(RcppParallel)]]
 using namespace Rcpp;
 
 using std::abs;
@@ -26,3 +28,111 @@ double frobenius_norm(
     distance = sqrt(distance);
     return distance;
 }
+
+namespace gergm {
+
+// L1 (norm_type 1) or max-norm (norm_type 2) distances between the columns
+// of first and second, one row of the distance matrix per task. Each pair is a
+// single pass over two contiguous columns. When same_set is true only the
+// upper triangle is calculated and it is mirrored afterwards.
+struct Parallel_Network_Distances : public RcppParallel::Worker {
+
+  const arma::mat& first;
+  const arma::mat& second;
+  int norm_type;
+  bool same_set;
+  RcppParallel::RMatrix<double> distances;
+
+  Parallel_Network_Distances(const arma::mat& first,
+                             const arma::mat& second,
+                             int norm_type,
+                             bool same_set,
+                             Rcpp::NumericMatrix distances)
+    : first(first),
+      second(second),
+      norm_type(norm_type),
+      same_set(same_set),
+      distances(distances) {}
+
+  void operator()(std::size_t begin, std::size_t end) {
+    int length = first.n_rows;
+    int number_of_second = second.n_cols;
+    for (std::size_t a = begin; a < end; a++) {
+      const double* x = first.colptr(a);
+      int start = 0;
+      if (same_set) {
+        start = a + 1;
+      }
+      for (int b = start; b < number_of_second; ++b) {
+        const double* y = second.colptr(b);
+        double distance = 0;
+        if (norm_type == 1) {
+          for (int k = 0; k < length; ++k) {
+            distance += abs(x[k] - y[k]);
+          }
+        } else {
+          for (int k = 0; k < length; ++k) {
+            distance = std::max(distance, abs(x[k] - y[k]));
+          }
+        }
+        distances(a, b) = distance;
+      }
+    }
+  }
+};
+
+} // end of gergm namespace
+
+// Distance between every network in first and every network in second, as a
+// slices(first) x slices(second) matrix. norm_type is 0 for the Frobenius
+// norm, 1 for the sum of absolute differences and 2 for the maximum absolute
+// difference. Set same_set to true when second is first, to only calculate
+// half of the (symmetric) matrix. Frobenius distances use
+// ||A - B||^2 = ||A||^2 + ||B||^2 - 2 <A, B>, so the cross terms for all
+// pairs are a single matrix product.
+// [[Rcpp::export]]
+arma::mat Network_Distance_Matrix(arma::cube first,
+                                  arma::cube second,
+                                  int norm_type,
+                                  bool same_set) {
+
+  // view each cube as a matrix with one network per column, no copy
+  arma::mat first_columns(first.memptr(), first.n_rows * first.n_cols,
+                          first.n_slices, false, true);
+  arma::mat second_columns(second.memptr(), second.n_rows * second.n_cols,
+                           second.n_slices, false, true);
+
+  if (norm_type == 0) {
+    arma::rowvec first_norms = arma::sum(arma::square(first_columns), 0);
+    arma::rowvec second_norms = arma::sum(arma::square(second_columns), 0);
+    arma::mat distances = -2 * first_columns.t() * second_columns;
+    distances.each_col() += first_norms.t();
+    distances.each_row() += second_norms;
+    // rounding can leave tiny negative values for (near) identical networks
+    distances.elem(arma::find(distances < 0)).zeros();
+    distances = arma::sqrt(distances);
+    if (same_set) {
+      distances.diag().zeros();
+      distances = arma::symmatu(distances);
+    }
+    return distances;
+  }
+
+  if (norm_type != 1 && norm_type != 2) {
+    Rcpp::stop("norm_type must be 0 (Frobenius), 1 (L1) or 2 (max).");
+  }
+
+  Rcpp::NumericMatrix distances(first.n_slices, second.n_slices);
+  gergm::Parallel_Network_Distances Parallel_Network_Distances(first_columns,
+                                                               second_columns,
+                                                               norm_type,
+                                                               same_set,
+                                                               distances);
+  RcppParallel::parallelFor(0, first.n_slices, Parallel_Network_Distances);
+
+  arma::mat to_return(distances.begin(), distances.nrow(), distances.ncol());
+  if (same_set) {
+    to_return = arma::symmatu(to_return);
+  }
+  return to_return;
+}
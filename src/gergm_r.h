@@ -0,0 +1,224 @@
+#ifndef GERGM_R_H
+#define GERGM_R_H
+
+// Glue between the core library in inst/include/gergm and R: the core's
+// parallel loops are run on RcppParallel's thread pool, sampler profiles and
+// outputs are converted to R lists, and archived network samples to raw
+// vectors and arrays.
+
+#include <RcppParallel.h>
+#include <RcppArmadillo.h>
+#include <gergm/gergm.h>
+
+namespace gergm {
+
+struct Parallel_Range : public RcppParallel::Worker {
+  const RangeBody& body;
+
+  Parallel_Range(const RangeBody& body)
+    : body(body) {}
+
+  void operator()(std::size_t begin, std::size_t end) {
+    body(begin, end);
+  }
+};
+
+inline void rcpp_parallel_for(std::size_t begin,
+                              std::size_t end,
+                              const RangeBody& body) {
+  Parallel_Range worker(body);
+  RcppParallel::parallelFor(begin, end, worker);
+}
+
+// set when the package is loaded, in every file that includes this header
+static const bool rcpp_parallel_backend_registered =
+  (parallel_for_backend() = &rcpp_parallel_for, true);
+
+// statistic_codes are the (0 based) statistics the h function evaluates,
+// their call counts are all statistic_evaluations.
+inline Rcpp::List profile_to_list(const SamplerProfile& profile,
+                                  const arma::vec& statistic_codes) {
+  Rcpp::NumericVector statistic_calls(statistic_codes.n_elem,
+                                      profile.statistic_evaluations);
+  Rcpp::CharacterVector names(statistic_codes.n_elem);
+  const char* statistic_names[] = {"out2stars", "in2stars", "ctriads",
+                                   "mutual", "ttriads", "edges", "diagonal"};
+  for (arma::uword s = 0; s < statistic_codes.n_elem; ++s) {
+    int code = int(statistic_codes[s]);
+    if (code >= 0 && code < 7) {
+      names[s] = statistic_names[code];
+    }
+  }
+  statistic_calls.names() = names;
+  return Rcpp::List::create(
+    Rcpp::Named("proposal_seconds") = profile.proposal_seconds,
+    Rcpp::Named("statistic_seconds") = profile.statistic_seconds,
+    Rcpp::Named("correlation_transform_seconds") =
+      profile.correlation_transform_seconds,
+    Rcpp::Named("accept_seconds") = profile.accept_seconds,
+    Rcpp::Named("storage_seconds") = profile.storage_seconds,
+    Rcpp::Named("statistic_evaluations") = profile.statistic_evaluations,
+    Rcpp::Named("statistic_calls") = statistic_calls,
+    Rcpp::Named("proposal_draws") = profile.proposal_draws,
+    Rcpp::Named("proposed_edges") = profile.proposed_edges,
+    Rcpp::Named("bytes_copied") = profile.bytes_copied);
+}
+
+// Archived samples go to R as a raw vector of class gergm_network_samples,
+// with the dimensions of the array it stands for (see R/network_samples.R).
+// packed is true when each sample is a packed lower triangle.
+inline Rcpp::RawVector archive_to_r(const NetworkSampleArchive& archive,
+                                    int number_of_nodes,
+                                    bool packed,
+                                    bool include_diagonal) {
+  std::vector<unsigned char> bytes;
+  archive.serialize(bytes);
+  Rcpp::RawVector samples(bytes.begin(), bytes.end());
+  samples.attr("network_dim") = Rcpp::IntegerVector::create(
+    number_of_nodes, number_of_nodes, int(archive.number_of_samples()));
+  samples.attr("network_storage") = archive.storage_type();
+  samples.attr("packed") = packed;
+  samples.attr("include_diagonal") = include_diagonal;
+  samples.attr("class") = "gergm_network_samples";
+  return samples;
+}
+
+inline NetworkSampleArchive archive_from_r(const Rcpp::RawVector& samples) {
+  try {
+    return NetworkSampleArchive::deserialize(RAW(samples), samples.size());
+  } catch (std::exception& error) {
+    Rcpp::stop(error.what());
+  }
+}
+
+// Decodes in place, samples must outlive the view.
+inline NetworkSampleArchiveView archive_view_from_r(
+    const Rcpp::RawVector& samples) {
+  try {
+    return NetworkSampleArchiveView(RAW(samples), samples.size());
+  } catch (std::exception& error) {
+    Rcpp::stop(error.what());
+  }
+}
+
+// Decode the (0 based) samples of an archive or archive view into an
+// n x n x samples R array.
+template<class Archive>
+Rcpp::NumericVector decode_network_samples(const Archive& archive,
+                                           const arma::uvec& sample_indices,
+                                           int number_of_nodes,
+                                           bool packed,
+                                           bool include_diagonal) {
+  for (arma::uword s = 0; s < sample_indices.n_elem; ++s) {
+    if (sample_indices[s] >= archive.number_of_samples()) {
+      Rcpp::stop("Network sample index out of range.");
+    }
+  }
+  Rcpp::NumericVector networks(Rcpp::Dimension(number_of_nodes,
+                                               number_of_nodes,
+                                               sample_indices.n_elem));
+  int network_size = number_of_nodes * number_of_nodes;
+  // consecutive samples only apply their own changes to the previous one
+  std::vector<double> values(archive.sample_length());
+  for (arma::uword s = 0; s < sample_indices.n_elem; ++s) {
+    bool consecutive = s > 0 &&
+      sample_indices[s] == sample_indices[s - 1] + 1;
+    archive.decode(sample_indices[s], values.data(), consecutive);
+    double* network = networks.begin() + s * network_size;
+    if (packed) {
+      unpack_network(values.data(), network, number_of_nodes,
+                     include_diagonal);
+    } else {
+      std::copy(values.begin(), values.end(), network);
+    }
+  }
+  return networks;
+}
+
+} // end of gergm namespace
+
+// the profile to return to R, NULL unless compiled with GERGM_PROFILE
+#ifdef GERGM_PROFILE
+#define GERGM_PROFILE_RESULT(profile, statistic_codes) \
+  gergm::profile_to_list(profile, statistic_codes)
+#else
+#define GERGM_PROFILE_RESULT(profile, statistic_codes) R_NilValue
+#endif
+
+namespace gergm {
+
+// Expand packed lower triangles (one network per column) into an
+// n x n x samples R array of symmetric networks.
+inline Rcpp::NumericVector unpack_network_samples(const arma::mat& packed,
+                                                  int number_of_nodes,
+                                                  bool include_diagonal) {
+  int number_of_samples = packed.n_cols;
+  Rcpp::NumericVector networks(Rcpp::Dimension(number_of_nodes,
+                                               number_of_nodes,
+                                               number_of_samples));
+  int network_size = number_of_nodes * number_of_nodes;
+  for (int s = 0; s < number_of_samples; ++s) {
+    unpack_network(packed.colptr(s),
+                   networks.begin() + s * network_size,
+                   number_of_nodes,
+                   include_diagonal);
+  }
+  return networks;
+}
+
+// The list the Metropolis Hastings samplers return to R. The networks are an
+// array, or a gergm_network_samples raw vector for any network_storage other
+// than STORE_DOUBLE. If sample_file is given the statistics and networks are
+// written to it (see gergm/sample_file.h) and the networks are not returned.
+inline Rcpp::List metropolis_hastings_output_to_r(
+    const GergmModel& model,
+    const MetropolisHastingsOutput& output,
+    const std::string& sample_file = "",
+    const SampleFileInfo& sample_file_info = SampleFileInfo()) {
+  Rcpp::List to_return(10);
+  to_return[0] = output.Accept_or_Reject;
+  if (!sample_file.empty()) {
+    write_sample_file(sample_file, model, sample_file_info, output);
+    to_return[1] = R_NilValue;
+  } else if (output.network_storage != STORE_DOUBLE) {
+    to_return[1] = archive_to_r(output.Archived_Network_Samples,
+                                model.number_of_nodes,
+                                output.packed_networks,
+                                model.include_diagonal);
+  } else if (output.packed_networks) {
+    to_return[1] = unpack_network_samples(output.Packed_Network_Samples,
+                                          model.number_of_nodes,
+                                          model.include_diagonal);
+  } else {
+    to_return[1] = output.Network_Samples;
+  }
+  to_return[2] = output.Save_H_Statistics;
+  to_return[3] = output.Mean_Edge_Weights;
+  to_return[4] = output.Log_Prob_Accept;
+  to_return[5] = output.P_Ratios;
+  to_return[6] = output.Q_Ratios;
+  to_return[7] = output.Proposed_Density;
+  to_return[8] = output.Current_Density;
+  // phase timings and counters, NULL unless compiled with GERGM_PROFILE
+  to_return[9] = GERGM_PROFILE_RESULT(output.profile, model.statistics_to_use);
+  return to_return;
+}
+
+inline void check_network_storage(int network_storage) {
+  if (network_storage < STORE_DOUBLE || network_storage > STORE_DELTA) {
+    Rcpp::stop("network_storage must be 0 (double), 1 (float), 2 (fixed16) or 3 (delta).");
+  }
+}
+
+// Wait for a background run, checking for a user interrupt every tenth of a
+// second. An interrupt is passed on to R as an exception, which cancels the
+// run if it unwinds past its owner.
+inline void wait_checking_interrupts(AsyncMetropolisHastings& run) {
+  while (!run.wait_for(100)) {
+    Rcpp::checkUserInterrupt();
+  }
+}
+
+} // end of gergm namespace
+
+#endif
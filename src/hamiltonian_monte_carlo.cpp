@@ -0,0 +1,89 @@
+// [[Rcpp::depends(RcppArmadillo)]]
+// [[Rcpp::depends(RcppParallel)]]
+
+#include "gergm_r.h"
+
+// Hamiltonian Monte Carlo for a compiled model (see
+// gergm/hamiltonian_monte_carlo.h), returning the same list as
+// GERGM_Model_MH_Sampler, with the step size after adaptation as its
+// "step_size" attribute.
+
+using namespace Rcpp;
+
+// Takes the arguments of GERGM_Model_MH_Sampler, with the step size,
+// leapfrog steps, number of adaptation iterations and target acceptance
+// probability of HMC in place of the proposal variance and parallel. Like
+// the Metropolis Hastings sampler it runs in the background and an interrupt
+// cancels it.
+// [[Rcpp::export]]
+List GERGM_Model_HMC_Sampler(SEXP model,
+                             int number_of_iterations,
+                             double step_size,
+                             int leapfrog_steps,
+                             int adapt_iterations,
+                             double target_acceptance,
+                             arma::mat initial_network,
+                             int take_sample_every,
+                             arma::vec thetas,
+                             int seed,
+                             int number_of_samples_to_store,
+                             int network_storage = 0,
+                             std::string sample_file = "",
+                             Rcpp::CharacterVector statistic_names =
+                               Rcpp::CharacterVector::create(),
+                             int first_sample = 0) {
+
+  gergm::check_network_storage(network_storage);
+  gergm::SampleFileInfo sample_file_info;
+  sample_file_info.first_sample = first_sample;
+  sample_file_info.statistic_names =
+    Rcpp::as<std::vector<std::string> >(statistic_names);
+  sample_file_info.thetas = Rcpp::as<std::vector<double> >(Rcpp::wrap(thetas));
+  Rcpp::XPtr<gergm::GergmModel> compiled_model(model);
+  const gergm::GergmModel& sampler_model = *compiled_model;
+  gergm::AsyncMetropolisHastings run(
+    sampler_model,
+    [&sampler_model, number_of_iterations, step_size, leapfrog_steps,
+     adapt_iterations, target_acceptance, initial_network, take_sample_every,
+     thetas, seed, number_of_samples_to_store, network_storage](
+       gergm::SamplerControl* control,
+       gergm::MetropolisHastingsOutput& output) {
+      gergm::run_hamiltonian_monte_carlo(sampler_model,
+                                         number_of_iterations,
+                                         step_size,
+                                         leapfrog_steps,
+                                         adapt_iterations,
+                                         target_acceptance,
+                                         initial_network,
+                                         take_sample_every,
+                                         thetas,
+                                         seed,
+                                         number_of_samples_to_store,
+                                         true,
+                                         network_storage,
+                                         control,
+                                         output);
+    });
+  gergm::wait_checking_interrupts(run);
+  const gergm::MetropolisHastingsOutput& output = run.result();
+  List to_return = gergm::metropolis_hastings_output_to_r(sampler_model,
+                                                          output,
+                                                          sample_file,
+                                                          sample_file_info);
+  to_return.attr("step_size") = output.step_size;
+  return to_return;
+}
+
+// theta' h(network) and its gradient with respect to the logits of the edge
+// values, one entry per edge value (see gergm/statistic_gradients.h).
+// [[Rcpp::export]]
+List H_Function_Logit_Gradient(SEXP model,
+                               arma::mat network,
+                               arma::vec thetas) {
+  Rcpp::XPtr<gergm::GergmModel> compiled_model(model);
+  arma::mat gradient;
+  double value = gergm::h_function_logit_gradient(*compiled_model, thetas,
+                                                  network, gradient);
+  return List::create(Named("value") = value,
+                      Named("gradient") = gradient);
+}
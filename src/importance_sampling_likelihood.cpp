@@ -0,0 +1,121 @@
+// [[Rcpp::depends(RcppArmadillo)]]
+
+#include <RcppArmadillo.h>
+#include <gergm/importance_sampling.h>
+
+using namespace Rcpp;
+
+
+// [[Rcpp::export]]
+SEXP Create_Importance_Sampling_Likelihood (arma::mat simulated_statistics,
+                                            arma::vec observed_statistics,
+                                            arma::vec ltheta) {
+  if (simulated_statistics.n_cols != observed_statistics.n_elem ||
+      simulated_statistics.n_cols != ltheta.n_elem) {
+    Rcpp::stop("The simulated statistics must have one column per observed statistic and theta.");
+  }
+  if (simulated_statistics.n_rows == 0) {
+    Rcpp::stop("At least one set of simulated statistics is required.");
+  }
+  gergm::ImportanceSamplingLikelihood* likelihood =
+    new gergm::ImportanceSamplingLikelihood;
+  likelihood->simulated_statistics = simulated_statistics;
+  likelihood->observed_statistics = observed_statistics;
+  likelihood->ltheta = ltheta;
+  return Rcpp::XPtr<gergm::ImportanceSamplingLikelihood>(likelihood, true);
+}
+
+
+// Log likelihood, gradient and (optionally) Hessian at theta.
+// [[Rcpp::export]]
+List Importance_Sampling_Log_Likelihood (SEXP likelihood,
+                                         arma::vec theta,
+                                         bool calculate_hessian) {
+  Rcpp::XPtr<gergm::ImportanceSamplingLikelihood> objective(likelihood);
+  arma::vec gradient;
+  arma::mat hessian;
+  double value = 0;
+  if (calculate_hessian) {
+    value = objective->evaluate(theta, &gradient, &hessian);
+  } else {
+    value = objective->evaluate(theta, &gradient, NULL);
+  }
+  return List::create(Named("value") = value,
+                      Named("gradient") = gradient,
+                      Named("hessian") = hessian);
+}
+
+
+// Maximize the log likelihood with damped Newton steps. The likelihood is
+// concave, but the Hessian is singular whenever the simulated statistics are
+// (close to) collinear, so each step solves (mu I - H) step = gradient and the
+// damping mu is increased until the step improves the likelihood, and reduced
+// again after each successful step. Returns the same par, value, hessian and
+// convergence (0 on success) elements that optim() does.
+// [[Rcpp::export]]
+List Importance_Sampling_Newton (SEXP likelihood,
+                                 arma::vec theta,
+                                 int max_iterations,
+                                 double tolerance,
+                                 bool verbose) {
+  Rcpp::XPtr<gergm::ImportanceSamplingLikelihood> objective(likelihood);
+  int number_of_thetas = theta.n_elem;
+  arma::mat identity = arma::eye(number_of_thetas, number_of_thetas);
+  arma::vec gradient;
+  arma::mat hessian;
+  double value = objective->evaluate(theta, &gradient, &hessian);
+  double damping = 0;
+  int iterations = 0;
+  int convergence = 1;
+
+  while (iterations < max_iterations) {
+    if (arma::abs(gradient).max() < tolerance) {
+      convergence = 0;
+      break;
+    }
+    iterations += 1;
+
+    // scale the damping to the curvature so it is independent of the units
+    // the statistics are measured in
+    double scale = std::max(arma::abs(hessian.diag()).max(), 1e-12);
+    bool improved = false;
+    for (int attempt = 0; attempt < 60; ++attempt) {
+      arma::vec step;
+      bool solved = arma::solve(step, damping * scale * identity - hessian,
+                                gradient);
+      if (solved && step.is_finite()) {
+        arma::vec proposal = theta + step;
+        double proposal_value = objective->evaluate(proposal, NULL, NULL);
+        if (std::isfinite(proposal_value) && proposal_value >= value) {
+          theta = proposal;
+          improved = true;
+          break;
+        }
+      }
+      damping = std::max(damping * 10, 1e-8);
+    }
+    if (!improved) {
+      // no step improves the likelihood, we are at the maximum to within
+      // numerical precision
+      convergence = 0;
+      break;
+    }
+    damping = damping / 10;
+    if (damping < 1e-8) {
+      damping = 0;
+    }
+    value = objective->evaluate(theta, &gradient, &hessian);
+    if (verbose) {
+      Rcpp::Rcout << "Newton iteration " << iterations << ": log likelihood "
+                  << value << ", max |gradient| "
+                  << arma::abs(gradient).max() << std::endl;
+    }
+  }
+
+  return List::create(Named("par") = theta,
+                      Named("value") = value,
+                      Named("gradient") = gradient,
+                      Named("hessian") = hessian,
+                      Named("iterations") = iterations,
+                      Named("convergence") = convergence);
+}
@@ -0,0 +1,45 @@
+// [[Rcpp::depends(RcppArmadillo)]]
+// [[Rcpp::depends(RcppParallel)]]
+
+#include "gergm_r.h"
+
+// Access to networks kept in a gergm_network_samples raw vector (see
+// gergm/sample_storage.h and R/network_samples.R).
+
+using namespace Rcpp;
+
+// Decode the (0 based) samples into an n x n x length(samples) array.
+// [[Rcpp::export]]
+NumericVector Decode_Network_Samples(RawVector samples,
+                                     arma::uvec sample_indices) {
+
+  gergm::NetworkSampleArchiveView archive =
+    gergm::archive_view_from_r(samples);
+  IntegerVector network_dim = samples.attr("network_dim");
+  return gergm::decode_network_samples(
+    archive,
+    sample_indices,
+    network_dim[0],
+    as<bool>(samples.attr("packed")),
+    as<bool>(samples.attr("include_diagonal")));
+}
+
+// Keep only the (0 based) samples, still encoded.
+// [[Rcpp::export]]
+RawVector Select_Network_Samples(RawVector samples,
+                                 arma::uvec sample_indices) {
+
+  gergm::NetworkSampleArchive archive = gergm::archive_from_r(samples);
+  IntegerVector network_dim = samples.attr("network_dim");
+  std::vector<std::size_t> selected(sample_indices.n_elem);
+  for (arma::uword s = 0; s < sample_indices.n_elem; ++s) {
+    if (sample_indices[s] >= archive.number_of_samples()) {
+      Rcpp::stop("Network sample index out of range.");
+    }
+    selected[s] = sample_indices[s];
+  }
+  return gergm::archive_to_r(archive.select(selected),
+                             network_dim[0],
+                             as<bool>(samples.attr("packed")),
+                             as<bool>(samples.attr("include_diagonal")));
+}
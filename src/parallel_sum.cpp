@@ -0,0 +1,19 @@
+// [[Rcpp::depends(RcppArmadillo)]]
+// [[Rcpp::depends(RcppParallel)]]
+
+#include "gergm_r.h"
+
+// The sum of values over gergm::parallel_sum(), in chunks of chunk_size
+// values. The result only depends on values and chunk_size, not on the number
+// of threads set with RcppParallel::setThreadOptions().
+// [[Rcpp::export]]
+double Parallel_Sum(arma::vec values, int chunk_size) {
+  if (chunk_size < 1) {
+    Rcpp::stop("chunk_size must be at least 1.");
+  }
+  const double* value = values.memptr();
+  return gergm::parallel_sum(0, values.n_elem, chunk_size,
+                             [value](std::size_t i) {
+    return value[i];
+  });
+}
@@ -0,0 +1,64 @@
+// [[Rcpp::depends(RcppArmadillo)]]
+// [[Rcpp::depends(RcppParallel)]]
+
+#include "gergm_r.h"
+
+// Reading sample files (see gergm/sample_file.h and R/sample_file.R). An open
+// file is an external pointer, which does not survive saving and reloading,
+// in which case the file is opened again.
+
+using namespace Rcpp;
+
+// [[Rcpp::export]]
+SEXP Open_Sample_File(std::string path) {
+  gergm::SampleFile* file = new gergm::SampleFile(path);
+  return Rcpp::XPtr<gergm::SampleFile>(file, true);
+}
+
+// [[Rcpp::export]]
+bool Sample_File_Is_Open(SEXP file) {
+  if (TYPEOF(file) != EXTPTRSXP) {
+    return false;
+  }
+  return R_ExternalPtrAddr(file) != NULL;
+}
+
+// Everything but the networks. Samples are rows of statistics, and
+// first_sample is 0 based.
+// [[Rcpp::export]]
+List Sample_File_Info(SEXP file) {
+  Rcpp::XPtr<gergm::SampleFile> sample_file(file);
+  const gergm::SampleFileInfo& info = sample_file->info();
+  std::size_t number_of_samples = sample_file->number_of_samples();
+  std::size_t number_of_statistics = sample_file->number_of_statistics();
+  NumericMatrix statistics(number_of_samples, number_of_statistics);
+  for (std::size_t k = 0; k < number_of_statistics; ++k) {
+    for (std::size_t s = 0; s < number_of_samples; ++s) {
+      statistics(s, k) = sample_file->statistic(s, k);
+    }
+  }
+  return List::create(
+    Named("number_of_nodes") = info.number_of_nodes,
+    Named("number_of_samples") = int(number_of_samples),
+    Named("first_sample") = int(info.first_sample),
+    Named("directed") = info.directed,
+    Named("include_diagonal") = info.include_diagonal,
+    Named("correlation") = info.correlation,
+    Named("network_storage") = sample_file->network_storage(),
+    Named("statistic_names") = wrap(info.statistic_names),
+    Named("thetas") = wrap(info.thetas),
+    Named("statistics") = statistics);
+}
+
+// Decode the (0 based) samples into an n x n x length(samples) array.
+// [[Rcpp::export]]
+NumericVector Sample_File_Networks(SEXP file,
+                                   arma::uvec sample_indices) {
+  Rcpp::XPtr<gergm::SampleFile> sample_file(file);
+  const gergm::SampleFileInfo& info = sample_file->info();
+  return gergm::decode_network_samples(sample_file->networks(),
+                                       sample_indices,
+                                       info.number_of_nodes,
+                                       info.packed,
+                                       info.include_diagonal);
+}